@@ -0,0 +1,557 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/arena.h"
+#include "../include/behavior_scheduler.h"
+#include "../include/combat_rules.h"
+#include "../include/combat_visitor.h"
+#include "../include/factory.h"
+#include "../include/fight_system.h"
+#include "../include/metrics.h"
+#include "../include/movement.h"
+#include "../include/nearest_kernel.h"
+#include "../include/observer.h"
+#include "../include/renderer.h"
+#include "../include/runtime_config.h"
+#include "../include/sharded_world.h"
+#include "../include/sim_engine.h"
+#include "../include/thread_pool.h"
+
+#ifndef BENCH_BUILD_TYPE
+#define BENCH_BUILD_TYPE "unknown"
+#endif
+
+// Замеры горячих путей симуляции.
+//   benchmarks [--counts 50,1000,...] [--repeats N] [--seed S] [--filter substr]
+//              [--max-quadratic N] [--json file|-]
+// Для каждого числа NPC карта растёт так, чтобы плотность была как в обычной игре
+// (50 NPC на 100x100). Проходы O(n^2) пропускаются при count > max-quadratic,
+// проходы под набор инструкций, которого нет у процессора, - всегда.
+namespace {
+constexpr std::uint64_t DEFAULT_SEED = 42;
+
+struct Options {
+    std::vector<std::size_t> counts{50, 1000, 10000, 100000, 1000000};
+    int repeats{3};
+    std::uint64_t seed{DEFAULT_SEED};
+    std::size_t max_quadratic{20000};
+    std::string filter;
+    std::string json_path;
+};
+
+struct Timing {
+    double best_ms{0.0};
+    double mean_ms{0.0};
+};
+
+struct Result {
+    std::string name;
+    std::size_t count{0};
+    Timing timing;
+    bool skipped{false};
+    const char* skip_reason{""};
+};
+
+class NullObserver : public Observer {
+public:
+    void update(const std::string&) override {}
+};
+
+// Глушит std::cout на время замера (Arena::fight печатает итог раунда)
+class SilenceCout {
+public:
+    SilenceCout() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+    ~SilenceCout() { std::cout.rdbuf(saved); }
+
+private:
+    std::ostringstream sink;
+    std::streambuf* saved;
+};
+
+// Конфигурация с картой под count NPC при плотности обычной игры
+RuntimeConfig config_for(std::size_t count) {
+    RuntimeConfig config;
+    const double area_per_npc = static_cast<double>(GameConfig::MAP_WIDTH) * GameConfig::MAP_HEIGHT /
+                                static_cast<double>(GameConfig::INITIAL_NPC_COUNT);
+    const int side = static_cast<int>(std::ceil(std::sqrt(area_per_npc * static_cast<double>(count))));
+    config.map_width = std::max(GameConfig::MAP_WIDTH, side);
+    config.map_height = std::max(GameConfig::MAP_HEIGHT, side);
+    config.npc_count = count;
+    return config;
+}
+
+std::vector<NpcSpec> make_spawns(std::size_t count, const RuntimeConfig& config, std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> x_dist(0, config.map_width - 1);
+    std::uniform_int_distribution<int> y_dist(0, config.map_height - 1);
+    std::uniform_int_distribution<int> type_dist(1, 3);
+    std::vector<NpcSpec> spawns;
+    spawns.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto type = static_cast<NpcType>(type_dist(rng));
+        const int x = x_dist(rng);
+        const int y = y_dist(rng);
+        spawns.push_back(NpcSpec{type, "npc_" + std::to_string(i), x, y});
+    }
+    return spawns;
+}
+
+void fill_arena(Arena& arena, const std::vector<NpcSpec>& spawns) {
+    arena.spawn(spawns);
+}
+
+// setup не входит в замер
+Timing measure(int repeats, const std::function<void()>& setup, const std::function<void()>& fn) {
+    Timing t;
+    t.best_ms = 1e300;
+    double total = 0.0;
+    for (int i = 0; i < repeats; ++i) {
+        if (setup) setup();
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        t.best_ms = std::min(t.best_ms, ms);
+        total += ms;
+    }
+    t.mean_ms = total / std::max(1, repeats);
+    return t;
+}
+
+// Общие данные одного размера: конфигурация, расстановка и заполненная арена
+struct Fixture {
+    RuntimeConfig config;
+    std::vector<NpcSpec> spawns;
+    std::unique_ptr<Arena> arena;
+};
+
+Timing bench_arena_fight(Fixture& f, int repeats, WorkStealingPool* pool) {
+    // fight() удаляет убитых, поэтому каждый повтор - на свежей арене
+    std::unique_ptr<Arena> arena;
+    return measure(
+        repeats,
+        [&]() {
+            arena = std::make_unique<Arena>();
+            fill_arena(*arena, f.spawns);
+        },
+        [&]() {
+            SilenceCout silence;
+            arena->fight(GameConfig::ORK_KILL_DISTANCE, pool);
+        });
+}
+
+// NEAREST_QUERIES запросов полным перебором всех NPC; время на NPC - на один запрос
+constexpr int NEAREST_QUERIES = 16;
+
+Timing bench_nearest_scan(Fixture& f, int repeats, NearestKernel::Isa isa) {
+    const WorldStore& world = f.arena->world();
+    std::vector<std::int32_t> xs(world.size()), ys(world.size());
+    std::vector<std::uint8_t> types(world.size(), NearestKernel::NO_TYPE);
+    world.for_each_alive([&](WorldStore::Id id) {
+        xs[id] = world.x(id);
+        ys[id] = world.y(id);
+        types[id] = static_cast<std::uint8_t>(world.type(id));
+    });
+
+    std::size_t found = 0;
+    Timing t = measure(repeats, nullptr, [&]() {
+        for (int q = 0; q < NEAREST_QUERIES; ++q) {
+            const int x = (q * 7919) % f.config.map_width;
+            const int y = (q * 104729) % f.config.map_height;
+            const auto prey = CombatRules::prey_mask_for(static_cast<NpcType>(1 + q % 3));
+            found += NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), xs.size(), x, y, prey) !=
+                     NearestKernel::npos;
+        }
+    });
+    if (found == 0 && xs.size() > 100) std::cerr << "Error: nearest scan found nothing" << std::endl;
+    t.best_ms /= NEAREST_QUERIES;
+    t.mean_ms /= NEAREST_QUERIES;
+    return t;
+}
+
+using BenchFn = std::function<Timing(Fixture&, int repeats)>;
+
+struct Benchmark {
+    const char* name;
+    bool quadratic;
+    BenchFn run;
+    bool (*available)() = nullptr; // nullptr - доступен всегда
+};
+
+std::vector<Benchmark> make_benchmarks() {
+    return {
+        {"factory_create_npc", false,
+         [](Fixture& f, int repeats) {
+             std::vector<std::shared_ptr<NPC>> out;
+             return measure(
+                 repeats, [&]() { out.clear(); out.reserve(f.spawns.size()); },
+                 [&]() {
+                     for (const auto& s : f.spawns) out.push_back(Factory::CreateNPC(s.type, s.name, s.x, s.y));
+                 });
+         }},
+        {"factory_create_npc_pooled", false,
+         [](Fixture& f, int repeats) {
+             // Пул общий на все повторы, как у арены при повторной загрузке: ячейки переиспользуются
+             std::vector<std::shared_ptr<NPC>> out;
+             auto pool = std::make_shared<NpcPool>();
+             return measure(
+                 repeats, [&]() { out.clear(); out.reserve(f.spawns.size()); },
+                 [&]() {
+                     for (const auto& s : f.spawns) out.push_back(Factory::CreateNPC(s.type, s.name, s.x, s.y, pool));
+                 });
+         }},
+        {"arena_spawn", false,
+         [](Fixture& f, int repeats) {
+             std::unique_ptr<Arena> arena;
+             return measure(
+                 repeats, [&]() { arena = std::make_unique<Arena>(); }, [&]() { arena->spawn(f.spawns); });
+         }},
+        {"movement_step_in_place", false,
+         [](Fixture& f, int repeats) {
+             MovementSystem movement(f.config);
+             return measure(repeats, nullptr, [&]() { movement.step_in_place(f.arena->world()); });
+         }},
+        {"movement_step_buffered", false,
+         [](Fixture& f, int repeats) {
+             MovementSystem movement(f.config);
+             return measure(repeats, nullptr, [&]() { movement.step_buffered(f.arena->world()); });
+         }},
+        {"movement_step_churned", false,
+         [](Fixture& f, int repeats) {
+             // 90% убиты и не освобождены: проход пропускает мёртвых по битовой маске живости
+             Arena arena;
+             fill_arena(arena, f.spawns);
+             WorldStore& world = arena.world();
+             for (WorldStore::Id id = 0; id < world.size(); ++id) {
+                 if (id % 10 != 0) world.kill(id);
+             }
+             MovementSystem movement(f.config);
+             return measure(repeats, nullptr, [&]() { movement.step_in_place(world); });
+         }},
+        {"behavior_tick", false,
+         [](Fixture& f, int repeats) {
+             // Такт сопрограмм на отдельной арене (бои убивают NPC); первый такт будит всех
+             Arena arena;
+             fill_arena(arena, f.spawns);
+             BehaviorScheduler scheduler(arena, f.config, DEFAULT_SEED);
+             scheduler.spawn_all(hunt);
+             scheduler.tick();
+             return measure(repeats, nullptr, [&]() { scheduler.tick(); });
+         }},
+        {"sharded_tick_1", false,
+         [](Fixture& f, int repeats) {
+             // Полный такт (движение и бои) одной полосой - база для sharded_tick_4
+             Arena arena;
+             fill_arena(arena, f.spawns);
+             ShardedWorld world(arena, f.config, 1, 0, DEFAULT_SEED);
+             return measure(repeats, nullptr, [&]() { world.tick(); });
+         }},
+        {"sharded_tick_4", false,
+         [](Fixture& f, int repeats) {
+             Arena arena;
+             fill_arena(arena, f.spawns);
+             ShardedWorld world(arena, f.config, 4, 0, DEFAULT_SEED);
+             return measure(repeats, nullptr, [&]() { world.tick(); });
+         }},
+        {"sim_headless_3s", false,
+         [](Fixture& f, int repeats) {
+             // 3 секунды игры (15 тактов) на виртуальных часах без пауз, с расстановки
+             RuntimeConfig config = f.config;
+             config.duration_seconds = 3;
+             std::unique_ptr<Arena> arena;
+             return measure(
+                 repeats,
+                 [&]() {
+                     arena = std::make_unique<Arena>();
+                     fill_arena(*arena, f.spawns);
+                 },
+                 [&]() {
+                     SimEngine engine(*arena, config, DEFAULT_SEED);
+                     engine.run(SimEngine::Pacing::Headless);
+                 });
+         }},
+        {"sim_headless_3s_metrics", false,
+         [](Fixture& f, int repeats) {
+             // То же, что sim_headless_3s, но с метриками арены - цена включённых метрик
+             RuntimeConfig config = f.config;
+             config.duration_seconds = 3;
+             MetricsRegistry registry;
+             std::unique_ptr<Arena> arena;
+             return measure(
+                 repeats,
+                 [&]() {
+                     arena = std::make_unique<Arena>();
+                     arena->set_metrics(&registry);
+                     fill_arena(*arena, f.spawns);
+                 },
+                 [&]() {
+                     SimEngine engine(*arena, config, DEFAULT_SEED);
+                     engine.run(SimEngine::Pacing::Headless);
+                 });
+         }},
+        {"metrics_observe", false,
+         [](Fixture& f, int repeats) {
+             // По одной записи в гистограмму на NPC: цена observe на горячем пути
+             MetricHistogram histogram(MetricHistogram::NANOSECONDS);
+             return measure(repeats, nullptr, [&]() {
+                 for (std::size_t i = 0; i < f.spawns.size(); ++i) histogram.observe(i * 37);
+             });
+         }},
+        {"movement_step_scan", true,
+         [](Fixture& f, int repeats) {
+             MovementSystem movement(f.config, MovementSystem::Search::Scan);
+             return measure(repeats, nullptr, [&]() { movement.step_in_place(f.arena->world()); });
+         }},
+        {"nearest_scan_scalar", false,
+         [](Fixture& f, int repeats) { return bench_nearest_scan(f, repeats, NearestKernel::Isa::Scalar); }},
+        {"nearest_scan_avx2", false,
+         [](Fixture& f, int repeats) { return bench_nearest_scan(f, repeats, NearestKernel::Isa::Avx2); },
+         []() { return NearestKernel::supported(NearestKernel::Isa::Avx2); }},
+        {"fight_scan", false,
+         [](Fixture& f, int repeats) {
+             std::vector<FightTask> batch;
+             return measure(repeats, nullptr, [&]() { collect_fights(f.arena->world(), f.config, batch); });
+         }},
+        {"render_map", false,
+         [](Fixture& f, int repeats) {
+             std::size_t bytes = 0;
+             auto t = measure(repeats, nullptr, [&]() { bytes += render_map(f.arena->world(), 0, f.config).size(); });
+             if (bytes == 0) std::cerr << "Error: empty frame" << std::endl;
+             return t;
+         }},
+        {"frame_publish", false,
+         [](Fixture& f, int repeats) {
+             std::uint64_t tick = 0;
+             return measure(repeats, nullptr, [&]() { f.arena->publish_frame(++tick); });
+         }},
+        {"render_map_frame", false,
+         [](Fixture& f, int repeats) {
+             f.arena->publish_frame(0);
+             std::size_t bytes = 0;
+             auto t = measure(repeats, nullptr,
+                              [&]() { bytes += render_map(*f.arena->frame(), 0, f.config).size(); });
+             if (bytes == 0) std::cerr << "Error: empty frame" << std::endl;
+             return t;
+         }},
+        {"render_diff", false,
+         [](Fixture& f, int repeats) {
+             // Кадр после одного тика движения относительно предыдущего
+             DiffRenderer renderer(f.config);
+             MovementSystem movement(f.config);
+             renderer.render(f.arena->world(), 0);
+             std::size_t bytes = 0;
+             auto t = measure(
+                 repeats, [&]() { movement.step_in_place(f.arena->world()); },
+                 [&]() { bytes += renderer.render(f.arena->world(), 0).size(); });
+             if (bytes == 0) std::cerr << "Error: empty frame" << std::endl;
+             return t;
+         }},
+        {"arena_fight", false,
+         [](Fixture& f, int repeats) { return bench_arena_fight(f, repeats, nullptr); }},
+        {"arena_fight_parallel", false,
+         [](Fixture& f, int repeats) {
+             WorkStealingPool pool;
+             return bench_arena_fight(f, repeats, &pool);
+         }},
+        {"can_kill_visitor", false,
+         [](Fixture& f, int repeats) {
+             const auto npcs = f.arena->npcs_snapshot();
+             std::size_t kills = 0;
+             auto t = measure(repeats, nullptr, [&]() {
+                 for (std::size_t i = 0; i < npcs.size(); ++i) {
+                     CombatVisitor v(npcs[(i * 7919) % npcs.size()]);
+                     npcs[i]->accept(v);
+                     kills += v.is_success() ? 1 : 0;
+                 }
+             });
+             if (kills == 0 && npcs.size() > 100) std::cerr << "Error: no kills in can_kill_visitor" << std::endl;
+             return t;
+         }},
+        {"can_kill_table", false,
+         [](Fixture& f, int repeats) {
+             const WorldStore& world = f.arena->world();
+             const std::size_t n = world.size();
+             std::size_t kills = 0;
+             auto t = measure(repeats, nullptr, [&]() {
+                 for (WorldStore::Id i = 0; i < n; ++i) {
+                     const auto d = static_cast<WorldStore::Id>((i * 7919ull) % n);
+                     kills += CombatRules::can_kill(world.type(i), world.type(d)) ? 1 : 0;
+                 }
+             });
+             if (kills == 0 && n > 100) std::cerr << "Error: no kills in can_kill_table" << std::endl;
+             return t;
+         }},
+        {"arena_save_text", false,
+         [](Fixture& f, int repeats) {
+             auto t = measure(repeats, nullptr, [&]() { f.arena->save("bench_arena.txt"); });
+             std::filesystem::remove("bench_arena.txt");
+             return t;
+         }},
+        {"arena_load_text", false,
+         [](Fixture& f, int repeats) {
+             f.arena->save("bench_arena.txt");
+             auto obs = std::make_shared<NullObserver>();
+             std::unique_ptr<Arena> loaded;
+             auto t = measure(
+                 repeats, [&]() { loaded = std::make_unique<Arena>(); },
+                 [&]() { loaded->load("bench_arena.txt", obs, obs); });
+             std::filesystem::remove("bench_arena.txt");
+             return t;
+         }},
+        {"arena_load_fast", false,
+         [](Fixture& f, int repeats) {
+             f.arena->save("bench_arena.txt");
+             auto obs = std::make_shared<NullObserver>();
+             std::unique_ptr<Arena> loaded;
+             auto t = measure(
+                 repeats, [&]() { loaded = std::make_unique<Arena>(); },
+                 [&]() { loaded->load_fast("bench_arena.txt", obs, obs); });
+             std::filesystem::remove("bench_arena.txt");
+             return t;
+         }},
+        {"arena_save_binary", false,
+         [](Fixture& f, int repeats) {
+             auto t = measure(repeats, nullptr, [&]() { f.arena->save_binary("bench_arena.bin"); });
+             std::filesystem::remove("bench_arena.bin");
+             return t;
+         }},
+        {"arena_load_binary", false,
+         [](Fixture& f, int repeats) {
+             f.arena->save_binary("bench_arena.bin");
+             auto obs = std::make_shared<NullObserver>();
+             std::unique_ptr<Arena> loaded;
+             auto t = measure(
+                 repeats, [&]() { loaded = std::make_unique<Arena>(); },
+                 [&]() { loaded->load_binary("bench_arena.bin", obs, obs); });
+             std::filesystem::remove("bench_arena.bin");
+             return t;
+         }},
+    };
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Error: missing value for " << arg << std::endl;
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--counts") {
+            options.counts.clear();
+            std::stringstream ss(value);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                if (!item.empty()) options.counts.push_back(std::strtoull(item.c_str(), nullptr, 10));
+            }
+        } else if (arg == "--repeats") {
+            options.repeats = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--max-quadratic") {
+            options.max_quadratic = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--json") {
+            options.json_path = value;
+        } else {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void write_json(std::ostream& out, const Options& options, const std::vector<Result>& results) {
+    out << "{\n"
+        << "  \"suite\": \"npc_arena\",\n"
+        << "  \"build_type\": \"" << BENCH_BUILD_TYPE << "\",\n"
+        << "  \"seed\": " << options.seed << ",\n"
+        << "  \"repeats\": " << options.repeats << ",\n"
+        << "  \"results\": [\n";
+    out << std::setprecision(6) << std::fixed;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"count\": " << r.count;
+        if (r.skipped) {
+            out << ", \"skipped\": true, \"reason\": \"" << r.skip_reason << "\"}";
+        } else {
+            const double per_item_ns = r.count > 0 ? r.timing.best_ms * 1e6 / static_cast<double>(r.count) : 0.0;
+            out << ", \"best_ms\": " << r.timing.best_ms << ", \"mean_ms\": " << r.timing.mean_ms
+                << ", \"ns_per_npc\": " << per_item_ns << "}";
+        }
+        out << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+
+    const RuntimeConfig saved = RuntimeConfig::current();
+    const auto benchmarks = make_benchmarks();
+    std::vector<Result> results;
+
+    for (const std::size_t count : options.counts) {
+        Fixture fixture;
+        fixture.config = config_for(count);
+        // Арены, созданные без config, берут границы карты из активной конфигурации
+        RuntimeConfig::set_current(fixture.config);
+        fixture.spawns = make_spawns(count, fixture.config, options.seed);
+
+        for (const auto& bench : benchmarks) {
+            if (!options.filter.empty() && std::string_view(bench.name).find(options.filter) == std::string_view::npos) {
+                continue;
+            }
+            Result result{bench.name, count, {}, false, ""};
+            if (bench.available && !bench.available()) {
+                result.skipped = true;
+                result.skip_reason = "unsupported by this CPU";
+            } else if (bench.quadratic && count > options.max_quadratic) {
+                result.skipped = true;
+                result.skip_reason = "O(n^2)";
+            } else {
+                // Каждый замер - на арене из одной и той же расстановки
+                fixture.arena = std::make_unique<Arena>();
+                fill_arena(*fixture.arena, fixture.spawns);
+                result.timing = bench.run(fixture, options.repeats);
+            }
+            results.push_back(result);
+
+            std::cerr << std::left << std::setw(24) << result.name << std::right << std::setw(9) << count;
+            if (result.skipped) {
+                std::cerr << "   skipped (" << result.skip_reason << ")\n";
+            } else {
+                std::cerr << std::fixed << std::setprecision(3) << std::setw(14) << result.timing.best_ms
+                          << " ms best" << std::setw(14) << result.timing.mean_ms << " ms mean\n";
+            }
+        }
+    }
+    RuntimeConfig::set_current(saved);
+
+    if (options.json_path.empty() || options.json_path == "-") {
+        write_json(std::cout, options, results);
+    } else {
+        std::ofstream out(options.json_path);
+        if (!out.is_open()) {
+            std::cerr << "Error: Could not open " << options.json_path << std::endl;
+            return 1;
+        }
+        write_json(out, options, results);
+    }
+    return 0;
+}
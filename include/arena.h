@@ -3,27 +3,126 @@
 #include <memory>
 #include <string>
 #include <shared_mutex>
+#include "event_bus.h"
+#include "factory.h"
+#include "metrics.h"
 #include "npc.h"
+#include "name_table.h"
+#include "npc_pool.h"
 #include "observer.h"
+#include "text_loader.h"
+#include "thread_pool.h"
+#include "world_frame.h"
+#include "world_store.h"
 
 class Arena {
 private:
+    // Границы карты для создания и загрузки NPC и для fight
+    RuntimeConfig cfg;
     std::vector<std::shared_ptr<NPC>> npcs;
+    // Плотное состояние NPC; by_id[id] - объект-представление записи id
+    WorldStore world_store;
+    std::vector<std::shared_ptr<NPC>> by_id;
     mutable std::shared_mutex npcs_mutex;
+    // Память под NPC, которых создаёт сама арена (spawn и загрузки)
+    std::shared_ptr<NpcPool> npc_pool = std::make_shared<NpcPool>();
+    // Имена NPC арены (WorldStore::name - id в этой таблице); при перезагрузке заменяется новой
+    std::shared_ptr<NameTable> name_table = std::make_shared<NameTable>();
+    // Подписчики на события арены (убийства, появление NPC, итоги тиков)
+    EventBus bus;
+    // Кадры для читателей, публикуемые симуляцией (publish_frame)
+    FrameExchange frame_exchange;
+
+    // Метрики арены в чужом реестре (set_metrics); пусто - не собираются
+    struct Instruments {
+        MetricCounter* added{nullptr};
+        MetricCounter* kills{nullptr};
+        MetricCounter* reclaimed{nullptr};
+        MetricGauge* alive{nullptr};
+        MetricHistogram* frame_publish{nullptr};
+        MetricHistogram* reclaim{nullptr};
+    };
+    Instruments instruments;
 
 public:
-    Arena() = default;
+    explicit Arena(const RuntimeConfig& config = RuntimeConfig::current()) : cfg(config) {}
+    ~Arena();
     
     // Добавление NPC
     void add_npc(std::shared_ptr<NPC> npc);
+    // Пакетное добавление под одной блокировкой
+    void add_npcs(const std::vector<std::shared_ptr<NPC>>& batch);
+    // Создание пачки NPC в пуле арены (Factory::CreateNPCs) и добавление под одной блокировкой
+    std::vector<std::shared_ptr<NPC>> spawn(const std::vector<NpcSpec>& specs);
+
+    // События арены; SpawnEvent публикуется при любом добавлении NPC, если на него подписаны
+    EventBus& events() { return bus; }
+    const EventBus& events() const { return bus; }
+    // Таблица имён для событий
+    std::shared_ptr<const NameTable> names() const;
+
+    // Пул, из которого арена создаёт NPC; можно передавать в Factory::CreateNPC
+    const std::shared_ptr<NpcPool>& pool() const { return npc_pool; }
+    const RuntimeConfig& config() const { return cfg; }
 
     // Потокобезопасный снимок списка NPC
     std::vector<std::shared_ptr<NPC>> npcs_snapshot() const;
+
+    // Снимок мира в out (память векторов переиспользуется)
+    void capture_frame(WorldFrame& out, std::uint64_t tick = 0) const;
+    // Снимок в очередной кадр обмена; вызывает один поток - тот, что двигает NPC
+    void publish_frame(std::uint64_t tick);
+    // Последний опубликованный кадр; чтение без блокировок арены
+    std::shared_ptr<const WorldFrame> frame() const { return frame_exchange.latest(); }
+
+    // Метрики арены: добавленные, убитые и освобождённые NPC, живые в последнем кадре,
+    // время publish_frame и reclaim_dead. nullptr - выключить. Вызывать до запуска
+    // потоков симуляции; registry должен жить, пока арена им пользуется.
+    void set_metrics(MetricsRegistry* registry);
+    // Учёт убийств для resolve_fight и других мест, где гибнут NPC
+    void count_kills(std::size_t n) {
+        if (instruments.kills) instruments.kills->add(n);
+    }
+
+    // Хранилище для горячих проходов симуляции
+    WorldStore& world() { return world_store; }
+    const WorldStore& world() const { return world_store; }
+    // NPC по id записи в хранилище (nullptr для свободного слота)
+    std::shared_ptr<NPC> npc(WorldStore::Id id) const;
+
+    // Освобождение слотов убитых NPC: объект отвязывается от хранилища и удаляется из арены,
+    // слот уходит в список свободных WorldStore. Возвращает число освобождённых слотов.
+    // Безопасно параллельно с FightSystem (устаревшие задачи отбрасываются по поколению);
+    // занимать освободившиеся слоты (add_npc) можно только когда очереди боёв пусты.
+    std::size_t reclaim_dead();
     
+    // Без кадра сохраняется свежий снимок (capture_frame)
     void save(const std::string& filename);
+    static void save(const std::string& filename, const WorldFrame& frame);
     void load(const std::string& filename, std::shared_ptr<Observer> file_obs, std::shared_ptr<Observer> console_obs);
+
+    // Быстрая загрузка текстового формата: mmap + параллельный разбор кусков файла.
+    // Некорректные строки пропускаются, их номера печатаются в std::cerr и возвращаются.
+    std::vector<LoadError> load_fast(const std::string& filename, std::shared_ptr<Observer> file_obs,
+                                     std::shared_ptr<Observer> console_obs, WorkStealingPool* pool = nullptr);
+
+    // Бинарный снимок (формат в snapshot_format.h), загрузка через mmap
+    void save_binary(const std::string& filename);
+    static void save_binary(const std::string& filename, const WorldFrame& frame);
+    void load_binary(const std::string& filename, std::shared_ptr<Observer> file_obs, std::shared_ptr<Observer> console_obs);
     
     void print();
     
-    void fight(int distance);
+    // Раунд боя: каждый атакующий бьёт всех, кого может убить, в радиусе distance.
+    // Кандидаты ищутся по сетке бакетов; с pool атакующие обрабатываются параллельно,
+    // уведомления всё равно идут в порядке атакующих. Убитые удаляются одним проходом.
+    void fight(int distance, WorkStealingPool* pool = nullptr);
+
+private:
+    WorldStore::Id add_npc_locked(const std::shared_ptr<NPC>& npc);
+    void publish_spawns(const std::vector<WorldStore::Id>& ids, const std::shared_ptr<const NameTable>& table);
+    // Наблюдатели, переданные в load*, подписываются на убийства (повторно не дублируются)
+    void subscribe_loggers(const std::shared_ptr<Observer>& file_obs, const std::shared_ptr<Observer>& console_obs);
+    void clear_locked();
+    void replace_all(const std::vector<std::shared_ptr<NPC>>& loaded);
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "game_config.h"
+#include "kill_event.h"
+#include "metrics.h"
+
+struct AsyncSinkOptions {
+    // Сколько строк может ждать записи
+    std::size_t queue_capacity = GameConfig::LOG_QUEUE_CAPACITY;
+    // Буфер сбрасывается, когда набралось столько байт...
+    std::size_t flush_bytes = GameConfig::LOG_FLUSH_BYTES;
+    // ...или прошло столько времени с прошлого сброса
+    std::chrono::milliseconds flush_interval{GameConfig::LOG_FLUSH_INTERVAL_MS};
+    // true - строки сверх queue_capacity отбрасываются, false - submit ждёт места
+    bool drop_when_full = GameConfig::LOG_DROP_WHEN_FULL;
+    // Добавляется перед каждой строкой в фоновом потоке
+    std::string line_prefix;
+};
+
+// Асинхронный буферизованный вывод строк.
+// submit() только кладёт строку в ограниченную очередь; фоновый поток собирает
+// строки в большой буфер и отдаёт его в write() целиком.
+// Очередь - заранее выделенное кольцо, поэтому submit(KillEvent) не выделяет память:
+// событие превращается в текст уже в фоновом потоке.
+class AsyncSink {
+public:
+    using WriteFn = std::function<void(const std::string& chunk)>;
+
+    explicit AsyncSink(WriteFn write, AsyncSinkOptions options = {});
+    // Дописывает всё, что было принято, и останавливает поток
+    ~AsyncSink();
+
+    AsyncSink(const AsyncSink&) = delete;
+    AsyncSink& operator=(const AsyncSink&) = delete;
+
+    // false - строка отброшена (очередь полна и drop_when_full)
+    bool submit(std::string line);
+    bool submit(const KillEvent& event);
+    // Блокирует, пока всё принятое ранее не будет записано
+    void flush();
+
+    std::size_t dropped() const;
+
+    // Метрики с меткой sink="<sink>": принятые и отброшенные строки, глубина очереди,
+    // время одного write(). nullptr - выключить; реестр должен жить, пока приёмник им пользуется.
+    void set_metrics(MetricsRegistry* registry, const std::string& sink);
+
+private:
+    struct Instruments {
+        MetricCounter* lines{nullptr};
+        MetricCounter* dropped{nullptr};
+        MetricGauge* queue_depth{nullptr};
+        MetricHistogram* write_time{nullptr};
+    };
+
+    struct Record {
+        std::string text;
+        KillEvent event;
+        bool is_event{false};
+    };
+
+    // Ждёт место в кольце (или отбрасывает запись); true - слот ring[tail()] можно заполнять
+    bool acquire_slot(std::unique_lock<std::mutex>& lock);
+    // Публикует заполненный слот; true - писателя пора будить
+    bool commit_slot();
+    std::size_t tail() const { return (head + queued) % ring.size(); }
+    void writer_loop();
+
+    WriteFn write;
+    AsyncSinkOptions options;
+
+    mutable std::mutex mutex;
+    std::condition_variable has_work;
+    std::condition_variable has_space;
+    std::condition_variable written_cv;
+    std::vector<Record> ring;
+    std::size_t head{0};
+    std::size_t queued{0};
+    std::uint64_t submitted{0};
+    std::uint64_t written{0};
+    std::uint64_t flush_requested{0};
+    std::size_t dropped_count{0};
+    bool stopping{false};
+    Instruments instruments; // под mutex
+
+    std::thread writer;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "combat_rules.h"
+#include "runtime_config.h"
+
+// Итог одной безголовой арены
+struct ArenaOutcome {
+    std::size_t survivors[CombatRules::TYPE_COUNT]{}; // живые по NpcType
+    std::size_t kills[CombatRules::TYPE_COUNT]{};     // убийства по типу атакующего
+    std::size_t ticks{0};                             // сколько тиков прошло
+    bool settled{false}; // бои закончились: ни у одного живого типа не осталось живой добычи
+};
+
+// Сводка по пачке арен
+struct BatchSummary {
+    std::size_t arenas{0};
+    std::size_t npc_per_arena{0};
+    std::size_t max_ticks{0};
+    std::uint64_t seed{0};
+
+    std::size_t survivors[CombatRules::TYPE_COUNT]{}; // сумма живых по типам
+    std::size_t kills[CombatRules::TYPE_COUNT]{};
+    std::size_t survived_in[CombatRules::TYPE_COUNT]{}; // в скольких аренах тип не вымер
+    std::size_t sole_survivor_in[CombatRules::TYPE_COUNT]{}; // в скольких аренах выжил только этот тип
+
+    std::size_t settled{0};
+    std::size_t settle_ticks_total{0}; // по аренам, где бои закончились
+    std::size_t settle_ticks_min{0};
+    std::size_t settle_ticks_max{0};
+
+    double wall_seconds{0.0};
+};
+
+// Пакетный прогон независимых арен без отрисовки и без пауз между тиками.
+// Арены раздаются потокам WorkStealingPool; арена i использует seed + i,
+// поэтому результат не зависит от числа потоков.
+// Границы карты и дистанции берутся из config, а не из активной конфигурации.
+class BatchRunner {
+public:
+    explicit BatchRunner(const RuntimeConfig& config = RuntimeConfig::current());
+
+    // Одна арена: случайная расстановка npc_count NPC, затем до max_ticks тиков
+    // "движение -> все бои тика", пока бои не закончатся
+    ArenaOutcome run_arena(std::uint64_t seed) const;
+
+    BatchSummary run(std::size_t arenas, std::uint64_t seed, std::size_t threads = 0) const;
+
+    std::size_t max_ticks() const { return ticks_limit; }
+
+private:
+    RuntimeConfig config;
+    std::size_t ticks_limit;
+};
+
+void print_summary(std::ostream& out, const BatchSummary& summary);
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "arena.h"
+#include "counter_rng.h"
+#include "fight_system.h"
+#include "runtime_config.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+#include "world_store.h"
+
+class BehaviorScheduler;
+
+// Поведение NPC - сопрограмма. Она выполняется только в тот такт, когда дождалась
+// своего: следующего такта, паузы, подхода цели или исхода боя. Спящие NPC
+// в такте не стоят ничего, кроме снимка позиций.
+class Behavior {
+public:
+    struct promise_type {
+        enum class Wait {
+            Sleep,   // ticks тактов
+            InRange, // target подойдёт на distance или пропадёт
+            Fight    // исход боя с target
+        };
+
+        WorldStore::Handle self;
+        Wait wait{Wait::Sleep};
+        std::uint64_t ticks{1};
+        WorldStore::Handle target;
+        int distance{0};
+        // Результаты ожидания, которые вернёт co_await
+        bool in_range{false};
+        FightResult fight_result{FightResult::Invalid};
+
+        Behavior get_return_object() { return Behavior(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        // Первый шаг - в ближайшем такте планировщика
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Behavior() = default;
+    explicit Behavior(Handle h) : handle(h) {}
+    Behavior(Behavior&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Behavior& operator=(Behavior&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    Behavior(const Behavior&) = delete;
+    Behavior& operator=(const Behavior&) = delete;
+    ~Behavior() { reset(); }
+
+    explicit operator bool() const { return static_cast<bool>(handle); }
+    promise_type& promise() const { return handle.promise(); }
+    bool done() const { return handle.done(); }
+    void resume() const { handle.resume(); }
+    void reset() {
+        if (handle) handle.destroy();
+        handle = {};
+    }
+
+private:
+    Handle handle;
+};
+
+// Ожидания для co_await внутри Behavior. Сопрограмма только записывает, чего ждёт,
+// в свой promise; разбирает записи планировщик после шага, в одном потоке.
+namespace BehaviorAwait {
+struct Sleep {
+    std::uint64_t ticks;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Behavior::Handle h) const noexcept {
+        h.promise().wait = Behavior::promise_type::Wait::Sleep;
+        h.promise().ticks = ticks > 0 ? ticks : 1;
+    }
+    void await_resume() const noexcept {}
+};
+
+struct InRange {
+    WorldStore::Handle target;
+    int distance;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Behavior::Handle h) noexcept {
+        promise = &h.promise();
+        promise->wait = Behavior::promise_type::Wait::InRange;
+        promise->target = target;
+        promise->distance = distance;
+    }
+    // false - цель погибла или её слот освобождён
+    bool await_resume() const noexcept { return promise->in_range; }
+    Behavior::promise_type* promise{nullptr};
+};
+
+struct Fight {
+    WorldStore::Handle target;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Behavior::Handle h) noexcept {
+        promise = &h.promise();
+        promise->wait = Behavior::promise_type::Wait::Fight;
+        promise->target = target;
+    }
+    FightResult await_resume() const noexcept { return promise->fight_result; }
+    Behavior::promise_type* promise{nullptr};
+};
+} // namespace BehaviorAwait
+
+inline BehaviorAwait::Sleep next_tick() { return {1}; }
+inline BehaviorAwait::Sleep sleep_ticks(std::uint64_t ticks) { return {ticks}; }
+inline BehaviorAwait::InRange wait_in_range(WorldStore::Handle target, int distance) { return {target, distance}; }
+inline BehaviorAwait::Fight fight(WorldStore::Handle target) { return {target}; }
+
+// Итог одного такта планировщика
+struct BehaviorTickStats {
+    std::size_t resumed{0};  // сопрограмм, сделавших шаг
+    std::size_t moved{0};    // NPC, сменивших клетку
+    std::size_t fights{0};
+    std::size_t kills{0};
+    std::size_t finished{0}; // завершены или сняты (NPC погиб)
+};
+
+// Планировщик поведений на тактах симуляции.
+//
+// Такт: проснувшиеся по таймеру и дождавшиеся цели сопрограммы делают шаг
+// (параллельно на пуле, если он передан), затем в одном потоке разбираются их
+// ожидания и разрешаются бои (resolve_fight, броски CounterRng). Шаг читает позиции
+// из снимка начала такта, поэтому результат не зависит от числа потоков.
+// Сопрограммы погибших NPC уничтожаются, не просыпаясь.
+class BehaviorScheduler {
+public:
+    using Factory = std::function<Behavior(BehaviorScheduler&, WorldStore::Handle)>;
+
+    BehaviorScheduler(Arena& arena, const RuntimeConfig& config, std::uint64_t seed = GameConfig::SEED);
+    BehaviorScheduler(const BehaviorScheduler&) = delete;
+    BehaviorScheduler& operator=(const BehaviorScheduler&) = delete;
+
+    // Поведение для NPC id; первый шаг - в следующем такте
+    void spawn(WorldStore::Id id, const Factory& factory);
+    // Поведение для каждого живого NPC арены
+    void spawn_all(const Factory& factory);
+
+    BehaviorTickStats tick(WorkStealingPool* pool = nullptr);
+
+    std::uint64_t now() const { return current_tick; }
+    // Живые сопрограммы и сколько из них спит / ждёт цель
+    std::size_t active() const { return behaviors.size() - free_slots.size(); }
+    std::size_t sleeping() const { return timers.size(); }
+    std::size_t waiting() const { return range_waiters.size(); }
+
+    // Для поведений: мир, параметры и позиции начала такта
+    const WorldStore& world() const { return arena.world(); }
+    const RuntimeConfig& config() const { return cfg; }
+    int x(WorldStore::Id id) const { return pos_x[id]; }
+    int y(WorldStore::Id id) const { return pos_y[id]; }
+    // Ближайший живой из type_mask по позициям начала такта (SpatialGrid::npos - никого)
+    std::size_t nearest(WorldStore::Id self, unsigned type_mask) const;
+    // Новая позиция NPC; вызывается только из его собственного поведения
+    void move(WorldStore::Id self, int new_x, int new_y);
+
+private:
+    struct Timer {
+        std::uint64_t tick;
+        std::uint64_t seq; // порядок постановки - для одинакового порядка пробуждения
+        std::size_t slot;
+        bool operator>(const Timer& other) const {
+            return tick != other.tick ? tick > other.tick : seq > other.seq;
+        }
+    };
+
+    bool owner_alive(std::size_t slot) const;
+    void retire(std::size_t slot);
+    void schedule(std::size_t slot, std::uint64_t ticks);
+    void snapshot_positions();
+
+    Arena& arena;
+    RuntimeConfig cfg;
+    CounterRng rng;
+    SpatialGrid grid;
+
+    std::vector<Behavior> behaviors;
+    std::vector<std::size_t> free_slots;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::vector<std::size_t> range_waiters;
+    std::vector<std::size_t> ready;
+    std::uint64_t current_tick{0};
+    std::uint64_t timer_seq{0};
+
+    std::vector<int> pos_x;
+    std::vector<int> pos_y;
+    std::atomic<std::size_t> moved{0};
+};
+
+// Поведение по умолчанию - то же, что проход MovementSystem, но без лишних шагов:
+// идти к ближайшей добыче (или к кому угодно), в радиусе удара - драться.
+// Если идти некуда или шаг ничего не меняет, NPC засыпает с удвоением паузы
+// (до GameConfig::BEHAVIOR_MAX_SLEEP_TICKS) или ждёт, пока добыча подойдёт сама.
+Behavior hunt(BehaviorScheduler& scheduler, WorldStore::Handle self);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "combat_visitor.h"
+#include "npc.h"
+
+// Быстрые правила боя по типам для горячих проходов симуляции.
+// Таблица убийств считается на этапе компиляции из тех же правил CombatLogic,
+// что и CombatVisitor; Visitor остаётся точкой расширения для новых типов.
+namespace CombatRules {
+inline constexpr int TYPE_COUNT = 4;
+
+inline constexpr unsigned type_bit(NpcType type) { return 1u << static_cast<unsigned>(type); }
+inline constexpr unsigned ALL_TYPES = (1u << TYPE_COUNT) - 1u;
+
+// То же ветвление по атакующему, что и двойная диспетчеризация CombatVisitor
+constexpr bool rule(NpcType attacker, NpcType defender) {
+    switch (attacker) {
+        case OrkType: return CombatLogic::ork_kills(defender);
+        case WillianType: return CombatLogic::willian_kills(defender);
+        case WerewolfType: return CombatLogic::werewolf_kills(defender);
+        default: return false;
+    }
+}
+
+struct KillMatrix {
+    unsigned prey[TYPE_COUNT]{}; // prey[attacker] - маска типов, которых он убивает
+};
+
+constexpr KillMatrix make_kill_matrix() {
+    KillMatrix m{};
+    for (int a = 0; a < TYPE_COUNT; ++a) {
+        for (int d = 0; d < TYPE_COUNT; ++d) {
+            if (rule(static_cast<NpcType>(a), static_cast<NpcType>(d))) {
+                m.prey[a] |= type_bit(static_cast<NpcType>(d));
+            }
+        }
+    }
+    return m;
+}
+
+inline constexpr KillMatrix KILL_MATRIX = make_kill_matrix();
+
+// Маска типов, которых может убить NPC типа attacker
+constexpr unsigned prey_mask_for(NpcType attacker) {
+    const int t = static_cast<int>(attacker);
+    return (t >= 0 && t < TYPE_COUNT) ? KILL_MATRIX.prey[t] : 0u;
+}
+
+constexpr bool can_kill(NpcType attacker, NpcType defender) {
+    return (prey_mask_for(attacker) & type_bit(defender)) != 0;
+}
+
+constexpr bool matrix_agrees_with_rules() {
+    for (int a = 0; a < TYPE_COUNT; ++a) {
+        for (int d = 0; d < TYPE_COUNT; ++d) {
+            if (can_kill(static_cast<NpcType>(a), static_cast<NpcType>(d)) !=
+                rule(static_cast<NpcType>(a), static_cast<NpcType>(d))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(matrix_agrees_with_rules(), "Kill matrix disagrees with CombatLogic rules");
+static_assert(can_kill(OrkType, WillianType) && can_kill(WillianType, WerewolfType) &&
+                  can_kill(WerewolfType, WillianType),
+              "Kill matrix lost a rule from the assignment table");
+static_assert(!can_kill(OrkType, OrkType) && !can_kill(WerewolfType, OrkType) && !can_kill(WillianType, OrkType),
+              "Kill matrix has a kill that is not in the assignment table");
+} // namespace CombatRules
@@ -3,6 +3,17 @@
 #include "npc.h"
 #include <memory>
 
+// Правила боя: кого может убить атакующий каждого типа.
+// Их использует и CombatVisitor, и таблица CombatRules, так что правила задаются в одном месте.
+namespace CombatLogic {
+// Орк убивает разбойника
+constexpr bool ork_kills(NpcType defender) { return defender == WillianType; }
+// Разбойник убивает оборотней
+constexpr bool willian_kills(NpcType defender) { return defender == WerewolfType; }
+// Оборотень убивает разбойника
+constexpr bool werewolf_kills(NpcType defender) { return defender == WillianType; }
+} // namespace CombatLogic
+
 class CombatVisitor : public Visitor {
     std::shared_ptr<NPC> defender;
     bool success;
@@ -22,4 +33,4 @@ public:
     
     // Оборотень атакует
     void visit(Werewolf& attacker) override;
-};
\ No newline at end of file
+};
@@ -1,13 +1,36 @@
 #pragma once
 #include "observer.h"
+#include "async_sink.h"
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include "output.h"
 
+// Лог в консоль: строки собираются в пачку и печатаются одним блоком под cout_mutex
 class ConsoleObserver : public Observer {
+    std::unique_ptr<AsyncSink> sink;
+
+    static AsyncSinkOptions with_prefix(AsyncSinkOptions options) {
+        options.line_prefix = "[Console Log]: ";
+        return options;
+    }
 public:
+    explicit ConsoleObserver(AsyncSinkOptions options = {})
+        : sink(std::make_unique<AsyncSink>([](const std::string& chunk) {
+              std::lock_guard<std::mutex> lock(Output::cout_mutex);
+              std::cout << chunk << std::flush;
+          }, with_prefix(std::move(options)))) {}
+
     void update(const std::string& message) override {
-        std::lock_guard<std::mutex> lock(Output::cout_mutex);
-        std::cout << "[Console Log]: " << message << std::endl;
+        sink->submit(message);
+    }
+    void on_kill(const KillEvent& event) override {
+        sink->submit(event);
+    }
+    void flush() override {
+        sink->flush();
+    }
+    void set_metrics(MetricsRegistry* registry) override {
+        sink->set_metrics(registry, "console");
     }
-};
\ No newline at end of file
+};
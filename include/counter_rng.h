@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+// Счётчиковый генератор: число - чистая функция от зерна и набора счётчиков
+// (поток, такт, id атакующего и защищающегося...). Состояния нет, поэтому
+// бросок не зависит от того, какой поток и в каком порядке его делает.
+// Перемешивание - финализатор SplitMix64, применяемый к каждому слову ключа.
+class CounterRng {
+public:
+    // Независимые последовательности для разных подсистем
+    enum Stream : std::uint64_t {
+        Spawn = 1,
+        Fight = 2,
+    };
+
+    explicit CounterRng(std::uint64_t seed = 0) : seed_(seed) {}
+
+    std::uint64_t seed() const { return seed_; }
+
+    std::uint64_t at(std::uint64_t stream, std::uint64_t a, std::uint64_t b = 0, std::uint64_t c = 0,
+                     std::uint64_t d = 0) const {
+        std::uint64_t h = mix(seed_ ^ 0x9e3779b97f4a7c15ull);
+        h = mix(h ^ stream);
+        h = mix(h ^ a);
+        h = mix(h ^ b);
+        h = mix(h ^ c);
+        return mix(h ^ d);
+    }
+
+    // Целое в [lo, hi]; умножение со сдвигом вместо деления по модулю
+    int uniform(int lo, int hi, std::uint64_t stream, std::uint64_t a, std::uint64_t b = 0, std::uint64_t c = 0,
+                std::uint64_t d = 0) const {
+        const std::uint64_t span = static_cast<std::uint64_t>(static_cast<std::int64_t>(hi) - lo + 1);
+        const std::uint64_t r = at(stream, a, b, c, d) >> 32;
+        return lo + static_cast<int>((r * span) >> 32);
+    }
+
+    // Бросок d6 боя; roll - 0 для атаки, 1 для защиты
+    int d6(std::uint64_t tick, std::uint64_t attacker, std::uint64_t defender, std::uint64_t roll) const {
+        return uniform(1, 6, Fight, tick, attacker, defender, roll);
+    }
+
+private:
+    static std::uint64_t mix(std::uint64_t z) {
+        z += 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    std::uint64_t seed_;
+};
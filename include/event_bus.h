@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+#include "combat_rules.h"
+#include "events.h"
+#include "observer.h"
+
+// Прямоугольник карты [x, x + width) x [y, y + height)
+struct MapRegion {
+    int x{0};
+    int y{0};
+    int width{0};
+    int height{0};
+
+    bool contains(int px, int py) const { return px >= x && px < x + width && py >= y && py < y + height; }
+    bool operator==(const MapRegion& o) const {
+        return x == o.x && y == o.y && width == o.width && height == o.height;
+    }
+};
+
+// Что получает подписчик. factions - маска CombatRules::type_bit: убийство проходит,
+// если в маске тип атакующего или защищающегося. Регион проверяется по клетке
+// защищающегося (убийство) или появления (spawn); итоги тика от региона не зависят.
+struct EventFilter {
+    unsigned events = ALL_EVENTS;
+    unsigned factions = CombatRules::ALL_TYPES;
+    bool has_region = false;
+    MapRegion region;
+
+    static EventFilter only(EventType type);
+    EventFilter& in_region(const MapRegion& r);
+    EventFilter& for_factions(unsigned mask);
+
+    bool accepts(const KillEvent& e) const;
+    bool accepts(const SpawnEvent& e) const;
+    bool accepts(const MoveSummaryEvent& e) const;
+
+    bool operator==(const EventFilter& o) const {
+        return events == o.events && factions == o.factions && has_region == o.has_region &&
+               (!has_region || region == o.region);
+    }
+};
+
+// Шина событий арены: подписки с фильтрами вместо наблюдателей у каждого NPC.
+// Публикующий код сначала спрашивает wants(type): событие, на которое никто
+// не подписан, даже не собирается. publish() вызывает наблюдателей в своём потоке
+// под разделяемой блокировкой - подписываться из обработчика нельзя.
+class EventBus {
+public:
+    using SubscriptionId = std::uint32_t;
+
+    // Повторная подписка того же наблюдателя с тем же фильтром возвращает прежний id
+    SubscriptionId subscribe(std::shared_ptr<Observer> observer, EventFilter filter = {});
+    void unsubscribe(SubscriptionId id);
+    std::size_t subscriptions() const;
+
+    bool wants(EventType type) const {
+        return (subscribed_events.load(std::memory_order_acquire) & event_bit(type)) != 0;
+    }
+
+    void publish(const KillEvent& event) const;
+    void publish(const SpawnEvent& event) const;
+    void publish(const MoveSummaryEvent& event) const;
+
+    // flush() всех подписчиков
+    void flush() const;
+
+private:
+    struct Subscription {
+        SubscriptionId id;
+        std::shared_ptr<Observer> observer;
+        EventFilter filter;
+    };
+
+    void update_mask();
+
+    mutable std::shared_mutex mutex;
+    std::vector<Subscription> subs;
+    SubscriptionId next_id{1};
+    std::atomic<unsigned> subscribed_events{0};
+};
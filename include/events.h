@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "kill_event.h"
+#include "name_table.h"
+#include "npc.h"
+
+// Типы событий арены - биты маски подписки EventBus
+enum class EventType : unsigned {
+    Kill = 1u << 0,
+    Spawn = 1u << 1,
+    MoveSummary = 1u << 2,
+};
+
+constexpr unsigned event_bit(EventType type) { return static_cast<unsigned>(type); }
+inline constexpr unsigned ALL_EVENTS =
+    event_bit(EventType::Kill) | event_bit(EventType::Spawn) | event_bit(EventType::MoveSummary);
+
+// NPC появился на арене (добавление, spawn, загрузка)
+struct SpawnEvent {
+    std::shared_ptr<const NameTable> names;
+    NameTable::Id name{0};
+    NpcType type{Unknown};
+    int x{0};
+    int y{0};
+
+    // "<name> spawned at (x, y)"
+    void append_to(std::string& out) const;
+    std::string to_string() const;
+};
+
+// Итог одного тика движения
+struct MoveSummaryEvent {
+    std::uint64_t tick{0};
+    std::size_t moved{0};
+
+    // "tick N: M NPC moved"
+    void append_to(std::string& out) const;
+    std::string to_string() const;
+};
@@ -1,10 +1,42 @@
 #pragma once
 #include <memory>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "npc.h"
+#include "npc_pool.h"
+#include "runtime_config.h"
+
+// Параметры одного NPC для пакетного создания
+struct NpcSpec {
+    NpcType type{Unknown};
+    std::string name;
+    int x{0};
+    int y{0};
+};
 
 class Factory {
 public:
-    static std::shared_ptr<NPC> CreateNPC(const std::string& type, const std::string& name, int x, int y);
-    static std::shared_ptr<NPC> CreateNPC(std::istream& is);
+    // Тип по имени ("Ork"/"ork", ...); Unknown, если имя не распознано
+    static NpcType ParseType(std::string_view type);
+    // Имя типа в формате сохранения ("Ork", ...); "Unknown" для Unknown
+    static const char* TypeName(NpcType type);
+
+    // С pool объект размещается в пуле арены (Arena::pool), без него - через make_shared.
+    // Координаты проверяются по границам карты config
+    static std::shared_ptr<NPC> CreateNPC(const std::string& type, const std::string& name, int x, int y,
+                                          const std::shared_ptr<NpcPool>& pool = nullptr,
+                                          const RuntimeConfig& config = RuntimeConfig::current());
+    static std::shared_ptr<NPC> CreateNPC(NpcType type, const std::string& name, int x, int y,
+                                          const std::shared_ptr<NpcPool>& pool = nullptr,
+                                          const RuntimeConfig& config = RuntimeConfig::current());
+    static std::shared_ptr<NPC> CreateNPC(std::istream& is, const std::shared_ptr<NpcPool>& pool = nullptr,
+                                          const RuntimeConfig& config = RuntimeConfig::current());
+
+    // Пакетное создание: сначала проверяются все записи (исключение - до создания первого NPC),
+    // затем объекты создаются подряд, чтобы лечь в пуле рядом
+    static std::vector<std::shared_ptr<NPC>> CreateNPCs(const std::vector<NpcSpec>& specs,
+                                                        const std::shared_ptr<NpcPool>& pool = nullptr,
+                                                        const RuntimeConfig& config = RuntimeConfig::current());
 };
\ No newline at end of file
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "arena.h"
+#include "counter_rng.h"
+#include "metrics.h"
+#include "mpmc_queue.h"
+#include "runtime_config.h"
+#include "world_store.h"
+
+// Бой между записями WorldStore (id атакующего и защищающегося).
+// Поколения слотов на момент постановки: если слот успели освободить
+// (Arena::reclaim_dead), задача отбрасывается и не задевает нового владельца.
+// Такт вместе с id участников - ключ бросков CounterRng.
+struct FightTask {
+    WorldStore::Id attacker{0};
+    WorldStore::Id defender{0};
+    std::uint32_t attacker_generation{0};
+    std::uint32_t defender_generation{0};
+    std::uint64_t tick{0};
+    std::uint64_t enqueued_ns{0}; // steady_clock при постановке, 0 - не замерялось (метрики выключены)
+};
+
+// Пары: живой атакующий, живой защищающийся в пределах дистанции удара атакующего
+// (config.kill_distance) и по таблице CombatRules. Кандидаты ищутся по SpatialGrid;
+// порядок - по id атакующего, затем защищающегося. batch очищается.
+void collect_fights(const WorldStore& world, const RuntimeConfig& config, std::vector<FightTask>& batch,
+                    std::uint64_t tick = 0);
+
+// Исход одного боя
+enum class FightResult {
+    Killed,   // защищающийся убит
+    Survived, // бросок атакующего не больше броска защиты
+    Invalid   // слот освобождён, кто-то уже мёртв или тип не может убить
+};
+
+// Бой по правилам FightSystem: проверка поколений и живости, CombatRules, броски d6 из rng
+// по (task.tick, атакующий, защищающийся); при убийстве - KillEvent в шину арены, если на него подписаны.
+// Защищающегося не должны одновременно разрешать два потока.
+// attacker_must_be_alive == false - бои такта одновременны: атакующий, убитый в том же такте
+// (в другом потоке), всё равно бьёт, и исход не зависит от порядка потоков (ShardedWorld).
+FightResult resolve_fight(Arena& arena, const CounterRng& rng, const FightTask& task,
+                          bool attacker_must_be_alive = true);
+
+// Статистика одного обработчика боёв
+struct FightWorkerStats {
+    std::size_t processed{0};
+    std::size_t kills{0};
+    double busy_seconds{0.0};
+};
+
+// Счётчики очередей боёв
+struct FightQueueStats {
+    std::size_t enqueued{0};
+    std::size_t deduplicated{0}; // атакующий ещё не дождался прошлых боёв
+    std::size_t overflows{0};    // сколько раз очередь оказалась полной
+    std::size_t dropped{0};      // отброшено из-за переполнения (политика Drop)
+};
+
+// Что делать, если очередь шарда полна
+enum class FullQueuePolicy {
+    Drop,  // отбросить бой и учесть его в dropped
+    Block  // ждать, пока обработчик освободит место
+};
+
+// Разрешение боёв несколькими потоками.
+// Задачи раскладываются по шардам по id защищающегося, у каждого шарда своя
+// lock-free очередь и свой поток, поэтому kill() одного и того же NPC никогда
+// не выполняется из двух потоков.
+//
+// Дедупликация без аллокаций: пока у атакующего есть бои в очередях
+// (fights_in_flight), новые бои для него не ставятся. Все бои одной пачки
+// enqueue() помечаются общим поколением (fight_stamp), так что внутри пачки
+// атакующий может получить несколько целей. Ставить задачи должен один поток.
+//
+// Броски d6 считаются CounterRng от (seed, такт, атакующий, защищающийся),
+// так что исход боя не зависит от числа обработчиков и порядка их работы.
+class FightSystem {
+public:
+    FightSystem(Arena& arena, std::size_t workers, std::size_t queue_capacity = 1u << 16,
+                FullQueuePolicy policy = FullQueuePolicy::Block, std::uint64_t seed = GameConfig::SEED);
+    ~FightSystem();
+
+    FightSystem(const FightSystem&) = delete;
+    FightSystem& operator=(const FightSystem&) = delete;
+
+    std::size_t worker_count() const { return shards.size(); }
+
+    // Пакетная постановка задач. Возвращает число реально поставленных задач.
+    std::size_t enqueue(const std::vector<FightTask>& batch);
+    bool enqueue(WorldStore::Id attacker, WorldStore::Id defender);
+
+    // Задержка от постановки до начала боя и глубина очередей после каждой пачки.
+    // Вызывать до start(); реестр должен жить дольше системы
+    void set_metrics(MetricsRegistry* registry);
+
+    // Запуск потоков; задачи, поставленные до start(), тоже будут обработаны
+    void start();
+    // Дожидается, пока все поставленные задачи будут обработаны
+    void wait_idle();
+    // Останавливает потоки, дождавшись обработки уже поставленных задач
+    void stop();
+
+    std::vector<FightWorkerStats> stats() const;
+    FightQueueStats queue_stats() const;
+
+private:
+    struct Shard {
+        explicit Shard(std::size_t capacity) : queue(capacity) {}
+
+        MpmcQueue<FightTask> queue;
+        std::atomic<bool> busy{false};
+
+        // Сон обработчика при пустой очереди
+        std::mutex sleep_mutex;
+        std::condition_variable sleep_cv;
+        std::atomic<int> sleepers{0};
+
+        std::atomic<std::size_t> processed{0};
+        std::atomic<std::size_t> kills{0};
+        std::atomic<std::int64_t> busy_ns{0};
+    };
+
+    std::size_t shard_of(WorldStore::Id defender) const { return defender % shards.size(); }
+    bool accept(WorldStore::Id attacker, std::uint32_t generation);
+    bool push(const FightTask& task);
+    void wake(Shard& shard);
+    void worker_loop(std::size_t index);
+    void resolve(Shard& shard, const FightTask& task);
+
+    Arena& arena;
+    FullQueuePolicy policy;
+    CounterRng rng;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping{false};
+    std::uint32_t generation{0};
+
+    struct Instruments {
+        MetricHistogram* lag{nullptr};
+        MetricHistogram* depth{nullptr};
+        MetricGauge* queued{nullptr};
+    } instruments;
+
+    std::atomic<std::size_t> enqueued{0};
+    std::atomic<std::size_t> deduplicated{0};
+    std::atomic<std::size_t> overflows{0};
+    std::atomic<std::size_t> dropped{0};
+};
@@ -1,19 +1,39 @@
 #pragma once
 #include "observer.h"
+#include "async_sink.h"
 #include <fstream>
 #include <iostream>
+#include <memory>
 
+// Лог в файл: файл открыт всё время работы, записи уходят пачками из фонового потока
 class FileObserver : public Observer {
     std::string filename;
+    std::ofstream fs;
+    std::unique_ptr<AsyncSink> sink;
 public:
-    FileObserver(const std::string& fname) : filename(fname) {
-        std::ofstream fs(filename, std::ios::trunc);
-        fs.close();
+    FileObserver(const std::string& fname, AsyncSinkOptions options = {})
+        : filename(fname), fs(fname, std::ios::trunc) {
+        sink = std::make_unique<AsyncSink>([this](const std::string& chunk) {
+            if (fs.is_open()) {
+                fs.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                fs.flush();
+            }
+        }, std::move(options));
+    }
+    ~FileObserver() override {
+        // Поток записи должен завершиться раньше, чем закроется файл
+        sink.reset();
     }
     void update(const std::string& message) override {
-        std::ofstream fs(filename, std::ios::app);
-        if (fs.is_open()) {
-            fs << message << std::endl;
-        }
+        sink->submit(message);
+    }
+    void on_kill(const KillEvent& event) override {
+        sink->submit(event);
+    }
+    void flush() override {
+        sink->flush();
+    }
+    void set_metrics(MetricsRegistry* registry) override {
+        sink->set_metrics(registry, "file");
     }
-};
\ No newline at end of file
+};
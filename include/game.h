@@ -1,19 +1,42 @@
 #pragma once
 
 #include "arena.h"
+#include "metrics.h"
 #include "observer.h"
+#include "runtime_config.h"
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
 class Game {
 public:
-    Game(Arena& arena, std::shared_ptr<Observer> file_observer, std::shared_ptr<Observer> console_observer);
+    // Параметры мира копируются при создании; по умолчанию - активная конфигурация процесса.
+    // Наблюдатели подписываются на убийства в шине событий арены.
+    Game(Arena& arena, std::shared_ptr<Observer> file_observer, std::shared_ptr<Observer> console_observer,
+         const RuntimeConfig& config = RuntimeConfig::current());
+    // Отключает арену и наблюдателей от своего реестра метрик
+    ~Game();
+    Game(const Game&) = delete;
+    Game& operator=(const Game&) = delete;
+
+    // Зерно запуска: config.seed или случайное, если оно 0
+    std::uint64_t seed() const { return config_.seed; }
 
     void init_random_npcs(std::size_t count);
+    // Потоки движения и боёв на настенных часах; с virtual_time или headless - SimEngine
     void run();
 
 private:
+    void run_virtual();
+    // Печать живых из последнего опубликованного кадра
+    void print_survivors() const;
+    // Последний сброс метрик в файл и сводка в консоль (config.metrics)
+    void report_metrics();
+
     Arena& arena_;
     std::shared_ptr<Observer> file_observer_;
     std::shared_ptr<Observer> console_observer_;
+    RuntimeConfig config_;
+    // Есть только с config.metrics
+    std::unique_ptr<MetricsRegistry> metrics_;
 };
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
+// Compile-time defaults; runtime overrides live in RuntimeConfig (runtime_config.h)
 namespace GameConfig {
 // Map size (0..WIDTH-1, 0..HEIGHT-1)
 inline constexpr int MAP_WIDTH = 100;
@@ -12,6 +14,75 @@ inline constexpr int GAME_DURATION_SECONDS = 30;
 inline constexpr int RENDER_PERIOD_MS = 1000;
 inline constexpr int MOVEMENT_TICK_MS = 200;
 
+// Frame size limit in characters; larger maps are downsampled to fit
+inline constexpr int RENDER_MAX_COLS = 100;
+inline constexpr int RENDER_MAX_ROWS = 100;
+// Incremental ANSI redraw when stdout is a terminal (full frames otherwise)
+inline constexpr bool RENDER_DIFF = true;
+// Visible part of the map; 0 width/height - up to the map edge
+inline constexpr int VIEWPORT_X = 0;
+inline constexpr int VIEWPORT_Y = 0;
+inline constexpr int VIEWPORT_WIDTH = 0;
+inline constexpr int VIEWPORT_HEIGHT = 0;
+
+// Parallel movement: double-buffered positions, NPC ranges spread over a
+// work-stealing pool sized to hardware concurrency
+inline constexpr bool PARALLEL_MOVEMENT = false;
+// Nearest-target search by brute-force SIMD scan (NearestKernel) instead of the
+// spatial grid; pays off in dense scenes where grid cells hold many NPC
+inline constexpr bool NEAREST_SCAN = false;
+// NPC behavior as coroutines on BehaviorScheduler instead of the movement pass:
+// idle and stuck NPC sleep and cost nothing per tick
+inline constexpr bool BEHAVIOR_COROUTINES = false;
+// Upper bound of the doubling back-off of an idle NPC, ticks
+inline constexpr std::uint64_t BEHAVIOR_MAX_SLEEP_TICKS = 16;
+
+// Discrete-event engine (SimEngine) on a virtual clock instead of the movement
+// and fight threads; headless - no rendering and no real-time pacing, the whole
+// game runs as fast as possible (implies virtual time)
+inline constexpr bool VIRTUAL_TIME = false;
+inline constexpr bool HEADLESS = false;
+
+// Region-sharded world (ShardedWorld): the map is cut into this many vertical
+// strips, each moved and fought over by its own thread; 0 - single movement thread.
+// Ghost zone width - how far past its border a shard sees its neighbours' NPC;
+// 0 - the largest kill/move distance (never less than the largest kill distance)
+inline constexpr std::size_t SHARDS = 0;
+inline constexpr int SHARD_GHOST_WIDTH = 0;
+
+// Fight resolution workers; tasks are sharded by defender id
+inline constexpr std::size_t FIGHT_WORKERS = 1;
+// Per-shard lock-free queue capacity; when full the movement thread either
+// waits for the worker (default) or drops the fight
+inline constexpr std::size_t FIGHT_QUEUE_CAPACITY = std::size_t{1} << 16;
+inline constexpr bool FIGHT_QUEUE_DROP_WHEN_FULL = false;
+// Every N movement ticks dead NPCs release their world store slots
+// (Arena::reclaim_dead); 0 - never
+inline constexpr std::size_t RECLAIM_PERIOD_TICKS = 10;
+
+// Seed for NPC spawns and fight dice (--seed); 0 - pick a random one
+// and print it, so the run can be reproduced
+inline constexpr std::uint64_t SEED = 0;
+
+// Headless batch mode (BatchRunner): 0 arenas - interactive game;
+// 0 ticks - as many as fit into GAME_DURATION_SECONDS; 0 threads - hardware concurrency
+inline constexpr std::size_t BATCH_ARENAS = 0;
+inline constexpr std::size_t BATCH_MAX_TICKS = 0;
+inline constexpr std::uint64_t BATCH_SEED = 1;
+inline constexpr std::size_t BATCH_THREADS = 0;
+
+// Async log sinks (FileObserver / ConsoleObserver)
+inline constexpr std::size_t LOG_QUEUE_CAPACITY = 8192;
+inline constexpr std::size_t LOG_FLUSH_BYTES = 64 * 1024;
+inline constexpr int LOG_FLUSH_INTERVAL_MS = 100;
+inline constexpr bool LOG_DROP_WHEN_FULL = false;
+
+// Runtime metrics (MetricsRegistry): tick/render/fight-lag histograms, queue depths,
+// counters; dumped in Prometheus text format every METRICS_PERIOD_MS and at shutdown
+inline constexpr bool METRICS = false;
+inline constexpr int METRICS_PERIOD_MS = 1000;
+inline constexpr const char* METRICS_FILE = "metrics.prom";
+
 // Movement & kill distances by type (from assignment table)
 inline constexpr int ORK_MOVE_DISTANCE = 20;
 inline constexpr int ORK_KILL_DISTANCE = 10;
@@ -21,4 +92,9 @@ inline constexpr int WILLIAN_KILL_DISTANCE = 10;
 
 inline constexpr int WEREWOLF_MOVE_DISTANCE = 40;
 inline constexpr int WEREWOLF_KILL_DISTANCE = 5;
+
+// Per-type movement period under virtual time, ms; 0 - MOVEMENT_TICK_MS
+inline constexpr int ORK_MOVE_PERIOD_MS = 0;
+inline constexpr int WILLIAN_MOVE_PERIOD_MS = 0;
+inline constexpr int WEREWOLF_MOVE_PERIOD_MS = 0;
 } // namespace GameConfig
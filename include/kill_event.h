@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "name_table.h"
+#include "npc.h"
+
+// Убийство в бою: имена - id в таблице арены, текст собирается только там, где он нужен
+// (в фоновом потоке AsyncSink или в Observer::on_kill по умолчанию).
+// Таблица удерживается событием, поэтому его можно форматировать и после перезагрузки арены.
+struct KillEvent {
+    std::shared_ptr<const NameTable> names;
+    NameTable::Id attacker{0};
+    NameTable::Id defender{0};
+    // Броски d6; 0 - раунд без бросков (Arena::fight)
+    std::uint8_t attack{0};
+    std::uint8_t defense{0};
+    // Для фильтров подписок EventBus: типы участников и клетка защищающегося
+    NpcType attacker_type{Unknown};
+    NpcType defender_type{Unknown};
+    int x{0};
+    int y{0};
+
+    // "<attacker> killed <defender>[ (attack=A, defense=D)]"
+    void append_to(std::string& out) const;
+    std::string to_string() const;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Файл, отображённый в память только для чтения (mmap на POSIX).
+// На других платформах файл целиком читается в буфер.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return opened; }
+    const char* data() const { return bytes; }
+    std::size_t size() const { return length; }
+
+private:
+    bool opened{false};
+    const char* bytes{nullptr};
+    std::size_t length{0};
+    void* mapping{nullptr};
+    std::vector<char> fallback;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Счётчик, который только растёт
+class MetricCounter {
+public:
+    void add(std::uint64_t n = 1) { count.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t value() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> count{0};
+};
+
+// Текущее значение (глубина очереди и т.п.)
+class MetricGauge {
+public:
+    void set(std::int64_t v) { current.store(v, std::memory_order_relaxed); }
+    void add(std::int64_t v) { current.fetch_add(v, std::memory_order_relaxed); }
+    std::int64_t value() const { return current.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> current{0};
+};
+
+// Гистограмма с логарифмическими корзинами: корзина 0 - значение 0, корзина b - [2^(b-1), 2^b).
+// Запись - три relaxed fetch_add без блокировок. Значения целые (нс, штуки);
+// scale переводит их в единицы вывода (1e-9 - секунды для наносекунд).
+class MetricHistogram {
+public:
+    static constexpr int BUCKETS = 40; // до 2^39 нс, около 9 минут
+    // scale для времён в наносекундах, выводимых в секундах
+    static constexpr double NANOSECONDS = 1e-9;
+
+    explicit MetricHistogram(double scale = 1.0) : unit_scale(scale) {}
+
+    void observe(std::uint64_t value);
+    void observe_since(std::chrono::steady_clock::time_point start) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        observe(static_cast<std::uint64_t>(std::max<std::int64_t>(ns.count(), 0)));
+    }
+
+    std::uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    std::uint64_t sum() const { return value_sum.load(std::memory_order_relaxed); }
+    std::uint64_t bucket(int b) const { return buckets[b].load(std::memory_order_relaxed); }
+    // Верхняя граница корзины b в исходных единицах
+    static std::uint64_t upper_bound(int b) { return b == 0 ? 0 : (std::uint64_t{1} << b) - 1; }
+    // Оценка квантиля сверху: граница корзины, в которую он попал
+    std::uint64_t quantile(double q) const;
+    double scale() const { return unit_scale; }
+
+private:
+    std::atomic<std::uint64_t> buckets[BUCKETS]{};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> value_sum{0};
+    double unit_scale;
+};
+
+// Замер времени блока в гистограмму; с nullptr часы не читаются
+class ScopedTimer {
+public:
+    explicit ScopedTimer(MetricHistogram* histogram)
+        : histogram(histogram), start(histogram ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {}
+    ~ScopedTimer() {
+        if (histogram) histogram->observe_since(start);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    MetricHistogram* histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Реестр метрик. Метрики регистрируются при запуске (под мьютексом) и дальше живут
+// по стабильным адресам, пока жив реестр: горячие пути держат указатели и пишут в атомики,
+// а компоненты сами обновляют свои значения - реестр никого не опрашивает.
+//
+// Имя может нести метки в формате Prometheus: "log_sink_dropped{sink=\"file\"}";
+// HELP и TYPE печатаются один раз на семейство (имя до '{').
+// Повторная регистрация того же имени возвращает уже созданную метрику.
+class MetricsRegistry {
+public:
+    MetricCounter& counter(const std::string& name, const std::string& help);
+    MetricGauge& gauge(const std::string& name, const std::string& help);
+    MetricHistogram& histogram(const std::string& name, const std::string& help, double scale = 1.0);
+
+    // Текстовый формат Prometheus (exposition format 0.0.4)
+    void write_prometheus(std::ostream& out);
+    // Запись во временный файл и переименование, чтобы сборщик не прочёл половину;
+    // при ошибке пишет "Error: ..." в std::cerr и возвращает false
+    bool dump(const std::string& filename);
+    // Краткая сводка для человека: значения и для гистограмм count / mean / p50 / p99
+    void write_summary(std::ostream& out);
+
+private:
+    enum class Kind {
+        Counter,
+        Gauge,
+        Histogram
+    };
+    struct Entry {
+        std::string name;
+        std::string help;
+        Kind kind;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+    };
+
+    Entry& find_or_add(const std::string& name, const std::string& help, Kind kind, double scale);
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Entry>> entries;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "combat_rules.h"
+#include "runtime_config.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+#include "world_store.h"
+
+// Проход движения: каждый живой NPC делает шаг к ближайшей добыче,
+// а если добычи нет - к ближайшему NPC.
+class MovementSystem {
+public:
+    // Как искать ближайшего: по сетке бакетов или полным перебором упакованных
+    // координат (NearestKernel, AVX2 при наличии) - для плотных сцен
+    enum class Search {
+        Grid,
+        Scan
+    };
+
+    // Размер карты и дистанции ходов по типам берутся из config
+    explicit MovementSystem(const RuntimeConfig& config, Search search = Search::Grid);
+
+    void set_search(Search s) { search = s; }
+
+    // Последовательный проход с обновлением позиций на месте:
+    // NPC, идущие позже, видят уже сдвинутых соседей (исходное поведение).
+    // Ходят только NPC из movers, остальные лишь служат целями.
+    // Оба прохода возвращают число NPC, сменивших клетку.
+    std::size_t step_in_place(WorldStore& world, unsigned movers = CombatRules::ALL_TYPES);
+
+    // Проход по снимку: позиции живых копируются из хранилища в снимок начала тика,
+    // все NPC ищут цель и шагают по снимку, а новые позиции пишутся сразу в хранилище.
+    // Результат не зависит от числа потоков; pool == nullptr - один поток.
+    std::size_t step_buffered(WorldStore& world, WorkStealingPool* pool = nullptr);
+
+    // Новая позиция NPC с дистанцией хода step, идущего из (x, y) к (target_x, target_y)
+    static std::pair<int, int> step_towards(int step, int x, int y, int target_x, int target_y, int width,
+                                            int height);
+
+private:
+    // Ближайшая добыча, а если её нет - ближайший кто угодно (SpatialGrid::npos - никого)
+    std::size_t find_target(NpcType type, int x, int y, std::size_t self, const std::vector<int>& pos_x,
+                            const std::vector<int>& pos_y) const;
+    // Типы для NearestKernel: тип живого NPC, NearestKernel::NO_TYPE для остальных слотов
+    void pack_types(const WorldStore& world, std::size_t count);
+
+    int width;
+    int height;
+    int move_distance[WerewolfType + 1]{}; // по NpcType; у Unknown - 0
+    Search search;
+    SpatialGrid grid;
+    std::vector<std::uint8_t> scan_types;
+
+    // Снимок позиций начала тика (в step_in_place - рабочий буфер перебора)
+    std::vector<int> snap_x;
+    std::vector<int> snap_y;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Таблица интернированных имён NPC: имя хранится один раз, NPC в WorldStore ссылается
+// на него компактным id. Символы лежат в блоках, которые не перемещаются, поэтому
+// string_view из view() остаётся действительным, пока жива таблица.
+class NameTable {
+public:
+    using Id = std::uint32_t;
+
+    NameTable() = default;
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+
+    // Id имени; одинаковые имена получают один id
+    Id intern(std::string_view name);
+    std::string_view view(Id id) const;
+
+    std::size_t size() const;
+
+private:
+    static constexpr std::size_t BLOCK_BYTES = 64 * 1024;
+
+    std::string_view store(std::string_view name);
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    // Блок, в который дописываются короткие имена
+    char* current_block{nullptr};
+    std::size_t block_used{0};
+    std::vector<std::string_view> entries;
+    std::unordered_map<std::string_view, Id> index;
+};
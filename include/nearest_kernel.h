@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Поиск ближайшей точки полным перебором по упакованным массивам координат.
+// Для плотных сцен, где сетка SpatialGrid почти не отсекает кандидатов.
+//
+// Точка i участвует, если бит её типа (1 << types[i]) входит в type_mask и i != exclude;
+// NO_TYPE помечает мёртвые и свободные слоты. Расстояния считаются точно в int64,
+// при равных выбирается меньший индекс - результат совпадает с SpatialGrid::nearest.
+// Координаты должны лежать в пределах +-2^30, count - меньше 2^31.
+//
+// Реализация выбирается при запуске: AVX2 (8 точек за шаг), если процессор его
+// поддерживает, иначе скалярный цикл.
+namespace NearestKernel {
+inline constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+inline constexpr std::uint8_t NO_TYPE = 0xFF;
+
+enum class Isa {
+    Scalar,
+    Avx2
+};
+
+std::size_t nearest(const std::int32_t* xs, const std::int32_t* ys, const std::uint8_t* types, std::size_t count,
+                    int x, int y, unsigned type_mask, std::size_t exclude = npos);
+
+// Конкретная реализация в обход выбора при запуске (тесты, замеры)
+std::size_t nearest(Isa isa, const std::int32_t* xs, const std::int32_t* ys, const std::uint8_t* types,
+                    std::size_t count, int x, int y, unsigned type_mask, std::size_t exclude = npos);
+
+bool supported(Isa isa);
+Isa active();
+// Смена реализации (например, принудительно Scalar); false, если процессор её не поддерживает
+bool select(Isa isa);
+const char* name(Isa isa);
+} // namespace NearestKernel
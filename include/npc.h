@@ -6,10 +6,11 @@
 #include <fstream>
 #include <mutex>
 #include <utility>
+#include <cstdint>
 #include "visitor.h"
-#include "observer.h"
 
 struct NPC;
+class WorldStore;
 
 // Типы NPC для упрощения фабрики
 enum NpcType {
@@ -22,24 +23,24 @@ enum NpcType {
 struct NPC : public std::enable_shared_from_this<NPC> {
     NpcType type;
     // NOTE: Access to state below must be synchronized via state_mutex.
+    // Пока NPC привязан к WorldStore, актуальные x/y/alive лежат в хранилище.
     int x{0};
     int y{0};
     bool alive{true};
     std::string name;
-    std::vector<std::shared_ptr<Observer>> observers;
 
     mutable std::mutex state_mutex;
 
+    // Привязка к хранилищу; тоже под state_mutex - bind/unbind меняют её, пока другие потоки читают
+    WorldStore* world{nullptr};
+    std::uint32_t world_id{0};
+
     NPC(NpcType t, int _x, int _y, const std::string& _name);
     virtual ~NPC() = default;
 
     // Паттерн Visitor
     virtual void accept(Visitor& v) = 0;
 
-    // Поддержка Observer
-    void attach(std::shared_ptr<Observer> observer);
-    void notify(const std::string& message, bool is_kill_event = false);
-
     // Общие методы
     virtual void print() = 0;
     virtual void save(std::ostream& os);
@@ -52,6 +53,13 @@ struct NPC : public std::enable_shared_from_this<NPC> {
     void kill();
     std::pair<int, int> position() const;
     void set_position(int new_x, int new_y);
+
+    // Привязка к плотному хранилищу арены (NPC становится представлением записи)
+    void bind(WorldStore& store, std::uint32_t id);
+    // Копирует состояние из хранилища обратно в объект
+    void unbind();
+    // Привязан ли NPC к store; если да - его id в id
+    bool bound_id(const WorldStore& store, std::uint32_t& id) const;
     
     friend std::ostream& operator<<(std::ostream& os, const NPC& npc);
 };
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+
+// Память под объекты NPC одной арены (вместе с блоками управления shared_ptr).
+// Ячейки нарезаются подряд из крупных блоков std::pmr::monotonic_buffer_resource,
+// поэтому NPC, созданные пачкой, лежат в памяти рядом. Освобождённая ячейка уходит
+// в список свободных своего размера и достаётся следующему NPC; блоки возвращаются
+// системе только вместе с пулом. Пул живёт, пока жив хоть один NPC из него:
+// аллокатор держит shared_ptr на пул.
+class NpcPool {
+public:
+    NpcPool();
+    NpcPool(const NpcPool&) = delete;
+    NpcPool& operator=(const NpcPool&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+    void deallocate(void* p, std::size_t bytes, std::size_t alignment);
+
+    // Сколько объектов сейчас выделено из пула
+    std::size_t live_objects() const;
+
+private:
+    // Ячейки кратны GRANULE байт; крупнее MAX_POOLED_BYTES - напрямую из new/delete
+    static constexpr std::size_t GRANULE = 16;
+    static constexpr std::size_t MAX_POOLED_BYTES = 1024;
+    static constexpr std::size_t SIZE_CLASSES = MAX_POOLED_BYTES / GRANULE;
+
+    static bool pooled(std::size_t bytes, std::size_t alignment) {
+        return bytes > 0 && bytes <= MAX_POOLED_BYTES && alignment <= GRANULE;
+    }
+
+    struct FreeCell {
+        FreeCell* next;
+    };
+
+    mutable std::mutex mutex;
+    std::pmr::monotonic_buffer_resource blocks;
+    FreeCell* free_cells[SIZE_CLASSES]{};
+    std::size_t live{0};
+};
+
+// Аллокатор для std::allocate_shared поверх NpcPool
+template <typename T>
+class NpcPoolAllocator {
+public:
+    using value_type = T;
+
+    explicit NpcPoolAllocator(std::shared_ptr<NpcPool> pool) : pool(std::move(pool)) {}
+    template <typename U>
+    NpcPoolAllocator(const NpcPoolAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(pool->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, std::size_t n) { pool->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    template <typename U>
+    bool operator==(const NpcPoolAllocator<U>& other) const { return pool == other.pool; }
+    template <typename U>
+    bool operator!=(const NpcPoolAllocator<U>& other) const { return pool != other.pool; }
+
+private:
+    template <typename U>
+    friend class NpcPoolAllocator;
+
+    std::shared_ptr<NpcPool> pool;
+};
@@ -1,8 +1,21 @@
 #pragma once
 #include <string>
+#include "events.h"
 
+class MetricsRegistry;
+
+// Подписчик EventBus. Типизированные обработчики по умолчанию форматируют событие
+// и передают строку в update(); буферизующие наблюдатели переопределяют их,
+// чтобы не собирать строку в потоке, который публикует событие.
 class Observer {
 public:
     virtual void update(const std::string& message) = 0;
+    virtual void on_kill(const KillEvent& event) { update(event.to_string()); }
+    virtual void on_spawn(const SpawnEvent& event) { update(event.to_string()); }
+    virtual void on_move_summary(const MoveSummaryEvent& event) { update(event.to_string()); }
+    // Дождаться записи всех принятых сообщений (для буферизующих наблюдателей)
+    virtual void flush() {}
+    // Метрики очереди и записи (для буферизующих наблюдателей); nullptr - выключить
+    virtual void set_metrics(MetricsRegistry*) {}
     virtual ~Observer() = default;
-};
\ No newline at end of file
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "runtime_config.h"
+#include "world_frame.h"
+#include "world_store.h"
+
+// Прямоугольник карты, который попадает в кадр, и его прореживание.
+// Область - viewport_* из конфигурации (0 - до края карты); если она больше
+// render_max_cols x render_max_rows, один символ кадра - квадрат scale x scale клеток карты.
+struct FrameLayout {
+    int x0{0};
+    int y0{0};
+    int width{0};
+    int height{0};
+    int scale{1};
+    int cols{0};
+    int rows{0};
+
+    static FrameLayout from(const RuntimeConfig& config);
+};
+
+// Полный кадр карты с заголовком "Seconds left: ... | Alive: ..."
+// Из кадра (Arena::frame) - без чтения хранилища, которое в это время меняет симуляция
+std::string render_map(const WorldStore& world, int seconds_left, const RuntimeConfig& config);
+std::string render_map(const WorldFrame& world, int seconds_left, const RuntimeConfig& config);
+
+// Инкрементальная отрисовка в терминал через ANSI-последовательности.
+// Хранит прошлый кадр и выводит только изменившиеся символы; первый кадр
+// (и кадр после invalidate) рисуется целиком. Строки под картой отдаются
+// под область прокрутки, чтобы лог боёв не сдвигал карту.
+class DiffRenderer {
+public:
+    explicit DiffRenderer(const RuntimeConfig& config);
+
+    // ANSI-последовательность для перехода к новому кадру
+    const std::string& render(const WorldStore& world, int seconds_left);
+    const std::string& render(const WorldFrame& world, int seconds_left);
+    // Сброс области прокрутки и курсор под карту - вызвать после последнего кадра
+    std::string finish() const;
+    void invalidate() { full_redraw = true; }
+
+    const FrameLayout& layout() const { return frame; }
+    // Сколько символов карты изменилось в последнем кадре
+    std::size_t changed_cells() const { return changed; }
+
+    // Вывод одним write() под Output::cout_mutex (буфер std::cout сбрасывается раньше)
+    static void write_out(const std::string& data);
+    // ANSI-вывод имеет смысл только в терминал; в файл/канал пишутся полные кадры
+    static bool stdout_is_terminal();
+
+private:
+    // Вывод по уже растеризованному current
+    const std::string& render_current(int seconds_left, std::size_t alive_count);
+
+    FrameLayout frame;
+    std::vector<char> previous;
+    std::vector<char> current;
+    std::string out;
+    std::size_t changed{0};
+    bool full_redraw{true};
+};
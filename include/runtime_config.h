@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "game_config.h"
+#include "npc.h"
+
+// Параметры мира, задаваемые при запуске: флаги командной строки (--key=value, --key value)
+// или файл "key=value" (--config <file>). Значения по умолчанию - из GameConfig.
+//
+// Ключи: map_width, map_height, npc_count, duration_seconds, render_period_ms, movement_tick_ms,
+// render_max_cols, render_max_rows, render_diff, viewport_x, viewport_y, viewport_width,
+// viewport_height, parallel_movement, nearest_scan, behavior_coroutines, virtual_time, headless,
+// shards, shard_ghost_width, fight_workers, fight_queue_capacity,
+// fight_queue_drop_when_full, reclaim_period_ticks, seed, batch_arenas, batch_max_ticks, batch_seed, batch_threads,
+// ork_move_distance, ork_kill_distance, willian_move_distance, willian_kill_distance,
+// werewolf_move_distance, werewolf_kill_distance, ork_move_period_ms, willian_move_period_ms,
+// werewolf_move_period_ms, metrics, metrics_period_ms, metrics_file.
+// В флагах вместо '_' можно писать '-'.
+struct RuntimeConfig {
+    int map_width = GameConfig::MAP_WIDTH;
+    int map_height = GameConfig::MAP_HEIGHT;
+
+    std::size_t npc_count = GameConfig::INITIAL_NPC_COUNT;
+    int duration_seconds = GameConfig::GAME_DURATION_SECONDS;
+    int render_period_ms = GameConfig::RENDER_PERIOD_MS;
+    int movement_tick_ms = GameConfig::MOVEMENT_TICK_MS;
+
+    // Предельный размер кадра в символах; большая карта рисуется с прореживанием
+    int render_max_cols = GameConfig::RENDER_MAX_COLS;
+    int render_max_rows = GameConfig::RENDER_MAX_ROWS;
+    bool render_diff = GameConfig::RENDER_DIFF;
+    // Видимая часть карты (DiffRenderer и render_map)
+    int viewport_x = GameConfig::VIEWPORT_X;
+    int viewport_y = GameConfig::VIEWPORT_Y;
+    int viewport_width = GameConfig::VIEWPORT_WIDTH;
+    int viewport_height = GameConfig::VIEWPORT_HEIGHT;
+
+    bool parallel_movement = GameConfig::PARALLEL_MOVEMENT;
+    // Поиск цели полным перебором (NearestKernel) вместо сетки
+    bool nearest_scan = GameConfig::NEAREST_SCAN;
+    // Поведение NPC сопрограммами (BehaviorScheduler) вместо прохода движения и очередей боёв
+    bool behavior_coroutines = GameConfig::BEHAVIOR_COROUTINES;
+    // Игра на виртуальных часах (SimEngine); headless - без отрисовки и пауз
+    bool virtual_time = GameConfig::VIRTUAL_TIME;
+    bool headless = GameConfig::HEADLESS;
+    // Полосы карты со своими потоками (ShardedWorld); 0 - один поток движения
+    std::size_t shards = GameConfig::SHARDS;
+    int shard_ghost_width = GameConfig::SHARD_GHOST_WIDTH;
+    std::size_t fight_workers = GameConfig::FIGHT_WORKERS;
+    std::size_t fight_queue_capacity = GameConfig::FIGHT_QUEUE_CAPACITY;
+    bool fight_queue_drop_when_full = GameConfig::FIGHT_QUEUE_DROP_WHEN_FULL;
+    std::size_t reclaim_period_ticks = GameConfig::RECLAIM_PERIOD_TICKS;
+    // Зерно расстановки и бросков боя; 0 - случайное (Game печатает выбранное)
+    std::uint64_t seed = GameConfig::SEED;
+
+    // Пакетный режим без отрисовки (BatchRunner); batch_arenas == 0 - обычная игра
+    std::size_t batch_arenas = GameConfig::BATCH_ARENAS;
+    std::size_t batch_max_ticks = GameConfig::BATCH_MAX_TICKS;
+    std::uint64_t batch_seed = GameConfig::BATCH_SEED;
+    std::size_t batch_threads = GameConfig::BATCH_THREADS;
+
+    int ork_move_distance = GameConfig::ORK_MOVE_DISTANCE;
+    int ork_kill_distance = GameConfig::ORK_KILL_DISTANCE;
+    int willian_move_distance = GameConfig::WILLIAN_MOVE_DISTANCE;
+    int willian_kill_distance = GameConfig::WILLIAN_KILL_DISTANCE;
+    int werewolf_move_distance = GameConfig::WEREWOLF_MOVE_DISTANCE;
+    int werewolf_kill_distance = GameConfig::WEREWOLF_KILL_DISTANCE;
+    // Период хода по типам в SimEngine; 0 - movement_tick_ms
+    int ork_move_period_ms = GameConfig::ORK_MOVE_PERIOD_MS;
+    int willian_move_period_ms = GameConfig::WILLIAN_MOVE_PERIOD_MS;
+    int werewolf_move_period_ms = GameConfig::WEREWOLF_MOVE_PERIOD_MS;
+
+    // Метрики (MetricsRegistry): сброс в metrics_file каждые metrics_period_ms и при выходе
+    bool metrics = GameConfig::METRICS;
+    int metrics_period_ms = GameConfig::METRICS_PERIOD_MS;
+    std::string metrics_file = GameConfig::METRICS_FILE;
+
+    int move_distance(NpcType type) const;
+    int kill_distance(NpcType type) const;
+    // Действующий период хода типа: свой или movement_tick_ms
+    int move_period_ms(NpcType type) const;
+
+    // Установка одного параметра; при ошибке пишет "Error: ..." в std::cerr и возвращает false
+    bool set(std::string_view key, std::string_view value);
+    // Файл "key=value", пустые строки и строки с '#' пропускаются
+    bool load_file(const std::string& filename);
+    // argv[1..argc-1]; --config <file> применяется в месте появления,
+    // поэтому флаги после него переопределяют значения из файла
+    bool parse_args(int argc, const char* const* argv);
+    // Проверка согласованности (размеры карты > 0 и т.п.)
+    bool validate() const;
+
+    // Активная конфигурация процесса - значение по умолчанию для Arena, Factory, Game и
+    // BatchRunner; кто получил config явно, её не читает.
+    // Меняется только при запуске, до создания потоков симуляции.
+    static const RuntimeConfig& current();
+    static void set_current(const RuntimeConfig& config);
+};
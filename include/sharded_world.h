@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "arena.h"
+#include "counter_rng.h"
+#include "fight_system.h"
+#include "runtime_config.h"
+#include "spatial_grid.h"
+#include "world_store.h"
+
+// Итог одного такта ShardedWorld
+struct ShardTickStats {
+    std::size_t moved{0};
+    std::size_t fights{0};
+    std::size_t kills{0};
+    std::size_t migrated{0};  // NPC, сменивших шард
+    std::size_t ghosts{0};    // копий в пограничных зонах соседей
+    std::size_t fallbacks{0}; // поисков цели, не уместившихся в свой шард с призраками
+};
+
+// Мир, разрезанный на вертикальные полосы карты. У каждой полосы (шарда) свой поток
+// и свой набор NPC - те, кто стоит в её пределах.
+//
+// Такт идёт фазами через барьер:
+//  1. шард строит сетку по своим NPC и призракам - копиям соседских NPC из полосы
+//     ghost_width за его границами;
+//  2. свои NPC делают шаг к ближайшей цели по позициям начала такта. Если ближайший
+//     в сетке шарда дальше, чем край зоны призраков, ответ уточняется по сеткам всех
+//     шардов - выбор цели точно совпадает с MovementSystem::step_buffered;
+//  3. перешедшие границу NPC переезжают в новый шард, шарды рассылают призраков
+//     с новыми позициями;
+//  4. свои атакующие ищут защищающихся в радиусе удара (ghost_width не меньше
+//     дистанции удара, поэтому пары через границу не теряются); бой уходит шарду,
+//     которому принадлежит защищающийся;
+//  5. шард разрешает бои своих защищающихся по порядку (атакующий, защищающийся).
+//     Бои такта одновременны (resolve_fight без проверки живости атакующего), поэтому
+//     итог не зависит ни от потоков, ни от числа шардов.
+//
+// NPC остаются в общем WorldStore арены: поля там атомарные, а в каждый слот пишет
+// только поток его шарда, поэтому блокировки арены в такте не берутся.
+class ShardedWorld {
+public:
+    // shards == 0 - по одному на ядро; ghost_width == 0 - наибольшая дистанция удара или хода
+    ShardedWorld(Arena& arena, const RuntimeConfig& config, std::size_t shards, int ghost_width = 0,
+                 std::uint64_t seed = GameConfig::SEED);
+    ~ShardedWorld();
+    ShardedWorld(const ShardedWorld&) = delete;
+    ShardedWorld& operator=(const ShardedWorld&) = delete;
+
+    // Один такт всеми шардами; вызывается из одного потока
+    ShardTickStats tick();
+
+    std::size_t shard_count() const { return shards.size(); }
+    int ghost_width() const { return ghost; }
+    std::uint64_t now() const { return current_tick; }
+    // Сколько NPC сейчас у шарда и какому шарду принадлежит столбец x
+    std::size_t owned(std::size_t shard) const { return shards[shard]->owned.size(); }
+    std::size_t shard_of(int x) const;
+
+private:
+    // Копия NPC для соседнего шарда
+    struct Ghost {
+        WorldStore::Id id;
+        int x;
+        int y;
+        std::uint8_t type;
+    };
+
+    struct Shard {
+        Shard(int lo, int hi, int height) : lo(lo), hi(hi), grid(hi - lo, height) {}
+
+        int x0{0}, x1{0}; // свои столбцы [x0, x1)
+        int lo, hi;       // столбцы вместе с зонами призраков [lo, hi)
+        std::vector<WorldStore::Id> owned; // по возрастанию id
+
+        // Свои и призраки по возрастанию id; сетка - в координатах x - lo
+        std::vector<WorldStore::Id> ids;
+        std::vector<int> xs, ys;
+        std::vector<std::uint8_t> types;
+        std::vector<std::uint32_t> owners;
+        SpatialGrid grid;
+
+        // Исходящие по шардам-получателям; пишет только этот шард
+        std::vector<std::vector<Ghost>> ghosts_out;
+        std::vector<std::vector<WorldStore::Id>> migrate_out;
+        std::vector<std::vector<FightTask>> fights_out;
+
+        std::vector<std::size_t> found;
+        std::vector<FightTask> inbox;
+        ShardTickStats stats;
+    };
+
+    struct Target {
+        WorldStore::Id id{0};
+        int x{0}, y{0};
+        long long dist_sq{-1}; // -1 - не найден
+    };
+
+    void worker(std::size_t index);
+    void build_view(std::size_t index, bool skip_dead);
+    void move(std::size_t index);
+    void migrate_and_publish(std::size_t index);
+    void publish_ghosts(std::size_t index);
+    void check_fights(std::size_t index);
+    void resolve_fights(std::size_t index);
+    Target nearest(std::size_t index, std::size_t local, unsigned type_mask, std::size_t& fallbacks) const;
+
+    Arena& arena;
+    RuntimeConfig cfg;
+    CounterRng rng;
+    int ghost;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    std::uint64_t current_tick{0};
+    bool stopping{false};
+    // Главный поток и шарды: начало и конец такта; между фазами - только шарды
+    std::barrier<> start;
+    std::barrier<> done;
+    std::barrier<> phase;
+    std::vector<std::thread> threads;
+};
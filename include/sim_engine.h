@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+#include "arena.h"
+#include "counter_rng.h"
+#include "fight_system.h"
+#include "movement.h"
+#include "runtime_config.h"
+#include "world_frame.h"
+
+// Виды событий. На одном времени события идут в порядке перечисления:
+// конец игры раньше всего остального, бои такта - после движения.
+enum class SimEventKind : std::uint8_t {
+    End,
+    Move,         // шаг NPC из type_mask
+    FightCheck,   // сбор боёв такта (collect_fights)
+    FightResolve, // разрешение собранных боёв, конец такта
+    Render
+};
+
+struct SimEvent {
+    std::uint64_t time_ms;
+    SimEventKind kind;
+    std::uint64_t seq; // порядок постановки - при равных времени и виде
+    unsigned type_mask{0};
+
+    bool operator>(const SimEvent& other) const {
+        if (time_ms != other.time_ms) return time_ms > other.time_ms;
+        if (kind != other.kind) return kind > other.kind;
+        return seq > other.seq;
+    }
+};
+
+// Итог прогона SimEngine
+struct SimStats {
+    std::size_t events{0};
+    std::size_t moves{0};  // событий Move
+    std::size_t moved{0};  // NPC, сменивших клетку, за все Move
+    std::size_t ticks{0};  // завершённых тактов боёв
+    std::size_t fights{0};
+    std::size_t kills{0};
+    std::size_t renders{0};
+    std::uint64_t virtual_ms{0};
+    double wall_seconds{0.0};
+};
+
+// Дискретно-событийная симуляция на виртуальных часах.
+//
+// Вместо потоков и sleep_for - очередь событий с метками времени в мс:
+// Move (по группам типов с одинаковым периодом хода), FightCheck и FightResolve
+// (раз в movement_tick_ms), Render (раз в render_period_ms, если задан on_render)
+// и End (через duration_seconds). Всё выполняется в вызывающем потоке, поэтому
+// при одном зерне прогон повторяется точно.
+//
+// Headless - события без пауз: 30 секунд игры проходят за миллисекунды.
+// RealTime - событие ждёт, пока настенные часы дойдут до его времени (1x).
+class SimEngine {
+public:
+    enum class Pacing {
+        Headless,
+        RealTime
+    };
+    using RenderFn = std::function<void(const WorldFrame&, int seconds_left)>;
+
+    SimEngine(Arena& arena, const RuntimeConfig& config, std::uint64_t seed = GameConfig::SEED);
+    SimEngine(const SimEngine&) = delete;
+    SimEngine& operator=(const SimEngine&) = delete;
+
+    // Без обработчика события Render не ставятся
+    void on_render(RenderFn fn) { render = std::move(fn); }
+
+    // Прогон до события End; последний кадр публикуется после него
+    SimStats run(Pacing pacing = Pacing::Headless);
+
+    std::uint64_t now_ms() const { return now; }
+    std::uint64_t tick() const { return current_tick; }
+
+private:
+    void push(std::uint64_t time_ms, SimEventKind kind, unsigned type_mask = 0);
+    void handle(const SimEvent& event);
+
+    Arena& arena;
+    RuntimeConfig cfg;
+    CounterRng rng;
+    MovementSystem movement;
+    RenderFn render;
+
+    std::priority_queue<SimEvent, std::vector<SimEvent>, std::greater<SimEvent>> events;
+    std::uint64_t seq{0};
+    std::uint64_t now{0};
+    std::uint64_t end_ms{0};
+    std::uint64_t current_tick{0};
+    bool finished{false};
+
+    std::vector<FightTask> batch; // от FightCheck до FightResolve
+    SimStats stats;
+};
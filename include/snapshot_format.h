@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Бинарный снимок арены (Arena::save_binary / Arena::load_binary):
+//   Header | Record[count] | таблица имён (names_size байт, без разделителей)
+// Числа записываются в порядке байт машины; endian_tag позволяет распознать чужой порядок.
+namespace Snapshot {
+inline constexpr char MAGIC[4] = {'N', 'P', 'C', 'S'};
+inline constexpr std::uint32_t VERSION = 1;
+inline constexpr std::uint32_t ENDIAN_TAG = 0x01020304;
+inline constexpr std::size_t MAX_NAME_LENGTH = 0xFFFF;
+
+struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t endian_tag;
+    std::uint32_t record_size;
+    std::uint64_t count;
+    std::uint64_t names_size;
+};
+
+struct Record {
+    std::int32_t x;
+    std::int32_t y;
+    std::uint32_t name_offset;
+    std::uint16_t name_length;
+    std::uint8_t type;
+    std::uint8_t alive;
+};
+
+static_assert(sizeof(Header) == 32, "Snapshot header layout changed");
+static_assert(sizeof(Record) == 16, "Snapshot record layout changed");
+} // namespace Snapshot
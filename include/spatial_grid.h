@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "combat_rules.h"
+#include "npc.h"
+#include "world_store.h"
+
+// Равномерная сетка бакетов для поиска ближайшего NPC.
+// Для каждого NpcType своя сетка, поэтому запрос "ближайший из типов X"
+// не просматривает NPC других типов.
+class SpatialGrid {
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+    static constexpr int DEFAULT_CELL_SIZE = 8;
+    // Предел числа клеток на тип: на больших картах клетки укрупняются
+    static constexpr std::size_t MAX_CELLS = std::size_t{1} << 16;
+    static constexpr int TYPE_COUNT = CombatRules::TYPE_COUNT;
+
+    static constexpr unsigned type_bit(NpcType type) { return CombatRules::type_bit(type); }
+    static constexpr unsigned ALL_TYPES = CombatRules::ALL_TYPES;
+
+    SpatialGrid(int width, int height, int cell_size = DEFAULT_CELL_SIZE);
+
+    // Полная перестройка по хранилищу (мёртвые NPC не попадают в сетку).
+    // Индексы в запросах - это id записей WorldStore.
+    void rebuild(const WorldStore& store);
+    // То же, но позиции берутся из внешнего буфера (xs[id], ys[id])
+    void rebuild(const WorldStore& store, const std::vector<int>& xs, const std::vector<int>& ys);
+    // Сетка по упакованному набору точек (шард мира): индексы - позиции в массивах,
+    // живость при запросах не проверяется
+    void rebuild(const std::vector<int>& xs, const std::vector<int>& ys, const std::vector<std::uint8_t>& types);
+
+    // Обновление позиции уже добавленного NPC
+    void move(std::size_t index, int new_x, int new_y);
+    void remove(std::size_t index);
+
+    // Ближайший живой NPC, тип которого входит в type_mask, кроме exclude.
+    // При равных расстояниях выбирается меньший индекс (как при полном переборе).
+    std::size_t nearest(int x, int y, unsigned type_mask, std::size_t exclude) const;
+
+    // Все живые NPC из type_mask в круге радиуса radius вокруг (x, y), кроме exclude.
+    // Индексы дописываются в out в порядке обхода клеток (без сортировки).
+    void within(int x, int y, int radius, unsigned type_mask, std::size_t exclude,
+                std::vector<std::size_t>& out) const;
+
+private:
+    struct Entry {
+        std::size_t index;
+        int x;
+        int y;
+    };
+
+    struct Slot {
+        int type{-1};
+        std::size_t cell{0};
+        std::size_t pos{0};
+    };
+
+    int cell_col(int x) const;
+    int cell_row(int y) const;
+    std::size_t cell_of(int x, int y) const;
+    void insert(std::size_t index, int type, int x, int y);
+    template <typename PositionFn>
+    void fill(const WorldStore& store, std::size_t count, PositionFn position);
+
+    int cell_size;
+    int cols;
+    int rows;
+    // cells[type][row * cols + col]
+    std::vector<std::vector<Entry>> cells[TYPE_COUNT];
+    std::vector<Slot> slots;
+    const WorldStore* world{nullptr};
+};
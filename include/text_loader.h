@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "npc.h"
+#include "npc_pool.h"
+#include "runtime_config.h"
+#include "thread_pool.h"
+
+// Ошибка разбора строки текстового сценария (номер строки с 1)
+struct LoadError {
+    std::size_t line{0};
+    std::string message;
+};
+
+struct TextScenario {
+    std::size_t declared_count{0};
+    std::vector<std::shared_ptr<NPC>> npcs;
+    std::vector<LoadError> errors;
+};
+
+// Быстрый разбор текстового формата Arena::save ("<count>\n<Type> <x> <y> <Name>\n...").
+// Буфер режется на куски по границам строк, куски разбираются параллельно через
+// std::from_chars; некорректные строки пропускаются и попадают в errors.
+// С npc_pool объекты размещаются в нём; координаты проверяются по карте config.
+TextScenario parse_text_scenario(const char* data, std::size_t size,
+                                 WorkStealingPool* pool = nullptr,
+                                 const std::shared_ptr<NpcPool>& npc_pool = nullptr,
+                                 const RuntimeConfig& config = RuntimeConfig::current());
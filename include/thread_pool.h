@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с очередью на каждый поток и кражей задач (work stealing).
+// Поток берёт задачи с конца своей очереди, а когда она пуста - забирает
+// задачи из начала чужих очередей.
+class WorkStealingPool {
+public:
+    // threads == 0 - по числу аппаратных потоков
+    explicit WorkStealingPool(std::size_t threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    std::size_t size() const { return workers.size(); }
+
+    // Делит [begin, end) на куски по grain элементов и выполняет fn(from, to) для каждого.
+    // Вызывающий поток тоже выполняет задачи и возвращается, когда готовы все куски.
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                      const std::function<void(std::size_t, std::size_t)>& fn);
+
+private:
+    using Task = std::function<void()>;
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool try_pop(std::size_t index, Task& task);
+    bool try_steal(std::size_t thief, Task& task);
+    void worker_loop(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    std::atomic<long> queued{0};
+    bool stopping{false};
+};
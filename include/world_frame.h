@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "name_table.h"
+#include "npc.h"
+#include "world_store.h"
+
+// Неизменяемый снимок мира на конец такта: все занятые слоты WorldStore по возрастанию id.
+// Снимается одним проходом по хранилищу, поэтому позиции в кадре - из одного такта,
+// а читатели (отрисовка, отчёт о выживших, сохранение) не трогают блокировки симуляции.
+struct WorldFrame {
+    struct Entry {
+        WorldStore::Id id{0};
+        int x{0};
+        int y{0};
+        NameTable::Id name{0};
+        NpcType type{Unknown};
+        bool alive{false};
+    };
+
+    std::uint64_t tick{0};
+    std::vector<Entry> entries;
+    std::size_t alive_count{0};
+    // Таблица, по которой читаются Entry::name
+    std::shared_ptr<const NameTable> names;
+
+    template <typename Fn>
+    void for_each_alive(Fn&& fn) const {
+        for (const auto& e : entries) {
+            if (e.alive) fn(e);
+        }
+    }
+};
+
+// Обмен кадрами между одним писателем (поток симуляции) и любым числом читателей.
+// Три кадра по кругу: один опубликован, в один пишет симуляция, третий может
+// дочитываться читателем, взявшим его раньше. Кадр переписывается, только когда
+// его не держит ни один читатель (use_count), так что память векторов переиспользуется;
+// если читатели держат все кадры, писатель заводит новый.
+class FrameExchange {
+public:
+    FrameExchange();
+    FrameExchange(const FrameExchange&) = delete;
+    FrameExchange& operator=(const FrameExchange&) = delete;
+
+    // Кадр для заполнения; до publish() его не видит ни один читатель
+    WorldFrame& begin_write();
+    // Публикует кадр, полученный из begin_write()
+    void publish();
+
+    // Последний опубликованный кадр (до первой публикации - пустой)
+    std::shared_ptr<const WorldFrame> latest() const;
+
+    // Сколько раз все три кадра оказались заняты читателями
+    std::size_t extra_frames() const { return extra; }
+
+private:
+    std::array<std::shared_ptr<WorldFrame>, 3> frames;
+    std::size_t writing{0};
+    std::size_t extra{0};
+    // Последний опубликованный кадр; читатели берут его из других потоков
+    std::atomic<std::shared_ptr<const WorldFrame>> current;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "npc.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Плотное хранилище состояния NPC (structure of arrays).
+// Горячие проходы Game::run (движение, постановка боёв, отрисовка) читают
+// x[], y[], type[], alive[] напрямую, без обхода shared_ptr и без мьютексов.
+//
+// Данные лежат блоками по CHUNK_SIZE записей; блоки никогда не перемещаются,
+// поэтому id (индекс записи) стабилен и читается из любого потока без блокировок.
+// Добавление и освобождение слотов выполняются под эксклюзивной блокировкой владельца (Arena).
+//
+// Слоты мёртвых NPC можно освободить (retire): поколение слота растёт, слот уходит
+// в список свободных и достаётся следующему add(). Handle (id + поколение) позволяет
+// отличить старую запись от новой в том же слоте. Живость хранится битовой маской,
+// поэтому for_each_alive пропускает по 64 мёртвых/свободных слота за одно слово.
+class WorldStore {
+public:
+    using Id = std::uint32_t;
+
+    struct Handle {
+        Id id{0};
+        std::uint32_t generation{0};
+    };
+
+    static constexpr std::size_t CHUNK_BITS = 12;
+    static constexpr std::size_t CHUNK_SIZE = std::size_t{1} << CHUNK_BITS;
+    static constexpr std::size_t MAX_CHUNKS = std::size_t{1} << 14;
+    // Предельное число записей
+    static constexpr std::size_t CAPACITY = CHUNK_SIZE * MAX_CHUNKS;
+
+    WorldStore();
+    ~WorldStore();
+    WorldStore(const WorldStore&) = delete;
+    WorldStore& operator=(const WorldStore&) = delete;
+
+    // Берёт свободный слот, если он есть, иначе новый в конце
+    Id add(NpcType type, int x, int y, bool alive = true, std::uint32_t name_id = 0);
+    // Память блоков сохраняется, id начинают выдаваться заново; старые Handle становятся недействительными
+    void clear();
+    // Освобождение слота мёртвой записи (живую сначала нужно убить)
+    void retire(Id id);
+
+    // Граница занятых слотов: все id < size() (часть из них может быть свободна)
+    std::size_t size() const { return count.load(std::memory_order_acquire); }
+    std::size_t free_slots() const { return free_list.size(); }
+
+    int x(Id id) const { return chunk(id)->x[offset(id)].load(std::memory_order_relaxed); }
+    int y(Id id) const { return chunk(id)->y[offset(id)].load(std::memory_order_relaxed); }
+    NpcType type(Id id) const {
+        return static_cast<NpcType>(chunk(id)->type[offset(id)].load(std::memory_order_relaxed));
+    }
+    bool is_alive(Id id) const {
+        return (chunk(id)->alive[word_of(id)].load(std::memory_order_relaxed) & bit_of(id)) != 0;
+    }
+
+    void set_position(Id id, int new_x, int new_y) {
+        Chunk* c = chunk(id);
+        c->x[offset(id)].store(new_x, std::memory_order_relaxed);
+        c->y[offset(id)].store(new_y, std::memory_order_relaxed);
+    }
+    // Id имени в NameTable арены (для событий боя без обращения к объекту NPC)
+    std::uint32_t name(Id id) const { return chunk(id)->name[offset(id)].load(std::memory_order_relaxed); }
+
+    void kill(Id id) { chunk(id)->alive[word_of(id)].fetch_and(~bit_of(id), std::memory_order_relaxed); }
+
+    std::uint32_t generation(Id id) const {
+        return chunk(id)->generation[offset(id)].load(std::memory_order_acquire);
+    }
+    Handle handle(Id id) const { return Handle{id, generation(id)}; }
+    // Handle указывает на ту же запись, что и при выдаче (слот не освобождали)
+    bool valid(Handle h) const { return h.id < size() && generation(h.id) == h.generation; }
+
+    // fn(id) для живых записей с id в [begin, end)
+    template <typename Fn>
+    void for_each_alive(std::size_t begin, std::size_t end, Fn&& fn) const {
+        end = std::min(end, size());
+        std::size_t id = begin;
+        while (id < end) {
+            const Chunk* c = chunk(static_cast<Id>(id));
+            const std::size_t w = word_of(static_cast<Id>(id));
+            const std::size_t word_base = id & ~std::size_t{63};
+            std::uint64_t bits = c->alive[w].load(std::memory_order_relaxed);
+            bits &= ~std::uint64_t{0} << (id - word_base);
+            const std::size_t word_end = word_base + 64;
+            if (end < word_end) bits &= (std::uint64_t{1} << (end - word_base)) - 1;
+            while (bits) {
+                const int bit = lowest_bit(bits);
+                fn(static_cast<Id>(word_base + static_cast<std::size_t>(bit)));
+                bits &= bits - 1;
+            }
+            id = word_end;
+        }
+    }
+    template <typename Fn>
+    void for_each_alive(Fn&& fn) const {
+        for_each_alive(0, size(), std::forward<Fn>(fn));
+    }
+
+    // Служебные столбцы FightSystem (дедупликация без аллокаций):
+    // поколение последней принятой пачки боёв атакующего и число его боёв в очередях
+    std::atomic<std::uint32_t>& fight_stamp(Id id) { return chunk(id)->fight_stamp[offset(id)]; }
+    std::atomic<std::uint32_t>& fights_in_flight(Id id) { return chunk(id)->fights_in_flight[offset(id)]; }
+
+    // Размер состояния одного NPC в хранилище, байт (бит живости округлён до байта)
+    static constexpr std::size_t bytes_per_npc() {
+        return 2 * sizeof(std::atomic<int>) + sizeof(std::atomic<std::uint8_t>) + 1 +
+               4 * sizeof(std::atomic<std::uint32_t>);
+    }
+
+private:
+    static constexpr std::size_t WORDS_PER_CHUNK = CHUNK_SIZE / 64;
+
+    struct Chunk {
+        std::atomic<int> x[CHUNK_SIZE];
+        std::atomic<int> y[CHUNK_SIZE];
+        std::atomic<std::uint8_t> type[CHUNK_SIZE];
+        std::atomic<std::uint64_t> alive[WORDS_PER_CHUNK];
+        std::atomic<std::uint32_t> generation[CHUNK_SIZE];
+        std::atomic<std::uint32_t> name[CHUNK_SIZE];
+        std::atomic<std::uint32_t> fight_stamp[CHUNK_SIZE];
+        std::atomic<std::uint32_t> fights_in_flight[CHUNK_SIZE];
+    };
+
+    static std::size_t offset(Id id) { return id & (CHUNK_SIZE - 1); }
+    static std::size_t word_of(Id id) { return offset(id) >> 6; }
+    static std::uint64_t bit_of(Id id) { return std::uint64_t{1} << (id & 63); }
+    static int lowest_bit(std::uint64_t bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+    Chunk* chunk(Id id) const { return chunks[id >> CHUNK_BITS].load(std::memory_order_acquire); }
+
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks;
+    std::atomic<std::size_t> count{0};
+    std::vector<Id> free_list;
+};
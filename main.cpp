@@ -2,30 +2,52 @@
 #include <memory>
 #include <mutex>
 #include "include/arena.h"
+#include "include/batch_runner.h"
 #include "include/game.h"
-#include "include/game_config.h"
+#include "include/nearest_kernel.h"
+#include "include/runtime_config.h"
 #include "include/output.h"
 #include "include/file_observer.h"
 #include "include/console_observer.h"
 
-int main() {
+// Параметры мира: ./dungeon_editor [--config world.cfg] [--map-width 1000 --npc-count 100000 --seed 42 ...]
+// Пакетный режим: ./dungeon_editor --batch-arenas 10000 [--batch-seed 7 --batch-threads 8]
+int main(int argc, char** argv) {
+    RuntimeConfig config;
+    if (!config.parse_args(argc, argv) || !config.validate()) {
+        return 1;
+    }
+    RuntimeConfig::set_current(config);
+
+    if (config.batch_arenas > 0) {
+        BatchRunner runner(config);
+        const BatchSummary summary = runner.run(config.batch_arenas, config.batch_seed, config.batch_threads);
+        print_summary(std::cout, summary);
+        return 0;
+    }
+
     Arena arena;
     
     // Создаем наблюдателей один раз
     auto file_obs = std::make_shared<FileObserver>("log.txt");
     auto console_obs = std::make_shared<ConsoleObserver>();
 
+    Game game(arena, file_obs, console_obs, config);
+
     {
         std::lock_guard<std::mutex> lock(Output::cout_mutex);
         std::cout << "Lab 7 - Async NPC Arena" << std::endl;
-        std::cout << "Map: " << GameConfig::MAP_WIDTH << "x" << GameConfig::MAP_HEIGHT
-                  << ", NPC: " << GameConfig::INITIAL_NPC_COUNT
-                  << ", duration: " << GameConfig::GAME_DURATION_SECONDS << "s" << std::endl;
+        std::cout << "Map: " << config.map_width << "x" << config.map_height
+                  << ", NPC: " << config.npc_count
+                  << ", duration: " << config.duration_seconds << "s"
+                  << ", seed: " << game.seed() << std::endl;
+        if (config.nearest_scan) {
+            std::cout << "Nearest search: " << NearestKernel::name(NearestKernel::active()) << " scan" << std::endl;
+        }
     }
 
-    Game game(arena, file_obs, console_obs);
-    game.init_random_npcs(GameConfig::INITIAL_NPC_COUNT);
+    game.init_random_npcs(config.npc_count);
     game.run();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,33 +1,197 @@
 #include "../include/arena.h"
 #include "../include/factory.h"
-#include "../include/combat_visitor.h"
+#include "../include/combat_rules.h"
+#include "../include/mapped_file.h"
 #include "../include/output.h"
+#include "../include/runtime_config.h"
+#include "../include/spatial_grid.h"
+#include "../include/snapshot_format.h"
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <shared_mutex>
 #include <mutex>
 
+namespace {
+// С какого размера файла load_fast заводит свой пул потоков
+constexpr std::size_t FAST_LOAD_PARALLEL_BYTES = 1 << 20;
+// Куски атакующих в параллельном Arena::fight
+constexpr std::size_t FIGHT_GRAIN = 1024;
+} // namespace
+
 std::vector<std::shared_ptr<NPC>> Arena::npcs_snapshot() const {
     std::shared_lock<std::shared_mutex> lock(npcs_mutex);
     return npcs;
 }
 
-void Arena::add_npc(std::shared_ptr<NPC> npc) {
-    std::unique_lock<std::shared_mutex> lock(npcs_mutex);
+void Arena::capture_frame(WorldFrame& out, std::uint64_t tick) const {
+    std::shared_lock<std::shared_mutex> lock(npcs_mutex);
+    out.tick = tick;
+    out.names = name_table;
+    out.entries.clear();
+    out.entries.reserve(npcs.size());
+    out.alive_count = 0;
+    for (std::size_t i = 0; i < by_id.size(); ++i) {
+        if (!by_id[i]) continue; // свободный слот
+        const auto id = static_cast<WorldStore::Id>(i);
+        const bool alive = world_store.is_alive(id);
+        out.entries.push_back(WorldFrame::Entry{id, world_store.x(id), world_store.y(id), world_store.name(id),
+                                                world_store.type(id), alive});
+        if (alive) ++out.alive_count;
+    }
+}
+
+void Arena::publish_frame(std::uint64_t tick) {
+    ScopedTimer timer(instruments.frame_publish);
+    WorldFrame& frame = frame_exchange.begin_write();
+    capture_frame(frame, tick);
+    if (instruments.alive) instruments.alive->set(static_cast<std::int64_t>(frame.alive_count));
+    frame_exchange.publish();
+}
+
+void Arena::set_metrics(MetricsRegistry* registry) {
+    if (!registry) {
+        instruments = Instruments{};
+        return;
+    }
+    instruments.added = &registry->counter("arena_npcs_added_total", "NPC added to the arena");
+    instruments.kills = &registry->counter("arena_kills_total", "NPC killed in fights");
+    instruments.reclaimed = &registry->counter("arena_slots_reclaimed_total", "World store slots freed by reclaim_dead");
+    instruments.alive = &registry->gauge("arena_alive_npcs", "Alive NPC in the last published frame");
+    instruments.frame_publish = &registry->histogram("arena_frame_publish_seconds", "Time to capture and publish a frame",
+                                                     MetricHistogram::NANOSECONDS);
+    instruments.reclaim = &registry->histogram("arena_reclaim_seconds", "Time of one reclaim_dead pass",
+                                               MetricHistogram::NANOSECONDS);
+}
+
+Arena::~Arena() {
+    // NPC могут пережить арену (снимки, тесты) - возвращаем им состояние
+    for (auto& npc : by_id) {
+        if (npc) npc->unbind();
+    }
+}
+
+std::shared_ptr<const NameTable> Arena::names() const {
+    std::shared_lock<std::shared_mutex> lock(npcs_mutex);
+    return name_table;
+}
+
+std::shared_ptr<NPC> Arena::npc(WorldStore::Id id) const {
+    std::shared_lock<std::shared_mutex> lock(npcs_mutex);
+    return id < by_id.size() ? by_id[id] : nullptr;
+}
+
+WorldStore::Id Arena::add_npc_locked(const std::shared_ptr<NPC>& npc) {
+    npc->unbind();
+    auto [x, y] = npc->position();
+    const auto id = world_store.add(npc->type, x, y, npc->is_alive(), name_table->intern(npc->name));
+    npc->bind(world_store, id);
+    if (id < by_id.size()) {
+        by_id[id] = npc; // слот из списка свободных
+    } else {
+        by_id.push_back(npc);
+    }
     npcs.push_back(npc);
+    if (instruments.added) instruments.added->add();
+    return id;
+}
+
+void Arena::publish_spawns(const std::vector<WorldStore::Id>& ids, const std::shared_ptr<const NameTable>& table) {
+    for (const auto id : ids) {
+        bus.publish(SpawnEvent{table, world_store.name(id), world_store.type(id), world_store.x(id), world_store.y(id)});
+    }
+}
+
+void Arena::subscribe_loggers(const std::shared_ptr<Observer>& file_obs, const std::shared_ptr<Observer>& console_obs) {
+    bus.subscribe(file_obs, EventFilter::only(EventType::Kill));
+    bus.subscribe(console_obs, EventFilter::only(EventType::Kill));
+}
+
+void Arena::clear_locked() {
+    for (auto& npc : by_id) {
+        if (npc) npc->unbind();
+    }
+    by_id.clear();
+    npcs.clear();
+    world_store.clear();
+    // Старую таблицу держат ещё не выведенные события
+    name_table = std::make_shared<NameTable>();
+}
+
+std::vector<std::shared_ptr<NPC>> Arena::spawn(const std::vector<NpcSpec>& specs) {
+    auto batch = Factory::CreateNPCs(specs, npc_pool, cfg);
+    add_npcs(batch);
+    return batch;
+}
+
+std::size_t Arena::reclaim_dead() {
+    ScopedTimer timer(instruments.reclaim);
+    std::unique_lock<std::shared_mutex> lock(npcs_mutex);
+    std::size_t reclaimed = 0;
+    for (std::size_t i = 0; i < by_id.size(); ++i) {
+        auto& npc = by_id[i];
+        const auto id = static_cast<WorldStore::Id>(i);
+        if (!npc || world_store.is_alive(id)) continue;
+        npc->unbind();
+        npc.reset();
+        world_store.retire(id);
+        ++reclaimed;
+    }
+    if (reclaimed > 0) {
+        npcs.erase(std::remove_if(npcs.begin(), npcs.end(),
+                                  [&](const std::shared_ptr<NPC>& npc) {
+                                      WorldStore::Id id;
+                                      return !npc->bound_id(world_store, id);
+                                  }),
+                   npcs.end());
+    }
+    if (instruments.reclaimed) instruments.reclaimed->add(reclaimed);
+    return reclaimed;
+}
+
+void Arena::add_npc(std::shared_ptr<NPC> npc) {
+    add_npcs({npc});
+}
+
+void Arena::add_npcs(const std::vector<std::shared_ptr<NPC>>& batch) {
+    // Наблюдатели вызываются после снятия блокировки - им можно обращаться к арене
+    const bool announce = bus.wants(EventType::Spawn);
+    std::vector<WorldStore::Id> added;
+    std::shared_ptr<const NameTable> table;
+    {
+        std::unique_lock<std::shared_mutex> lock(npcs_mutex);
+        npcs.reserve(npcs.size() + batch.size());
+        by_id.reserve(by_id.size() + batch.size());
+        if (announce) added.reserve(batch.size());
+        for (const auto& npc : batch) {
+            const auto id = add_npc_locked(npc);
+            if (announce) added.push_back(id);
+        }
+        table = name_table;
+    }
+    if (announce) publish_spawns(added, table);
 }
 
 void Arena::save(const std::string& filename) {
-    std::shared_lock<std::shared_mutex> lock(npcs_mutex);
+    WorldFrame frame;
+    capture_frame(frame);
+    save(filename, frame);
+}
+
+void Arena::save(const std::string& filename, const WorldFrame& frame) {
     std::ofstream fs(filename);
     if (!fs.is_open()) {
         std::cerr << "Error: Could not open file for saving" << std::endl;
         return;
     }
-    fs << npcs.size() << std::endl;
-    for (auto& npc : npcs) {
-        npc->save(fs);
+    // Формат тот же, что у NPC::save: "Тип x y имя". Флага живости в нём нет, поэтому
+    // убитые, но ещё не освобождённые reclaim_dead NPC не пишутся - иначе они оживут при загрузке
+    fs << frame.alive_count << std::endl;
+    for (const auto& e : frame.entries) {
+        if (!e.alive) continue;
+        fs << Factory::TypeName(e.type) << " " << e.x << " " << e.y << " " << frame.names->view(e.name) << "\n";
     }
 }
 
@@ -41,22 +205,181 @@ void Arena::load(const std::string& filename, std::shared_ptr<Observer> file_obs
     // Очищаем текущую арену перед загрузкой
     {
         std::unique_lock<std::shared_mutex> lock(npcs_mutex);
-        npcs.clear();
+        clear_locked();
     }
+    subscribe_loggers(file_obs, console_obs);
     
     int count;
     if (fs >> count) {
         for (int i = 0; i < count; ++i) {
-            auto npc = Factory::CreateNPC(fs);
-            if (npc) {
-                npc->attach(file_obs);
-                npc->attach(console_obs);
-                add_npc(npc);
-            }
+            auto npc = Factory::CreateNPC(fs, npc_pool, cfg);
+            if (npc) add_npc(npc);
         }
     }
 }
 
+void Arena::save_binary(const std::string& filename) {
+    WorldFrame frame;
+    capture_frame(frame);
+    save_binary(filename, frame);
+}
+
+void Arena::save_binary(const std::string& filename, const WorldFrame& frame) {
+    std::vector<Snapshot::Record> records(frame.entries.size());
+    std::string names;
+    for (std::size_t i = 0; i < frame.entries.size(); ++i) {
+        const auto& e = frame.entries[i];
+        const std::string_view name = frame.names->view(e.name);
+        if (name.size() > Snapshot::MAX_NAME_LENGTH) {
+            std::cerr << "Error: NPC name is too long for binary snapshot" << std::endl;
+            return;
+        }
+        // Смещение имени хранится в 32 битах
+        if (names.size() > std::numeric_limits<std::uint32_t>::max()) {
+            std::cerr << "Error: NPC name table is too large for binary snapshot" << std::endl;
+            return;
+        }
+        Snapshot::Record& r = records[i];
+        r = Snapshot::Record{};
+        r.x = e.x;
+        r.y = e.y;
+        r.name_offset = static_cast<std::uint32_t>(names.size());
+        r.name_length = static_cast<std::uint16_t>(name.size());
+        r.type = static_cast<std::uint8_t>(e.type);
+        r.alive = e.alive ? 1 : 0;
+        names += name;
+    }
+
+    Snapshot::Header header{};
+    std::memcpy(header.magic, Snapshot::MAGIC, sizeof(header.magic));
+    header.version = Snapshot::VERSION;
+    header.endian_tag = Snapshot::ENDIAN_TAG;
+    header.record_size = sizeof(Snapshot::Record);
+    header.count = records.size();
+    header.names_size = names.size();
+
+    std::ofstream fs(filename, std::ios::binary | std::ios::trunc);
+    if (!fs.is_open()) {
+        std::cerr << "Error: Could not open file for saving" << std::endl;
+        return;
+    }
+
+    fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fs.write(reinterpret_cast<const char*>(records.data()),
+             static_cast<std::streamsize>(records.size() * sizeof(Snapshot::Record)));
+    fs.write(names.data(), static_cast<std::streamsize>(names.size()));
+}
+
+void Arena::load_binary(const std::string& filename, std::shared_ptr<Observer> file_obs, std::shared_ptr<Observer> console_obs) {
+    MappedFile file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file for loading" << std::endl;
+        return;
+    }
+
+    Snapshot::Header header{};
+    if (file.size() < sizeof(header)) {
+        std::cerr << "Error: Snapshot is truncated" << std::endl;
+        return;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, Snapshot::MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "Error: Not an arena snapshot" << std::endl;
+        return;
+    }
+    if (header.version != Snapshot::VERSION || header.endian_tag != Snapshot::ENDIAN_TAG ||
+        header.record_size != sizeof(Snapshot::Record)) {
+        std::cerr << "Error: Unsupported snapshot version or byte order" << std::endl;
+        return;
+    }
+
+    // Размеры сверяются с остатком файла по отдельности: сумма могла бы переполниться
+    const std::uint64_t payload = file.size() - sizeof(header);
+    if (header.count > payload / sizeof(Snapshot::Record)) {
+        std::cerr << "Error: Snapshot is truncated" << std::endl;
+        return;
+    }
+    const std::uint64_t records_size = header.count * sizeof(Snapshot::Record);
+    if (header.names_size > payload - records_size) {
+        std::cerr << "Error: Snapshot is truncated" << std::endl;
+        return;
+    }
+
+    const char* records = file.data() + sizeof(header);
+    const char* names = records + records_size;
+    std::vector<std::shared_ptr<NPC>> loaded;
+    loaded.reserve(static_cast<std::size_t>(header.count));
+    for (std::uint64_t i = 0; i < header.count; ++i) {
+        Snapshot::Record r;
+        std::memcpy(&r, records + i * sizeof(Snapshot::Record), sizeof(r));
+        if (static_cast<std::uint64_t>(r.name_offset) + r.name_length > header.names_size) {
+            std::cerr << "Error: Snapshot name table is corrupted" << std::endl;
+            return;
+        }
+        // Factory::CreateNPC бросил бы исключение - испорченный файл должен давать ошибку, а не падение
+        const NpcType type = static_cast<NpcType>(r.type);
+        if (type != OrkType && type != WillianType && type != WerewolfType) {
+            std::cerr << "Error: Snapshot has unknown NPC type " << static_cast<int>(r.type) << std::endl;
+            return;
+        }
+        if (r.x < 0 || r.x >= cfg.map_width || r.y < 0 || r.y >= cfg.map_height) {
+            std::cerr << "Error: Snapshot NPC is outside the map" << std::endl;
+            return;
+        }
+
+        auto npc = Factory::CreateNPC(type,
+                                      std::string(names + r.name_offset, r.name_length), r.x, r.y, npc_pool, cfg);
+        if (!r.alive) npc->kill();
+        loaded.push_back(std::move(npc));
+    }
+
+    subscribe_loggers(file_obs, console_obs);
+    replace_all(loaded);
+}
+
+std::vector<LoadError> Arena::load_fast(const std::string& filename, std::shared_ptr<Observer> file_obs,
+                                        std::shared_ptr<Observer> console_obs, WorkStealingPool* pool) {
+    MappedFile file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file for loading" << std::endl;
+        return {LoadError{0, "could not open file"}};
+    }
+
+    // Маленькие файлы разбираются в одном потоке
+    std::unique_ptr<WorkStealingPool> own_pool;
+    if (!pool && file.size() >= FAST_LOAD_PARALLEL_BYTES) {
+        own_pool = std::make_unique<WorkStealingPool>();
+        pool = own_pool.get();
+    }
+
+    TextScenario scenario = parse_text_scenario(file.data(), file.size(), pool, npc_pool, cfg);
+    for (const auto& error : scenario.errors) {
+        std::cerr << "Error: " << filename << ":" << error.line << ": " << error.message << std::endl;
+    }
+    subscribe_loggers(file_obs, console_obs);
+    replace_all(scenario.npcs);
+    return std::move(scenario.errors);
+}
+
+void Arena::replace_all(const std::vector<std::shared_ptr<NPC>>& loaded) {
+    const bool announce = bus.wants(EventType::Spawn);
+    std::vector<WorldStore::Id> added;
+    std::shared_ptr<const NameTable> table;
+    {
+        std::unique_lock<std::shared_mutex> lock(npcs_mutex);
+        clear_locked();
+        npcs.reserve(loaded.size());
+        by_id.reserve(loaded.size());
+        if (announce) added.reserve(loaded.size());
+        for (const auto& npc : loaded) {
+            const auto id = add_npc_locked(npc);
+            if (announce) added.push_back(id);
+        }
+        table = name_table;
+    }
+    if (announce) publish_spawns(added, table);
+}
+
 void Arena::print() {
     std::shared_lock<std::shared_mutex> lock(npcs_mutex);
     {
@@ -68,30 +391,67 @@ void Arena::print() {
     }
 }
 
-void Arena::fight(int distance) {
+void Arena::fight(int distance, WorkStealingPool* pool) {
     std::vector<std::shared_ptr<NPC>> snapshot;
+    std::vector<std::shared_ptr<NPC>> ids;
     {
         std::shared_lock<std::shared_mutex> lock(npcs_mutex);
         snapshot = npcs;
+        ids = by_id;
+    }
+
+    // Отрицательная дистанция раньше приводилась к size_t - то есть "любое расстояние"
+    const int radius = distance < 0 ? std::numeric_limits<int>::max() : distance;
+    SpatialGrid grid(cfg.map_width, cfg.map_height,
+                     std::clamp(radius, SpatialGrid::DEFAULT_CELL_SIZE, std::max(cfg.map_width, cfg.map_height)));
+    grid.rebuild(world_store);
+
+    // Пары (атакующий, защищающийся) по кускам атакующих; внутри атакующего - в порядке id,
+    // как при прежнем полном переборе, поэтому уведомления идут в том же порядке
+    const std::size_t chunks = (snapshot.size() + FIGHT_GRAIN - 1) / FIGHT_GRAIN;
+    std::vector<std::vector<std::pair<WorldStore::Id, WorldStore::Id>>> kills(chunks);
+
+    auto scan = [&](std::size_t from, std::size_t to) {
+        auto& out = kills[from / FIGHT_GRAIN];
+        std::vector<std::size_t> targets;
+        for (std::size_t i = from; i < to; ++i) {
+            const NPC& attacker = *snapshot[i];
+            WorldStore::Id id;
+            if (!attacker.bound_id(world_store, id) || !world_store.is_alive(id)) continue;
+
+            const unsigned prey = CombatRules::prey_mask_for(world_store.type(id));
+            if (prey == 0) continue;
+
+            targets.clear();
+            grid.within(world_store.x(id), world_store.y(id), radius, prey, id, targets);
+            std::sort(targets.begin(), targets.end());
+            for (const std::size_t target : targets) {
+                out.emplace_back(id, static_cast<WorldStore::Id>(target));
+            }
+        }
+    };
+    if (pool && chunks > 1) {
+        pool->parallel_for(0, snapshot.size(), FIGHT_GRAIN, scan);
+    } else {
+        for (std::size_t from = 0; from < snapshot.size(); from += FIGHT_GRAIN) {
+            scan(from, std::min(snapshot.size(), from + FIGHT_GRAIN));
+        }
     }
-    std::vector<std::shared_ptr<NPC>> dead_list;
-
-    for (const auto& attacker : snapshot) {
-        for (const auto& defender : snapshot) {
-            if (attacker == defender) continue;
-            
-            if (attacker->is_close(defender, distance)) {
-                // Создаем посетителя который защищает defender
-                CombatVisitor v(defender);
-                // attacker принимает посетителя
-                attacker->accept(v);
-
-                if (v.is_success()) {
-                    // Атака успешна
-                    defender->notify(attacker->name + " killed " + defender->name, true);
-                    dead_list.push_back(defender);
-                }
+
+    // События собираются, только если на убийства кто-то подписан
+    const bool announce = bus.wants(EventType::Kill);
+    const auto table = announce ? names() : nullptr;
+    std::vector<WorldStore::Id> dead_list;
+    for (const auto& chunk : kills) {
+        for (const auto& [attacker_id, defender_id] : chunk) {
+            if (!ids[attacker_id] || !ids[defender_id]) continue;
+            // Атака успешна
+            if (announce) {
+                bus.publish(KillEvent{table, world_store.name(attacker_id), world_store.name(defender_id), 0, 0,
+                                      world_store.type(attacker_id), world_store.type(defender_id),
+                                      world_store.x(defender_id), world_store.y(defender_id)});
             }
+            dead_list.push_back(defender_id);
         }
     }
 
@@ -105,13 +465,19 @@ void Arena::fight(int distance) {
 
         {
             std::unique_lock<std::shared_mutex> lock(npcs_mutex);
-            for (auto& dead : dead_list) {
-                npcs.erase(
-                    std::remove(npcs.begin(), npcs.end(), dead),
-                    npcs.end()
-                );
+            for (const auto id : dead_list) {
+                world_store.kill(id);
             }
+            count_kills(dead_list.size());
+            // Один проход сжатия вместо erase на каждого убитого
+            npcs.erase(std::remove_if(npcs.begin(), npcs.end(),
+                                      [&](const std::shared_ptr<NPC>& npc) {
+                                          WorldStore::Id id;
+                                          return npc->bound_id(world_store, id) &&
+                                                 std::binary_search(dead_list.begin(), dead_list.end(), id);
+                                      }),
+                       npcs.end());
             std::cout << "Battle ended. These Legends survived: " << npcs.size() << std::endl;
         }
     }
-}
\ No newline at end of file
+}
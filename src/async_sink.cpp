@@ -0,0 +1,157 @@
+#include "../include/async_sink.h"
+#include <algorithm>
+
+AsyncSink::AsyncSink(WriteFn write, AsyncSinkOptions options)
+    : write(std::move(write)), options(std::move(options)) {
+    this->options.queue_capacity = std::max<std::size_t>(1, this->options.queue_capacity);
+    ring.resize(this->options.queue_capacity);
+    writer = std::thread([this]() { writer_loop(); });
+}
+
+AsyncSink::~AsyncSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    has_work.notify_all();
+    has_space.notify_all();
+    writer.join();
+}
+
+bool AsyncSink::acquire_slot(std::unique_lock<std::mutex>& lock) {
+    if (queued >= ring.size()) {
+        if (options.drop_when_full || stopping) {
+            ++dropped_count;
+            if (instruments.dropped) instruments.dropped->add();
+            return false;
+        }
+        has_work.notify_one();
+        has_space.wait(lock, [&]() { return stopping || queued < ring.size(); });
+        if (stopping) {
+            ++dropped_count;
+            if (instruments.dropped) instruments.dropped->add();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AsyncSink::commit_slot() {
+    ++queued;
+    ++submitted;
+    if (instruments.lines) {
+        instruments.lines->add();
+        instruments.queue_depth->set(static_cast<std::int64_t>(queued));
+    }
+    // Будим писателя сразу только если очередь заполнилась наполовину
+    return queued * 2 >= ring.size();
+}
+
+bool AsyncSink::submit(std::string line) {
+    bool wake = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!acquire_slot(lock)) return false;
+        Record& slot = ring[tail()];
+        slot.text = std::move(line);
+        slot.is_event = false;
+        wake = commit_slot();
+    }
+    if (wake) has_work.notify_one();
+    return true;
+}
+
+bool AsyncSink::submit(const KillEvent& event) {
+    bool wake = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!acquire_slot(lock)) return false;
+        Record& slot = ring[tail()];
+        slot.event = event;
+        slot.is_event = true;
+        wake = commit_slot();
+    }
+    if (wake) has_work.notify_one();
+    return true;
+}
+
+void AsyncSink::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const std::uint64_t target = submitted;
+    flush_requested = std::max(flush_requested, target);
+    has_work.notify_one();
+    written_cv.wait(lock, [&]() { return written >= target; });
+}
+
+void AsyncSink::set_metrics(MetricsRegistry* registry, const std::string& sink) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!registry) {
+        instruments = Instruments{};
+        return;
+    }
+    const std::string label = "{sink=\"" + sink + "\"}";
+    instruments.lines = &registry->counter("log_sink_lines_total" + label, "Lines accepted by the async log sink");
+    instruments.dropped = &registry->counter("log_sink_dropped_total" + label, "Lines dropped because the queue was full");
+    instruments.queue_depth = &registry->gauge("log_sink_queue_depth" + label, "Lines waiting for the sink writer");
+    instruments.write_time = &registry->histogram("log_sink_write_seconds" + label, "Time of one batched write",
+                                                 MetricHistogram::NANOSECONDS);
+}
+
+std::size_t AsyncSink::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped_count;
+}
+
+void AsyncSink::writer_loop() {
+    std::string buffer;
+    std::vector<Record> batch;
+    batch.reserve(ring.size());
+    std::uint64_t buffered = 0; // номер последней строки, попавшей в buffer
+    auto last_flush = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        has_work.wait_until(lock, last_flush + options.flush_interval, [&]() {
+            return stopping || flush_requested > written || queued * 2 >= ring.size();
+        });
+
+        for (; queued > 0; --queued) {
+            batch.push_back(std::move(ring[head]));
+            head = (head + 1) % ring.size();
+        }
+        if (instruments.queue_depth) instruments.queue_depth->set(0);
+        MetricHistogram* write_time = instruments.write_time;
+        buffered += batch.size();
+        const bool force = stopping || flush_requested > written;
+        const bool final_pass = stopping;
+        lock.unlock();
+        has_space.notify_all();
+
+        for (const auto& record : batch) {
+            buffer += options.line_prefix;
+            if (record.is_event) {
+                record.event.append_to(buffer);
+            } else {
+                buffer += record.text;
+            }
+            buffer += '\n';
+        }
+        batch.clear();
+
+        const auto now = std::chrono::steady_clock::now();
+        if (!buffer.empty() &&
+            (force || buffer.size() >= options.flush_bytes || now - last_flush >= options.flush_interval)) {
+            ScopedTimer timer(write_time);
+            write(buffer);
+            buffer.clear();
+        }
+        if (buffer.empty()) last_flush = now;
+
+        lock.lock();
+        if (buffer.empty()) {
+            written = buffered;
+            written_cv.notify_all();
+        }
+        if (final_pass && queued == 0) break;
+    }
+}
@@ -0,0 +1,163 @@
+#include "../include/batch_runner.h"
+#include "../include/arena.h"
+#include "../include/counter_rng.h"
+#include "../include/factory.h"
+#include "../include/fight_system.h"
+#include "../include/movement.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+namespace {
+// Остались ли живые пары "хищник - добыча"
+bool fights_possible(const std::size_t (&alive)[CombatRules::TYPE_COUNT]) {
+    unsigned alive_mask = 0;
+    for (int t = 0; t < CombatRules::TYPE_COUNT; ++t) {
+        if (alive[t] > 0) alive_mask |= CombatRules::type_bit(static_cast<NpcType>(t));
+    }
+    for (int t = 0; t < CombatRules::TYPE_COUNT; ++t) {
+        if (alive[t] > 0 && (CombatRules::prey_mask_for(static_cast<NpcType>(t)) & alive_mask)) return true;
+    }
+    return false;
+}
+
+void count_alive(const WorldStore& world, std::size_t (&alive)[CombatRules::TYPE_COUNT]) {
+    std::fill(std::begin(alive), std::end(alive), 0);
+    world.for_each_alive([&](WorldStore::Id id) {
+        const int t = static_cast<int>(world.type(id));
+        if (t >= 0 && t < CombatRules::TYPE_COUNT) ++alive[t];
+    });
+}
+} // namespace
+
+BatchRunner::BatchRunner(const RuntimeConfig& config) : config(config) {
+    ticks_limit = config.batch_max_ticks;
+    if (ticks_limit == 0) {
+        // Столько же тиков, сколько помещается в обычную игру
+        const int tick_ms = std::max(1, config.movement_tick_ms);
+        ticks_limit = std::max<std::size_t>(1, static_cast<std::size_t>(config.duration_seconds) * 1000 / tick_ms);
+    }
+}
+
+ArenaOutcome BatchRunner::run_arena(std::uint64_t seed) const {
+    // Расстановка и броски - те же потоки CounterRng, что и в Game: арена с зерном s
+    // совпадает с игрой, запущенной с --seed s
+    const CounterRng rng(seed);
+
+    Arena arena(config);
+    {
+        std::vector<NpcSpec> specs;
+        specs.reserve(config.npc_count);
+        for (std::size_t i = 0; i < config.npc_count; ++i) {
+            const int x = rng.uniform(0, config.map_width - 1, CounterRng::Spawn, i, 0);
+            const int y = rng.uniform(0, config.map_height - 1, CounterRng::Spawn, i, 1);
+            const auto type = static_cast<NpcType>(rng.uniform(1, 3, CounterRng::Spawn, i, 2));
+            specs.push_back(NpcSpec{type, Factory::TypeName(type) + std::string("_") + std::to_string(i), x, y});
+        }
+        arena.spawn(specs);
+    }
+
+    WorldStore& world = arena.world();
+    MovementSystem movement(config);
+    std::vector<FightTask> fights;
+    ArenaOutcome outcome;
+
+    count_alive(world, outcome.survivors);
+    while (outcome.ticks < ticks_limit) {
+        if (!fights_possible(outcome.survivors)) {
+            outcome.settled = true;
+            break;
+        }
+        ++outcome.ticks;
+
+        movement.step_in_place(world);
+
+        // Бои тика разрешаются сразу, в порядке сканирования; убитый раньше в этом тике не атакует
+        collect_fights(world, config, fights, outcome.ticks);
+        for (const auto& task : fights) {
+            if (resolve_fight(arena, rng, task) == FightResult::Killed) {
+                ++outcome.kills[static_cast<int>(world.type(task.attacker))];
+            }
+        }
+        count_alive(world, outcome.survivors);
+    }
+    if (!outcome.settled && !fights_possible(outcome.survivors)) outcome.settled = true;
+    return outcome;
+}
+
+BatchSummary BatchRunner::run(std::size_t arenas, std::uint64_t seed, std::size_t threads) const {
+    const auto started = std::chrono::steady_clock::now();
+
+    std::vector<ArenaOutcome> outcomes(arenas);
+    WorkStealingPool pool(threads);
+    pool.parallel_for(0, arenas, 1, [&](std::size_t from, std::size_t to) {
+        for (std::size_t i = from; i < to; ++i) {
+            outcomes[i] = run_arena(seed + i);
+        }
+    });
+
+    BatchSummary summary;
+    summary.arenas = arenas;
+    summary.npc_per_arena = config.npc_count;
+    summary.max_ticks = ticks_limit;
+    summary.seed = seed;
+
+    for (const auto& o : outcomes) {
+        int alive_types = 0;
+        int last_alive = -1;
+        for (int t = 0; t < CombatRules::TYPE_COUNT; ++t) {
+            summary.survivors[t] += o.survivors[t];
+            summary.kills[t] += o.kills[t];
+            if (o.survivors[t] > 0) {
+                ++summary.survived_in[t];
+                ++alive_types;
+                last_alive = t;
+            }
+        }
+        if (alive_types == 1) ++summary.sole_survivor_in[last_alive];
+
+        if (o.settled) {
+            summary.settle_ticks_min = summary.settled == 0 ? o.ticks : std::min(summary.settle_ticks_min, o.ticks);
+            summary.settle_ticks_max = std::max(summary.settle_ticks_max, o.ticks);
+            summary.settle_ticks_total += o.ticks;
+            ++summary.settled;
+        }
+    }
+
+    summary.wall_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return summary;
+}
+
+void print_summary(std::ostream& out, const BatchSummary& summary) {
+    const double arenas = static_cast<double>(std::max<std::size_t>(1, summary.arenas));
+
+    out << "=== Batch: " << summary.arenas << " arenas x " << summary.npc_per_arena << " NPC, up to "
+        << summary.max_ticks << " ticks, seed " << summary.seed << " ===\n";
+    out << std::left << std::setw(10) << "type" << std::right << std::setw(16) << "mean survivors"
+        << std::setw(14) << "survived %" << std::setw(14) << "sole win %" << std::setw(14) << "mean kills"
+        << "\n";
+    out << std::fixed;
+    for (int t = 1; t < CombatRules::TYPE_COUNT; ++t) {
+        out << std::left << std::setw(10) << Factory::TypeName(static_cast<NpcType>(t)) << std::right << std::setprecision(2)
+            << std::setw(16) << summary.survivors[t] / arenas
+            << std::setw(14) << 100.0 * summary.survived_in[t] / arenas
+            << std::setw(14) << 100.0 * summary.sole_survivor_in[t] / arenas
+            << std::setw(14) << summary.kills[t] / arenas << "\n";
+    }
+
+    out << "settled: " << summary.settled << " of " << summary.arenas << " arenas";
+    if (summary.settled > 0) {
+        out << ", ticks to settle mean " << std::setprecision(1)
+            << static_cast<double>(summary.settle_ticks_total) / static_cast<double>(summary.settled)
+            << " (min " << summary.settle_ticks_min << ", max " << summary.settle_ticks_max << ")";
+    }
+    out << "\n";
+    out << "wall time: " << std::setprecision(3) << summary.wall_seconds << " s ("
+        << std::setprecision(0) << (summary.wall_seconds > 0.0 ? summary.arenas / summary.wall_seconds : 0.0)
+        << " arenas/s)\n";
+    out.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,210 @@
+#include "../include/behavior_scheduler.h"
+#include "../include/combat_rules.h"
+#include "../include/movement.h"
+#include <algorithm>
+
+namespace {
+// Куски проснувшихся сопрограмм, раздаваемые потокам пула
+constexpr std::size_t BEHAVIOR_GRAIN = 256;
+
+bool within_distance(int ax, int ay, int bx, int by, int distance) {
+    const long long dx = static_cast<long long>(ax) - static_cast<long long>(bx);
+    const long long dy = static_cast<long long>(ay) - static_cast<long long>(by);
+    return dx * dx + dy * dy <= static_cast<long long>(distance) * static_cast<long long>(distance);
+}
+} // namespace
+
+BehaviorScheduler::BehaviorScheduler(Arena& arena, const RuntimeConfig& config, std::uint64_t seed)
+    : arena(arena), cfg(config), rng(seed), grid(config.map_width, config.map_height) {}
+
+void BehaviorScheduler::spawn(WorldStore::Id id, const Factory& factory) {
+    const WorldStore::Handle self = arena.world().handle(id);
+    std::size_t slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        slot = behaviors.size();
+        behaviors.emplace_back();
+    }
+    behaviors[slot] = factory(*this, self);
+    behaviors[slot].promise().self = self;
+    schedule(slot, 1);
+}
+
+void BehaviorScheduler::spawn_all(const Factory& factory) {
+    arena.world().for_each_alive([&](WorldStore::Id id) { spawn(id, factory); });
+}
+
+void BehaviorScheduler::schedule(std::size_t slot, std::uint64_t ticks) {
+    timers.push(Timer{current_tick + ticks, timer_seq++, slot});
+}
+
+bool BehaviorScheduler::owner_alive(std::size_t slot) const {
+    const WorldStore& store = arena.world();
+    const WorldStore::Handle self = behaviors[slot].promise().self;
+    return store.valid(self) && store.is_alive(self.id);
+}
+
+void BehaviorScheduler::retire(std::size_t slot) {
+    behaviors[slot].reset();
+    free_slots.push_back(slot);
+}
+
+void BehaviorScheduler::snapshot_positions() {
+    const WorldStore& store = arena.world();
+    const std::size_t count = store.size();
+    pos_x.resize(count);
+    pos_y.resize(count);
+    store.for_each_alive([&](WorldStore::Id id) {
+        pos_x[id] = store.x(id);
+        pos_y[id] = store.y(id);
+    });
+    grid.rebuild(store, pos_x, pos_y);
+}
+
+std::size_t BehaviorScheduler::nearest(WorldStore::Id self, unsigned type_mask) const {
+    return grid.nearest(pos_x[self], pos_y[self], type_mask, self);
+}
+
+void BehaviorScheduler::move(WorldStore::Id self, int new_x, int new_y) {
+    arena.world().set_position(self, new_x, new_y);
+    moved.fetch_add(1, std::memory_order_relaxed);
+}
+
+BehaviorTickStats BehaviorScheduler::tick(WorkStealingPool* pool) {
+    ++current_tick;
+    BehaviorTickStats stats;
+    const WorldStore& store = arena.world();
+
+    // Проснувшиеся по таймеру (в порядке постановки) и дождавшиеся цели
+    ready.clear();
+    while (!timers.empty() && timers.top().tick <= current_tick) {
+        ready.push_back(timers.top().slot);
+        timers.pop();
+    }
+    std::size_t kept = 0;
+    for (const std::size_t slot : range_waiters) {
+        auto& promise = behaviors[slot].promise();
+        const WorldStore::Handle self = promise.self;
+        const WorldStore::Handle target = promise.target;
+        if (!owner_alive(slot)) {
+            ready.push_back(slot); // снимается ниже
+        } else if (!store.valid(target) || !store.is_alive(target.id)) {
+            promise.in_range = false;
+            ready.push_back(slot);
+        } else if (within_distance(store.x(self.id), store.y(self.id), store.x(target.id), store.y(target.id),
+                                   promise.distance)) {
+            promise.in_range = true;
+            ready.push_back(slot);
+        } else {
+            range_waiters[kept++] = slot;
+        }
+    }
+    range_waiters.resize(kept);
+
+    // Погибшие не просыпаются
+    kept = 0;
+    for (const std::size_t slot : ready) {
+        if (owner_alive(slot)) {
+            ready[kept++] = slot;
+        } else {
+            retire(slot);
+            ++stats.finished;
+        }
+    }
+    ready.resize(kept);
+    if (ready.empty()) return stats;
+
+    snapshot_positions();
+    moved.store(0, std::memory_order_relaxed);
+    auto resume_range = [&](std::size_t from, std::size_t to) {
+        for (std::size_t i = from; i < to; ++i) behaviors[ready[i]].resume();
+    };
+    if (pool) pool->parallel_for(0, ready.size(), BEHAVIOR_GRAIN, resume_range);
+    else resume_range(0, ready.size());
+    stats.resumed = ready.size();
+    stats.moved = moved.load(std::memory_order_relaxed);
+
+    // Ожидания разбираются в порядке пробуждения - от пула не зависят
+    using Wait = Behavior::promise_type::Wait;
+    for (const std::size_t slot : ready) {
+        Behavior& behavior = behaviors[slot];
+        if (behavior.done()) {
+            retire(slot);
+            ++stats.finished;
+            continue;
+        }
+        auto& promise = behavior.promise();
+        switch (promise.wait) {
+            case Wait::Sleep:
+                schedule(slot, promise.ticks);
+                break;
+            case Wait::InRange:
+                range_waiters.push_back(slot);
+                break;
+            case Wait::Fight: {
+                const FightTask task{promise.self.id, promise.target.id, promise.self.generation,
+                                     promise.target.generation, current_tick};
+                promise.fight_result = resolve_fight(arena, rng, task);
+                ++stats.fights;
+                if (promise.fight_result == FightResult::Killed) ++stats.kills;
+                schedule(slot, 1);
+                break;
+            }
+        }
+    }
+    return stats;
+}
+
+Behavior hunt(BehaviorScheduler& scheduler, WorldStore::Handle self) {
+    const WorldStore& world = scheduler.world();
+    const WorldStore::Id id = self.id;
+    const NpcType type = world.type(id);
+    const int kill_distance = scheduler.config().kill_distance(type);
+    const int move_distance = scheduler.config().move_distance(type);
+    const int width = scheduler.config().map_width;
+    const int height = scheduler.config().map_height;
+    std::uint64_t pause = 1;
+
+    auto back_off = [&]() {
+        const std::uint64_t ticks = pause;
+        pause = std::min<std::uint64_t>(pause * 2, GameConfig::BEHAVIOR_MAX_SLEEP_TICKS);
+        return sleep_ticks(ticks);
+    };
+
+    while (true) {
+        const std::size_t prey = scheduler.nearest(id, CombatRules::prey_mask_for(type));
+        const std::size_t target = prey != SpatialGrid::npos ? prey : scheduler.nearest(id, CombatRules::ALL_TYPES);
+        if (target == SpatialGrid::npos) {
+            co_await back_off(); // на карте никого
+            continue;
+        }
+
+        const auto target_id = static_cast<WorldStore::Id>(target);
+        const int my_x = scheduler.x(id);
+        const int my_y = scheduler.y(id);
+        if (prey != SpatialGrid::npos && kill_distance > 0 &&
+            within_distance(my_x, my_y, scheduler.x(target_id), scheduler.y(target_id), kill_distance)) {
+            pause = 1;
+            co_await fight(world.handle(target_id));
+            continue;
+        }
+
+        const auto [new_x, new_y] = MovementSystem::step_towards(move_distance, my_x, my_y, scheduler.x(target_id),
+                                                                 scheduler.y(target_id), width, height);
+        if (new_x == my_x && new_y == my_y) {
+            // Сам не дойдёт: ждём, пока добыча подойдёт на удар, иначе пересматриваем реже
+            if (prey != SpatialGrid::npos && kill_distance > 0) {
+                co_await wait_in_range(world.handle(target_id), kill_distance);
+            } else {
+                co_await back_off();
+            }
+            continue;
+        }
+
+        pause = 1;
+        scheduler.move(id, new_x, new_y);
+        co_await next_tick();
+    }
+}
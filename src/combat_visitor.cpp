@@ -8,22 +8,13 @@
 // Орк убивает разбойника
 
 void CombatVisitor::visit(Ork& attacker) {
-    // Орк убивает разбойника
-    if (defender->type == WillianType) {
-        success = true;
-    }
+    success = CombatLogic::ork_kills(defender->type);
 }
 
 void CombatVisitor::visit(Willian& attacker) {
-    // Разбойник убивает оборотней
-    if (defender->type == WerewolfType) {
-        success = true;
-    }
+    success = CombatLogic::willian_kills(defender->type);
 }
 
 void CombatVisitor::visit(Werewolf& attacker) {
-    // Оборотень убивает разбойника
-    if (defender->type == WillianType) {
-        success = true;
-    }
-}
\ No newline at end of file
+    success = CombatLogic::werewolf_kills(defender->type);
+}
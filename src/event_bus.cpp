@@ -0,0 +1,96 @@
+#include "../include/event_bus.h"
+#include <algorithm>
+#include <mutex>
+
+EventFilter EventFilter::only(EventType type) {
+    EventFilter filter;
+    filter.events = event_bit(type);
+    return filter;
+}
+
+EventFilter& EventFilter::in_region(const MapRegion& r) {
+    has_region = true;
+    region = r;
+    return *this;
+}
+
+EventFilter& EventFilter::for_factions(unsigned mask) {
+    factions = mask;
+    return *this;
+}
+
+bool EventFilter::accepts(const KillEvent& e) const {
+    if (!(events & event_bit(EventType::Kill))) return false;
+    if (!(factions & (CombatRules::type_bit(e.attacker_type) | CombatRules::type_bit(e.defender_type)))) return false;
+    return !has_region || region.contains(e.x, e.y);
+}
+
+bool EventFilter::accepts(const SpawnEvent& e) const {
+    if (!(events & event_bit(EventType::Spawn))) return false;
+    if (!(factions & CombatRules::type_bit(e.type))) return false;
+    return !has_region || region.contains(e.x, e.y);
+}
+
+bool EventFilter::accepts(const MoveSummaryEvent&) const {
+    return (events & event_bit(EventType::MoveSummary)) != 0;
+}
+
+EventBus::SubscriptionId EventBus::subscribe(std::shared_ptr<Observer> observer, EventFilter filter) {
+    if (!observer) return 0;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    for (const auto& s : subs) {
+        if (s.observer == observer && s.filter == filter) return s.id;
+    }
+    const SubscriptionId id = next_id++;
+    subs.push_back(Subscription{id, std::move(observer), filter});
+    update_mask();
+    return id;
+}
+
+void EventBus::unsubscribe(SubscriptionId id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    subs.erase(std::remove_if(subs.begin(), subs.end(), [&](const Subscription& s) { return s.id == id; }),
+               subs.end());
+    update_mask();
+}
+
+std::size_t EventBus::subscriptions() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return subs.size();
+}
+
+void EventBus::update_mask() {
+    unsigned mask = 0;
+    for (const auto& s : subs) mask |= s.filter.events;
+    subscribed_events.store(mask, std::memory_order_release);
+}
+
+void EventBus::publish(const KillEvent& event) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const auto& s : subs) {
+        if (s.filter.accepts(event)) s.observer->on_kill(event);
+    }
+}
+
+void EventBus::publish(const SpawnEvent& event) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const auto& s : subs) {
+        if (s.filter.accepts(event)) s.observer->on_spawn(event);
+    }
+}
+
+void EventBus::publish(const MoveSummaryEvent& event) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const auto& s : subs) {
+        if (s.filter.accepts(event)) s.observer->on_move_summary(event);
+    }
+}
+
+void EventBus::flush() const {
+    std::vector<std::shared_ptr<Observer>> observers;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (const auto& s : subs) observers.push_back(s.observer);
+    }
+    for (const auto& o : observers) o->flush();
+}
@@ -0,0 +1,31 @@
+#include "../include/events.h"
+
+void SpawnEvent::append_to(std::string& out) const {
+    if (!names) return;
+    out += names->view(name);
+    out += " spawned at (";
+    out += std::to_string(x);
+    out += ", ";
+    out += std::to_string(y);
+    out += ')';
+}
+
+std::string SpawnEvent::to_string() const {
+    std::string out;
+    append_to(out);
+    return out;
+}
+
+void MoveSummaryEvent::append_to(std::string& out) const {
+    out += "tick ";
+    out += std::to_string(tick);
+    out += ": ";
+    out += std::to_string(moved);
+    out += " NPC moved";
+}
+
+std::string MoveSummaryEvent::to_string() const {
+    std::string out;
+    append_to(out);
+    return out;
+}
@@ -2,26 +2,84 @@
 #include "../include/ork.h"
 #include "../include/willian.h"
 #include "../include/werewolf.h"
-#include "../include/game_config.h"
+#include "../include/runtime_config.h"
 #include <fstream>
 
-std::shared_ptr<NPC> Factory::CreateNPC(const std::string& type, const std::string& name, int x, int y) {
-    if (x < 0 || x >= GameConfig::MAP_WIDTH || y < 0 || y >= GameConfig::MAP_HEIGHT) {
+namespace {
+void check_spec(NpcType type, int x, int y, const RuntimeConfig& config) {
+    if (x < 0 || x >= config.map_width || y < 0 || y >= config.map_height) {
         throw std::runtime_error("Coordinates out of range");
     }
-    
-    if (type == "Ork" || type == "ork") return std::make_shared<Ork>(x, y, name);
-    if (type == "Willian" || type == "willian") return std::make_shared<Willian>(x, y, name);
-    if (type == "Werewolf" || type == "werewolf") return std::make_shared<Werewolf>(x, y, name);
-    
-    throw std::runtime_error("Unknown NPC type");
+    if (type != OrkType && type != WillianType && type != WerewolfType) {
+        throw std::runtime_error("Unknown NPC type");
+    }
+}
+
+template <typename T>
+std::shared_ptr<NPC> make_npc(int x, int y, const std::string& name, const std::shared_ptr<NpcPool>& pool) {
+    if (pool) return std::allocate_shared<T>(NpcPoolAllocator<T>(pool), x, y, name);
+    return std::make_shared<T>(x, y, name);
+}
+
+// Без проверок: вызывающий уже сделал check_spec
+std::shared_ptr<NPC> make_checked(NpcType type, const std::string& name, int x, int y,
+                                  const std::shared_ptr<NpcPool>& pool) {
+    switch (type) {
+        case OrkType: return make_npc<Ork>(x, y, name, pool);
+        case WillianType: return make_npc<Willian>(x, y, name, pool);
+        default: return make_npc<Werewolf>(x, y, name, pool);
+    }
+}
+} // namespace
+
+NpcType Factory::ParseType(std::string_view type) {
+    if (type == "Ork" || type == "ork") return OrkType;
+    if (type == "Willian" || type == "willian") return WillianType;
+    if (type == "Werewolf" || type == "werewolf") return WerewolfType;
+    return Unknown;
+}
+
+const char* Factory::TypeName(NpcType type) {
+    switch (type) {
+        case OrkType: return "Ork";
+        case WillianType: return "Willian";
+        case WerewolfType: return "Werewolf";
+        default: return "Unknown";
+    }
 }
 
-std::shared_ptr<NPC> Factory::CreateNPC(std::istream& is) {
+std::shared_ptr<NPC> Factory::CreateNPC(const std::string& type, const std::string& name, int x, int y,
+                                        const std::shared_ptr<NpcPool>& pool, const RuntimeConfig& config) {
+    return CreateNPC(ParseType(type), name, x, y, pool, config);
+}
+
+std::shared_ptr<NPC> Factory::CreateNPC(NpcType type, const std::string& name, int x, int y,
+                                        const std::shared_ptr<NpcPool>& pool, const RuntimeConfig& config) {
+    check_spec(type, x, y, config);
+    return make_checked(type, name, x, y, pool);
+}
+
+std::shared_ptr<NPC> Factory::CreateNPC(std::istream& is, const std::shared_ptr<NpcPool>& pool,
+                                        const RuntimeConfig& config) {
     std::string type, name;
     int x, y;
     if (is >> type >> x >> y >> name) {
-        return CreateNPC(type, name, x, y);
+        return CreateNPC(type, name, x, y, pool, config);
     }
     return nullptr;
-}
\ No newline at end of file
+}
+
+std::vector<std::shared_ptr<NPC>> Factory::CreateNPCs(const std::vector<NpcSpec>& specs,
+                                                      const std::shared_ptr<NpcPool>& pool,
+                                                      const RuntimeConfig& config) {
+    for (const auto& s : specs) {
+        check_spec(s.type, s.x, s.y, config);
+    }
+
+    std::vector<std::shared_ptr<NPC>> out;
+    out.reserve(specs.size());
+    for (const auto& s : specs) {
+        out.push_back(make_checked(s.type, s.name, s.x, s.y, pool));
+    }
+    return out;
+}
@@ -0,0 +1,277 @@
+#include "../include/fight_system.h"
+#include "../include/combat_rules.h"
+#include "../include/spatial_grid.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace {
+std::uint64_t to_ns(std::chrono::steady_clock::time_point t) {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count());
+}
+
+std::uint64_t steady_ns() {
+    return to_ns(std::chrono::steady_clock::now());
+}
+} // namespace
+
+void collect_fights(const WorldStore& world, const RuntimeConfig& config, std::vector<FightTask>& batch,
+                    std::uint64_t tick) {
+    batch.clear();
+
+    // Кандидаты - из сетки по позициям живых, а не перебором всех пар
+    int max_kill = 0;
+    for (const NpcType type : {OrkType, WillianType, WerewolfType}) {
+        max_kill = std::max(max_kill, config.kill_distance(type));
+    }
+    if (max_kill <= 0) return;
+    SpatialGrid grid(config.map_width, config.map_height,
+                     std::clamp(max_kill, SpatialGrid::DEFAULT_CELL_SIZE,
+                                std::max(std::max(config.map_width, config.map_height), 1)));
+    grid.rebuild(world);
+
+    std::vector<std::size_t> found;
+    world.for_each_alive([&](WorldStore::Id attacker) {
+        const NpcType attacker_type = world.type(attacker);
+        const int kill_dist = config.kill_distance(attacker_type);
+        if (kill_dist <= 0) return;
+
+        found.clear();
+        grid.within(world.x(attacker), world.y(attacker), kill_dist, CombatRules::prey_mask_for(attacker_type),
+                    attacker, found);
+        // Защищающиеся по возрастанию id - тот же порядок, что у полного перебора
+        std::sort(found.begin(), found.end());
+
+        const std::uint32_t attacker_generation = world.generation(attacker);
+        for (const std::size_t defender : found) {
+            const auto id = static_cast<WorldStore::Id>(defender);
+            batch.push_back(FightTask{attacker, id, attacker_generation, world.generation(id), tick});
+        }
+    });
+}
+
+FightSystem::FightSystem(Arena& arena, std::size_t workers, std::size_t queue_capacity, FullQueuePolicy policy,
+                         std::uint64_t seed)
+    : arena(arena), policy(policy), rng(seed) {
+    workers = std::max<std::size_t>(1, workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        shards.push_back(std::make_unique<Shard>(queue_capacity));
+    }
+}
+
+FightSystem::~FightSystem() {
+    stop();
+}
+
+bool FightSystem::accept(WorldStore::Id attacker, std::uint32_t gen) {
+    WorldStore& world = arena.world();
+    auto& stamp = world.fight_stamp(attacker);
+    if (stamp.load(std::memory_order_relaxed) == gen) return true;
+    if (world.fights_in_flight(attacker).load(std::memory_order_acquire) > 0) return false;
+    stamp.store(gen, std::memory_order_relaxed);
+    return true;
+}
+
+void FightSystem::wake(Shard& shard) {
+    // Пара к sleepers.fetch_add в обработчике: либо он увидит задачу, либо мы - его
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (shard.sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(shard.sleep_mutex);
+        shard.sleep_cv.notify_one();
+    }
+}
+
+bool FightSystem::push(const FightTask& task) {
+    Shard& shard = *shards[shard_of(task.defender)];
+    auto& in_flight = arena.world().fights_in_flight(task.attacker);
+
+    // Счётчик увеличивается до push, чтобы обработчик не ушёл в минус
+    in_flight.fetch_add(1, std::memory_order_relaxed);
+    bool counted_overflow = false;
+    while (!shard.queue.try_push(task)) {
+        if (!counted_overflow) {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            counted_overflow = true;
+        }
+        if (policy == FullQueuePolicy::Drop || stopping.load()) {
+            in_flight.fetch_sub(1, std::memory_order_release);
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        wake(shard);
+        std::this_thread::yield();
+    }
+    enqueued.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::size_t FightSystem::enqueue(const std::vector<FightTask>& batch) {
+    const std::uint32_t gen = ++generation == 0 ? ++generation : generation;
+
+    // Одно чтение часов на пачку
+    const std::uint64_t stamp = instruments.lag ? steady_ns() : 0;
+
+    std::size_t added = 0;
+    for (const auto& task : batch) {
+        if (!accept(task.attacker, gen)) {
+            deduplicated.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (stamp == 0) {
+            if (push(task)) ++added;
+            continue;
+        }
+        FightTask stamped = task;
+        stamped.enqueued_ns = stamp;
+        if (push(stamped)) ++added;
+    }
+    std::size_t depth = 0;
+    for (auto& shard : shards) {
+        depth += shard->queue.size_approx();
+        wake(*shard);
+    }
+    if (instruments.depth) {
+        instruments.depth->observe(depth);
+        instruments.queued->set(static_cast<std::int64_t>(depth));
+    }
+    return added;
+}
+
+void FightSystem::set_metrics(MetricsRegistry* registry) {
+    if (!registry) {
+        instruments = Instruments{};
+        return;
+    }
+    instruments.lag = &registry->histogram("fight_lag_seconds", "Time from enqueue to the start of fight resolution",
+                                           MetricHistogram::NANOSECONDS);
+    instruments.depth = &registry->histogram("fight_queue_depth", "Fights waiting in all queues after each batch");
+    instruments.queued = &registry->gauge("fight_queued", "Fights waiting in all queues after the last batch");
+}
+
+bool FightSystem::enqueue(WorldStore::Id attacker, WorldStore::Id defender) {
+    const WorldStore& world = arena.world();
+    return enqueue(std::vector<FightTask>{
+               FightTask{attacker, defender, world.generation(attacker), world.generation(defender)}}) == 1;
+}
+
+void FightSystem::start() {
+    if (!workers.empty()) return;
+    stopping.store(false);
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        workers.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+void FightSystem::wait_idle() {
+    for (auto& shard : shards) {
+        while (!stopping.load() && (shard->queue.size_approx() > 0 || shard->busy.load())) {
+            wake(*shard);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+void FightSystem::stop() {
+    stopping.store(true);
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->sleep_mutex);
+        shard->sleep_cv.notify_all();
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    workers.clear();
+}
+
+std::vector<FightWorkerStats> FightSystem::stats() const {
+    std::vector<FightWorkerStats> result;
+    for (const auto& shard : shards) {
+        FightWorkerStats s;
+        s.processed = shard->processed.load();
+        s.kills = shard->kills.load();
+        s.busy_seconds = static_cast<double>(shard->busy_ns.load()) / 1e9;
+        result.push_back(s);
+    }
+    return result;
+}
+
+FightQueueStats FightSystem::queue_stats() const {
+    FightQueueStats s;
+    s.enqueued = enqueued.load();
+    s.deduplicated = deduplicated.load();
+    s.overflows = overflows.load();
+    s.dropped = dropped.load();
+    return s;
+}
+
+void FightSystem::worker_loop(std::size_t index) {
+    Shard& shard = *shards[index];
+
+    while (true) {
+        FightTask task;
+        // busy выставляется до pop, чтобы wait_idle не увидел "пусто и свободен" между ними
+        shard.busy.store(true);
+        if (!shard.queue.try_pop(task)) {
+            shard.busy.store(false);
+
+            // При остановке очередь дорабатывается до конца
+            if (stopping.load()) break;
+
+            std::unique_lock<std::mutex> lock(shard.sleep_mutex);
+            shard.sleepers.fetch_add(1);
+            shard.sleep_cv.wait(lock, [&]() { return stopping.load() || shard.queue.size_approx() > 0; });
+            shard.sleepers.fetch_sub(1);
+            continue;
+        }
+
+        arena.world().fights_in_flight(task.attacker).fetch_sub(1, std::memory_order_release);
+
+        const auto started = std::chrono::steady_clock::now();
+        if (task.enqueued_ns != 0 && instruments.lag) {
+            const std::uint64_t now_ns = to_ns(started);
+            instruments.lag->observe(now_ns > task.enqueued_ns ? now_ns - task.enqueued_ns : 0);
+        }
+        resolve(shard, task);
+        shard.processed.fetch_add(1, std::memory_order_relaxed);
+        shard.busy_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - started).count(),
+                                std::memory_order_relaxed);
+    }
+    shard.busy.store(false);
+}
+
+FightResult resolve_fight(Arena& arena, const CounterRng& rng, const FightTask& task, bool attacker_must_be_alive) {
+    WorldStore& world = arena.world();
+    if (world.generation(task.attacker) != task.attacker_generation ||
+        world.generation(task.defender) != task.defender_generation) {
+        return FightResult::Invalid; // слот освобождён после постановки задачи
+    }
+    if (!world.is_alive(task.defender)) return FightResult::Invalid;
+    if (attacker_must_be_alive && !world.is_alive(task.attacker)) return FightResult::Invalid;
+
+    if (!CombatRules::can_kill(world.type(task.attacker), world.type(task.defender))) return FightResult::Invalid;
+
+    const int attack = rng.d6(task.tick, task.attacker, task.defender, 0);
+    const int defense = rng.d6(task.tick, task.attacker, task.defender, 1);
+    if (attack <= defense) return FightResult::Survived;
+
+    world.kill(task.defender);
+    arena.count_kills(1);
+
+    // Без строк: текст соберут наблюдатели, которым он нужен
+    EventBus& bus = arena.events();
+    if (bus.wants(EventType::Kill)) {
+        bus.publish(KillEvent{arena.names(), world.name(task.attacker), world.name(task.defender),
+                              static_cast<std::uint8_t>(attack), static_cast<std::uint8_t>(defense),
+                              world.type(task.attacker), world.type(task.defender), world.x(task.defender),
+                              world.y(task.defender)});
+    }
+    return FightResult::Killed;
+}
+
+void FightSystem::resolve(Shard& shard, const FightTask& task) {
+    if (resolve_fight(arena, rng, task) == FightResult::Killed) {
+        shard.kills.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -1,337 +1,299 @@
 #include "../include/game.h"
 
-#include "../include/combat_visitor.h"
+#include "../include/behavior_scheduler.h"
+#include "../include/counter_rng.h"
 #include "../include/factory.h"
-#include "../include/game_config.h"
+#include "../include/fight_system.h"
+#include "../include/movement.h"
 #include "../include/output.h"
+#include "../include/renderer.h"
+#include "../include/runtime_config.h"
+#include "../include/sharded_world.h"
+#include "../include/sim_engine.h"
+#include "../include/thread_pool.h"
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <cmath>
-#include <condition_variable>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
-#include <limits>
 #include <mutex>
-#include <queue>
 #include <random>
-#include <sstream>
 #include <string>
 #include <thread>
-#include <unordered_set>
 #include <vector>
 
-namespace {
-int move_distance_for(NpcType type) {
-    switch (type) {
-        case OrkType: return GameConfig::ORK_MOVE_DISTANCE;
-        case WillianType: return GameConfig::WILLIAN_MOVE_DISTANCE;
-        case WerewolfType: return GameConfig::WEREWOLF_MOVE_DISTANCE;
-        default: return 0;
-    }
-}
-
-int kill_distance_for(NpcType type) {
-    switch (type) {
-        case OrkType: return GameConfig::ORK_KILL_DISTANCE;
-        case WillianType: return GameConfig::WILLIAN_KILL_DISTANCE;
-        case WerewolfType: return GameConfig::WEREWOLF_KILL_DISTANCE;
-        default: return 0;
+Game::Game(Arena& arena, std::shared_ptr<Observer> file_observer, std::shared_ptr<Observer> console_observer,
+           const RuntimeConfig& config)
+    : arena_(arena),
+      file_observer_(std::move(file_observer)),
+      console_observer_(std::move(console_observer)),
+      config_(config) {
+    // Без --seed зерно выбирается случайно; Game::seed() отдаёт его для повтора запуска
+    if (config_.seed == 0) {
+        // 0 означает "выбрать случайно", поэтому напечатанное зерно должно быть ненулевым
+        std::random_device rd;
+        do {
+            config_.seed = static_cast<std::uint64_t>(rd()) << 32 | rd();
+        } while (config_.seed == 0);
     }
-}
-
-char map_symbol_for(NpcType type) {
-    switch (type) {
-        case OrkType: return 'O';
-        case WillianType: return 'R'; // "Разбойник"
-        case WerewolfType: return 'W';
-        default: return '?';
+    // Логи получают только убийства - как раньше, когда наблюдатели висели на каждом NPC
+    arena_.events().subscribe(file_observer_, EventFilter::only(EventType::Kill));
+    arena_.events().subscribe(console_observer_, EventFilter::only(EventType::Kill));
+
+    if (config_.metrics) {
+        metrics_ = std::make_unique<MetricsRegistry>();
+        arena_.set_metrics(metrics_.get());
+        if (file_observer_) file_observer_->set_metrics(metrics_.get());
+        if (console_observer_) console_observer_->set_metrics(metrics_.get());
     }
 }
 
-bool within_distance(const std::pair<int, int>& a, const std::pair<int, int>& b, int distance) {
-    const long long dx = static_cast<long long>(a.first) - static_cast<long long>(b.first);
-    const long long dy = static_cast<long long>(a.second) - static_cast<long long>(b.second);
-    return dx * dx + dy * dy <= static_cast<long long>(distance) * static_cast<long long>(distance);
-}
-
-bool can_kill(const std::shared_ptr<NPC>& attacker, const std::shared_ptr<NPC>& defender) {
-    CombatVisitor v(defender);
-    attacker->accept(v);
-    return v.is_success();
-}
-
-int roll_d6(std::mt19937& rng) {
-    static std::uniform_int_distribution<int> dist(1, 6);
-    return dist(rng);
-}
-
-struct FightTask {
-    std::shared_ptr<NPC> attacker;
-    std::shared_ptr<NPC> defender;
-};
-
-struct PtrPairHash {
-    std::size_t operator()(const std::pair<const NPC*, const NPC*>& p) const noexcept {
-        const auto h1 = std::hash<const void*>{}(static_cast<const void*>(p.first));
-        const auto h2 = std::hash<const void*>{}(static_cast<const void*>(p.second));
-        return h1 ^ (h2 << 1);
-    }
-};
-
-std::string render_map(const std::vector<std::shared_ptr<NPC>>& npcs, int seconds_left) {
-    std::vector<std::string> grid(GameConfig::MAP_HEIGHT, std::string(GameConfig::MAP_WIDTH, '.'));
-
-    std::size_t alive_count = 0;
-    for (const auto& npc : npcs) {
-        if (!npc->is_alive()) continue;
-        ++alive_count;
-        auto [x, y] = npc->position();
-        if (x >= 0 && x < GameConfig::MAP_WIDTH && y >= 0 && y < GameConfig::MAP_HEIGHT) {
-            grid[y][x] = map_symbol_for(npc->type);
-        }
-    }
-
-    std::ostringstream out;
-    out << "Seconds left: " << seconds_left << " | Alive: " << alive_count << "\n";
-    for (const auto& row : grid) {
-        out << row << "\n";
-    }
-    return out.str();
+Game::~Game() {
+    if (!metrics_) return;
+    // Арена и наблюдатели переживают Game, а реестр - нет
+    arena_.set_metrics(nullptr);
+    if (file_observer_) file_observer_->set_metrics(nullptr);
+    if (console_observer_) console_observer_->set_metrics(nullptr);
 }
 
-} // namespace
-
-Game::Game(Arena& arena, std::shared_ptr<Observer> file_observer, std::shared_ptr<Observer> console_observer)
-    : arena_(arena), file_observer_(std::move(file_observer)), console_observer_(std::move(console_observer)) {}
-
 void Game::init_random_npcs(std::size_t count) {
-    std::random_device rd;
-    std::mt19937 rng(rd());
-
-    std::uniform_int_distribution<int> x_dist(0, GameConfig::MAP_WIDTH - 1);
-    std::uniform_int_distribution<int> y_dist(0, GameConfig::MAP_HEIGHT - 1);
-    std::uniform_int_distribution<int> type_dist(1, 3);
+    // NPC i получает одни и те же координаты и тип при том же зерне
+    const CounterRng rng(config_.seed);
 
+    // Пачка создаётся в пуле арены и добавляется под одной блокировкой - для запусков с миллионом NPC
+    std::vector<NpcSpec> specs;
+    specs.reserve(count);
     for (std::size_t i = 0; i < count; ++i) {
-        const int x = x_dist(rng);
-        const int y = y_dist(rng);
-        const int t = type_dist(rng);
-
-        std::string type;
-        switch (t) {
-            case 1: type = "Ork"; break;
-            case 2: type = "Willian"; break;
-            case 3: type = "Werewolf"; break;
-            default: type = "Ork"; break;
-        }
+        const int x = rng.uniform(0, config_.map_width - 1, CounterRng::Spawn, i, 0);
+        const int y = rng.uniform(0, config_.map_height - 1, CounterRng::Spawn, i, 1);
+        const auto type = static_cast<NpcType>(rng.uniform(OrkType, WerewolfType, CounterRng::Spawn, i, 2));
 
-        const std::string name = type + std::string("_") + std::to_string(i);
-        auto npc = Factory::CreateNPC(type, name, x, y);
-        npc->attach(file_observer_);
-        npc->attach(console_observer_);
-        arena_.add_npc(npc);
+        specs.push_back(NpcSpec{type, Factory::TypeName(type) + std::string("_") + std::to_string(i), x, y});
     }
+    arena_.spawn(specs);
 }
 
 void Game::run() {
-    std::mutex tasks_mutex;
-    std::condition_variable tasks_cv;
-    std::queue<FightTask> tasks;
-    std::unordered_set<std::pair<const NPC*, const NPC*>, PtrPairHash> pending;
+    if (config_.virtual_time || config_.headless) {
+        run_virtual();
+        return;
+    }
 
     std::atomic<bool> stop{false};
 
-    //  Fight thread 
-    std::thread fight_thread([&]() {
-        std::random_device rd;
-        std::mt19937 rng(rd());
-
-        while (true) {
-            FightTask task;
-            {
-                std::unique_lock<std::mutex> lock(tasks_mutex);
-                tasks_cv.wait(lock, [&]() { return stop.load() || !tasks.empty(); });
-
-                if (tasks.empty()) {
-                    if (stop.load()) break;
-                    continue;
-                }
-
-                task = std::move(tasks.front());
-                tasks.pop();
-
-                if (task.attacker && task.defender) {
-                    pending.erase({task.attacker.get(), task.defender.get()});
-                }
-            }
-
-            if (!task.attacker || !task.defender) continue;
-            if (!task.attacker->is_alive() || !task.defender->is_alive()) continue;
+    WorldStore& world = arena_.world();
+
+    //  Fight workers (по одному на шард защищающихся) - только для обычного движения:
+    //  сопрограммы и шарды разрешают бои сами
+    std::unique_ptr<FightSystem> fights;
+    if (!config_.behavior_coroutines && config_.shards == 0) {
+        fights = std::make_unique<FightSystem>(
+            arena_, config_.fight_workers, config_.fight_queue_capacity,
+            config_.fight_queue_drop_when_full ? FullQueuePolicy::Drop : FullQueuePolicy::Block, config_.seed);
+        fights->set_metrics(metrics_.get());
+        fights->start();
+    }
 
-            if (!can_kill(task.attacker, task.defender)) continue;
+    // Без метрик указатели пусты и ScopedTimer не читает часы
+    MetricHistogram* tick_time = nullptr;
+    MetricHistogram* render_time = nullptr;
+    MetricCounter* ticks = nullptr;
+    MetricCounter* moves = nullptr;
+    if (metrics_) {
+        tick_time = &metrics_->histogram("game_tick_seconds", "Movement tick without the sleep: move, fights, frame",
+                                         MetricHistogram::NANOSECONDS);
+        render_time = &metrics_->histogram("game_render_seconds", "Time to render and print one frame",
+                                           MetricHistogram::NANOSECONDS);
+        ticks = &metrics_->counter("game_ticks_total", "Movement ticks");
+        moves = &metrics_->counter("game_npc_moves_total", "NPC steps made by the movement thread");
+    }
 
-            const int attack = roll_d6(rng);
-            const int defense = roll_d6(rng);
+    // Отрисовка и отчёт читают кадры, которые публикует поток движения в конце такта
+    std::size_t tick = 0;
+    arena_.publish_frame(tick);
 
-            if (attack > defense) {
-                task.defender->kill();
-                task.defender->notify(task.attacker->name + " killed " + task.defender->name +
-                                         " (attack=" + std::to_string(attack) +
-                                         ", defense=" + std::to_string(defense) + ")",
-                                     true);
-            }
+    std::thread movement_thread([&]() {
+        MovementSystem movement(config_,
+                                config_.nearest_scan ? MovementSystem::Search::Scan : MovementSystem::Search::Grid);
+        std::unique_ptr<WorkStealingPool> pool;
+        if (config_.parallel_movement) {
+            pool = std::make_unique<WorkStealingPool>();
+        }
+        std::vector<FightTask> batch;
+        EventBus& bus = arena_.events();
+
+        // Сопрограммы сами двигаются и дерутся; обработчики боёв в этом режиме не запускаются
+        std::unique_ptr<BehaviorScheduler> behaviors;
+        if (config_.behavior_coroutines) {
+            behaviors = std::make_unique<BehaviorScheduler>(arena_, config_, config_.seed);
+            behaviors->spawn_all(hunt);
+        }
+        // Полосы карты двигаются и дерутся в своих потоках, тоже без очередей боёв
+        std::unique_ptr<ShardedWorld> sharded;
+        if (config_.shards > 0) {
+            sharded = std::make_unique<ShardedWorld>(arena_, config_, config_.shards, config_.shard_ghost_width,
+                                                     config_.seed);
         }
-    });
 
-    std::thread movement_thread([&]() {
         while (!stop.load()) {
-            auto snapshot = arena_.npcs_snapshot();
-
-            for (const auto& npc : snapshot) {
-                if (!npc->is_alive()) continue;
-
-                const auto my_pos = npc->position();
-                std::shared_ptr<NPC> best_target;
-                long long best_dist_sq = std::numeric_limits<long long>::max();
-
-                for (const auto& other : snapshot) {
-                    if (other == npc) continue;
-                    if (!other->is_alive()) continue;
-
-                    if (!can_kill(npc, other)) continue;
-
-                    const auto other_pos = other->position();
-                    const long long dx = static_cast<long long>(my_pos.first) - static_cast<long long>(other_pos.first);
-                    const long long dy = static_cast<long long>(my_pos.second) - static_cast<long long>(other_pos.second);
-                    const long long dist_sq = dx * dx + dy * dy;
-
-                    if (dist_sq < best_dist_sq) {
-                        best_dist_sq = dist_sq;
-                        best_target = other;
-                    }
-                }
-
-                if (!best_target) {
-                    for (const auto& other : snapshot) {
-                        if (other == npc) continue;
-                        if (!other->is_alive()) continue;
-
-                        const auto other_pos = other->position();
-                        const long long dx = static_cast<long long>(my_pos.first) - static_cast<long long>(other_pos.first);
-                        const long long dy = static_cast<long long>(my_pos.second) - static_cast<long long>(other_pos.second);
-                        const long long dist_sq = dx * dx + dy * dy;
-
-                        if (dist_sq < best_dist_sq) {
-                            best_dist_sq = dist_sq;
-                            best_target = other;
-                        }
-                    }
-                }
-
-                if (!best_target) continue;
-
-                const int step = move_distance_for(npc->type);
-                if (step <= 0) continue;
-
-                const auto target_pos = best_target->position();
-                const double dx = static_cast<double>(target_pos.first - my_pos.first);
-                const double dy = static_cast<double>(target_pos.second - my_pos.second);
-                const double dist = std::sqrt(dx * dx + dy * dy);
-                if (dist <= 0.0) continue;
-
-                int move_x = static_cast<int>(std::lround(static_cast<double>(step) * dx / dist));
-                int move_y = static_cast<int>(std::lround(static_cast<double>(step) * dy / dist));
-
-                if (move_x == 0 && move_y == 0) {
-                    if (std::abs(dx) >= std::abs(dy)) move_x = (dx > 0) ? 1 : -1;
-                    else move_y = (dy > 0) ? 1 : -1;
-                }
-
-                int new_x = my_pos.first + move_x;
-                int new_y = my_pos.second + move_y;
-
-                new_x = std::clamp(new_x, 0, GameConfig::MAP_WIDTH - 1);
-                new_y = std::clamp(new_y, 0, GameConfig::MAP_HEIGHT - 1);
-
-                npc->set_position(new_x, new_y);
+            // Пауза между тактами в замер не входит
+            const auto tick_start =
+                tick_time ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            std::size_t moved = 0;
+            if (behaviors) {
+                moved = behaviors->tick(pool.get()).moved;
+            } else if (sharded) {
+                moved = sharded->tick().moved;
+            } else {
+                moved = pool ? movement.step_buffered(world, pool.get()) : movement.step_in_place(world);
+            }
+            if (bus.wants(EventType::MoveSummary)) {
+                bus.publish(MoveSummaryEvent{tick + 1, moved});
             }
 
-            {
-                std::lock_guard<std::mutex> lock(tasks_mutex);
-                for (const auto& attacker : snapshot) {
-                    if (!attacker->is_alive()) continue;
-
-                    const int kill_dist = kill_distance_for(attacker->type);
-                    if (kill_dist <= 0) continue;
-
-                    const auto attacker_pos = attacker->position();
-
-                    for (const auto& defender : snapshot) {
-                        if (defender == attacker) continue;
-                        if (!defender->is_alive()) continue;
-
-                        const auto defender_pos = defender->position();
-                        if (!within_distance(attacker_pos, defender_pos, kill_dist)) continue;
-
-                        if (!can_kill(attacker, defender)) continue;
+            // Скан идёт без блокировок, бои уходят в lock-free очереди шардов
+            if (fights) {
+                collect_fights(world, config_, batch, tick);
+                fights->enqueue(batch);
+            }
 
-                        const auto key = std::make_pair(attacker.get(), defender.get());
-                        if (pending.insert(key).second) {
-                            tasks.push(FightTask{attacker, defender});
-                        }
-                    }
-                }
+            // Слоты убитых возвращаются в хранилище, чтобы проходы не тратились на мёртвых
+            ++tick;
+            if (config_.reclaim_period_ticks > 0 && tick % config_.reclaim_period_ticks == 0) {
+                arena_.reclaim_dead();
+            }
+            arena_.publish_frame(tick);
+            if (tick_time) {
+                tick_time->observe_since(tick_start);
+                ticks->add();
+                moves->add(moved);
             }
-            tasks_cv.notify_one();
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(GameConfig::MOVEMENT_TICK_MS));
+            std::this_thread::sleep_for(std::chrono::milliseconds(config_.movement_tick_ms));
         }
-
-        tasks_cv.notify_all();
     });
 
+    // В терминале кадры дорисовываются по разнице с прошлым, иначе - печатаются целиком
+    std::unique_ptr<DiffRenderer> diff_renderer;
+    if (config_.render_diff && DiffRenderer::stdout_is_terminal()) {
+        diff_renderer = std::make_unique<DiffRenderer>(config_);
+    }
+
     const auto start = std::chrono::steady_clock::now();
-    const auto end_time = start + std::chrono::seconds(GameConfig::GAME_DURATION_SECONDS);
+    const auto end_time = start + std::chrono::seconds(config_.duration_seconds);
+    const auto metrics_period = std::chrono::milliseconds(config_.metrics_period_ms);
+    auto next_dump = start + metrics_period;
 
     while (std::chrono::steady_clock::now() < end_time) {
         const auto now = std::chrono::steady_clock::now();
         const int seconds_left = static_cast<int>(
             std::chrono::duration_cast<std::chrono::seconds>(end_time - now).count());
 
-        auto snapshot = arena_.npcs_snapshot();
-        const std::string frame = render_map(snapshot, seconds_left);
         {
-            std::lock_guard<std::mutex> lock(Output::cout_mutex);
-            std::cout << frame << std::flush;
+            ScopedTimer timer(render_time);
+            const auto snapshot = arena_.frame();
+            if (diff_renderer) {
+                DiffRenderer::write_out(diff_renderer->render(*snapshot, seconds_left));
+            } else {
+                const std::string frame = render_map(*snapshot, seconds_left, config_);
+                std::lock_guard<std::mutex> lock(Output::cout_mutex);
+                std::cout << frame << std::flush;
+            }
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(GameConfig::RENDER_PERIOD_MS));
+        // Сброс метрик в файл - из потока отрисовки, симуляцию он не задерживает
+        if (metrics_ && now >= next_dump) {
+            metrics_->dump(config_.metrics_file);
+            next_dump = now + metrics_period;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(config_.render_period_ms));
     }
 
     stop.store(true);
-    tasks_cv.notify_all();
 
     movement_thread.join();
-    fight_thread.join();
+    if (fights) fights->stop();
+
+    // Логи боёв должны быть выведены до списка выживших
+    if (file_observer_) file_observer_->flush();
+    if (console_observer_) console_observer_->flush();
+    if (diff_renderer) DiffRenderer::write_out(diff_renderer->finish());
 
-    {
-        auto snapshot = arena_.npcs_snapshot();
+    // Последний кадр - после остановки боёв, чтобы в отчёт попали все убийства
+    arena_.publish_frame(tick);
+    print_survivors();
+    if (fights) {
         std::lock_guard<std::mutex> lock(Output::cout_mutex);
-        std::cout << "\n=== Survivors ===\n";
-        for (const auto& npc : snapshot) {
-            if (!npc->is_alive()) continue;
-            auto [x, y] = npc->position();
-            std::cout << npc->name << " (";
-            switch (npc->type) {
-                case OrkType: std::cout << "Ork"; break;
-                case WillianType: std::cout << "Willian"; break;
-                case WerewolfType: std::cout << "Werewolf"; break;
-                default: std::cout << "Unknown"; break;
-            }
-            std::cout << ") at {" << x << ", " << y << "}\n";
+        // Пропускная способность обработчиков боёв - для подбора FIGHT_WORKERS
+        std::cout << "\n=== Fight workers ===\n";
+        const auto stats = fights->stats();
+        for (std::size_t i = 0; i < stats.size(); ++i) {
+            const double rate = stats[i].busy_seconds > 0.0
+                                    ? static_cast<double>(stats[i].processed) / stats[i].busy_seconds
+                                    : 0.0;
+            std::cout << "worker " << i << ": " << stats[i].processed << " fights, " << stats[i].kills
+                      << " kills, busy " << std::fixed << std::setprecision(3) << stats[i].busy_seconds
+                      << "s (" << std::setprecision(0) << rate << " fights/s)\n";
         }
+        const auto queue = fights->queue_stats();
+        std::cout << "queue: " << queue.enqueued << " enqueued, " << queue.deduplicated << " deduplicated, "
+                  << queue.overflows << " overflows, " << queue.dropped << " dropped\n";
     }
+    report_metrics();
+}
+
+void Game::run_virtual() {
+    SimEngine engine(arena_, config_, config_.seed);
+
+    std::unique_ptr<DiffRenderer> diff_renderer;
+    if (!config_.headless) {
+        if (config_.render_diff && DiffRenderer::stdout_is_terminal()) {
+            diff_renderer = std::make_unique<DiffRenderer>(config_);
+        }
+        engine.on_render([&](const WorldFrame& frame, int seconds_left) {
+            if (diff_renderer) {
+                DiffRenderer::write_out(diff_renderer->render(frame, seconds_left));
+            } else {
+                const std::string text = render_map(frame, seconds_left, config_);
+                std::lock_guard<std::mutex> lock(Output::cout_mutex);
+                std::cout << text << std::flush;
+            }
+        });
+    }
+
+    const SimStats stats = engine.run(config_.headless ? SimEngine::Pacing::Headless : SimEngine::Pacing::RealTime);
+
+    if (file_observer_) file_observer_->flush();
+    if (console_observer_) console_observer_->flush();
+    if (diff_renderer) DiffRenderer::write_out(diff_renderer->finish());
+
+    print_survivors();
+    std::unique_lock<std::mutex> lock(Output::cout_mutex);
+    std::cout << "\n=== Simulation ===\n"
+              << std::fixed << std::setprecision(3) << static_cast<double>(stats.virtual_ms) / 1000.0
+              << "s virtual in " << stats.wall_seconds << "s wall: " << stats.events << " events, " << stats.ticks
+              << " ticks, " << stats.fights << " fights, " << stats.kills << " kills\n";
+    lock.unlock();
+    report_metrics();
+}
+
+void Game::print_survivors() const {
+    const auto snapshot = arena_.frame();
+    std::lock_guard<std::mutex> lock(Output::cout_mutex);
+    std::cout << "\n=== Survivors ===\n";
+    snapshot->for_each_alive([&](const WorldFrame::Entry& e) {
+        std::cout << snapshot->names->view(e.name) << " (" << Factory::TypeName(e.type) << ") at {" << e.x << ", "
+                  << e.y << "}\n";
+    });
+}
+
+void Game::report_metrics() {
+    if (!metrics_) return;
+    metrics_->dump(config_.metrics_file);
+    std::lock_guard<std::mutex> lock(Output::cout_mutex);
+    std::cout << "\n=== Metrics (" << config_.metrics_file << ") ===\n";
+    metrics_->write_summary(std::cout);
 }
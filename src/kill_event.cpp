@@ -0,0 +1,29 @@
+#include "../include/kill_event.h"
+#include <charconv>
+
+namespace {
+void append_number(std::string& out, unsigned value) {
+    char buf[8];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, static_cast<std::size_t>(end - buf));
+}
+} // namespace
+
+void KillEvent::append_to(std::string& out) const {
+    if (!names) return;
+    out += names->view(attacker);
+    out += " killed ";
+    out += names->view(defender);
+    if (attack == 0 && defense == 0) return;
+    out += " (attack=";
+    append_number(out, attack);
+    out += ", defense=";
+    append_number(out, defense);
+    out += ')';
+}
+
+std::string KillEvent::to_string() const {
+    std::string out;
+    append_to(out);
+    return out;
+}
@@ -0,0 +1,49 @@
+#include "../include/mapped_file.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef MAPPED_FILE_USE_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st {};
+    if (::fstat(fd, &st) == 0) {
+        length = static_cast<std::size_t>(st.st_size);
+        if (length == 0) {
+            opened = true;
+        } else {
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                ::madvise(p, length, MADV_SEQUENTIAL);
+                mapping = p;
+                bytes = static_cast<const char*>(p);
+                opened = true;
+            }
+        }
+    }
+    ::close(fd);
+#else
+    std::ifstream fs(filename, std::ios::binary | std::ios::ate);
+    if (!fs.is_open()) return;
+    fallback.resize(static_cast<std::size_t>(fs.tellg()));
+    fs.seekg(0);
+    fs.read(fallback.data(), static_cast<std::streamsize>(fallback.size()));
+    bytes = fallback.data();
+    length = fallback.size();
+    opened = true;
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef MAPPED_FILE_USE_MMAP
+    if (mapping) ::munmap(mapping, length);
+#endif
+}
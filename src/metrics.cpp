@@ -0,0 +1,168 @@
+#include "../include/metrics.h"
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+std::string format_number(double value, int precision = 10) {
+    std::ostringstream out;
+    out << std::setprecision(precision) << value;
+    return out.str();
+}
+
+std::string family_of(const std::string& name) {
+    return name.substr(0, name.find('{'));
+}
+
+// Метки без фигурных скобок: "sink=\"file\"" или пусто
+std::string labels_of(const std::string& name) {
+    const auto open = name.find('{');
+    if (open == std::string::npos) return {};
+    const auto close = name.rfind('}');
+    return name.substr(open + 1, close == std::string::npos ? std::string::npos : close - open - 1);
+}
+} // namespace
+
+void MetricHistogram::observe(std::uint64_t value) {
+    const int b = std::min(static_cast<int>(std::bit_width(value)), BUCKETS - 1);
+    buckets[b].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    value_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+std::uint64_t MetricHistogram::quantile(double q) const {
+    const std::uint64_t n = count();
+    if (n == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(n - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += bucket(b);
+        if (seen >= rank) return upper_bound(b);
+    }
+    return upper_bound(BUCKETS - 1);
+}
+
+MetricsRegistry::Entry& MetricsRegistry::find_or_add(const std::string& name, const std::string& help, Kind kind,
+                                                     double scale) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : entries) {
+        if (entry->name != name) continue;
+        if (entry->kind != kind) throw std::runtime_error("Metric " + name + " is registered with another type");
+        return *entry;
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->kind = kind;
+    switch (kind) {
+        case Kind::Counter: entry->counter = std::make_unique<MetricCounter>(); break;
+        case Kind::Gauge: entry->gauge = std::make_unique<MetricGauge>(); break;
+        case Kind::Histogram: entry->histogram = std::make_unique<MetricHistogram>(scale); break;
+    }
+    entries.push_back(std::move(entry));
+    return *entries.back();
+}
+
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    return *find_or_add(name, help, Kind::Counter, 1.0).counter;
+}
+
+MetricGauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    return *find_or_add(name, help, Kind::Gauge, 1.0).gauge;
+}
+
+MetricHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, double scale) {
+    return *find_or_add(name, help, Kind::Histogram, scale).histogram;
+}
+
+void MetricsRegistry::write_prometheus(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> described;
+    for (const auto& entry : entries) {
+        const std::string family = family_of(entry->name);
+        if (std::find(described.begin(), described.end(), family) == described.end()) {
+            described.push_back(family);
+            const char* type = entry->kind == Kind::Counter ? "counter"
+                               : entry->kind == Kind::Gauge ? "gauge"
+                                                            : "histogram";
+            out << "# HELP " << family << ' ' << entry->help << '\n';
+            out << "# TYPE " << family << ' ' << type << '\n';
+        }
+
+        switch (entry->kind) {
+            case Kind::Counter: out << entry->name << ' ' << entry->counter->value() << '\n'; break;
+            case Kind::Gauge: out << entry->name << ' ' << entry->gauge->value() << '\n'; break;
+            case Kind::Histogram: {
+                const MetricHistogram& h = *entry->histogram;
+                const std::string labels = labels_of(entry->name);
+                const std::string prefix = family + "_bucket{" + (labels.empty() ? "" : labels + ",") + "le=\"";
+                const std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+
+                // Корзины до последней непустой, дальше +Inf
+                int last = 0;
+                for (int b = 0; b < MetricHistogram::BUCKETS; ++b) {
+                    if (h.bucket(b) > 0) last = b;
+                }
+                std::uint64_t cumulative = 0;
+                for (int b = 0; b <= last; ++b) {
+                    cumulative += h.bucket(b);
+                    out << prefix << format_number(static_cast<double>(MetricHistogram::upper_bound(b)) * h.scale())
+                        << "\"} " << cumulative << '\n';
+                }
+                out << prefix << "+Inf\"} " << h.count() << '\n';
+                out << family << "_sum" << suffix << ' ' << format_number(static_cast<double>(h.sum()) * h.scale())
+                    << '\n';
+                out << family << "_count" << suffix << ' ' << h.count() << '\n';
+                break;
+            }
+        }
+    }
+}
+
+bool MetricsRegistry::dump(const std::string& filename) {
+    const std::string temp = filename + ".tmp";
+    {
+        std::ofstream fs(temp, std::ios::trunc);
+        if (!fs.is_open()) {
+            std::cerr << "Error: Could not open metrics file " << temp << std::endl;
+            return false;
+        }
+        write_prometheus(fs);
+        if (!fs) {
+            std::cerr << "Error: Could not write metrics file " << temp << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Error: Could not replace metrics file " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void MetricsRegistry::write_summary(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : entries) {
+        switch (entry->kind) {
+            case Kind::Counter: out << entry->name << ": " << entry->counter->value() << '\n'; break;
+            case Kind::Gauge: out << entry->name << ": " << entry->gauge->value() << '\n'; break;
+            case Kind::Histogram: {
+                const MetricHistogram& h = *entry->histogram;
+                // Времена в наносекундах показываются в миллисекундах
+                const bool time = h.scale() == MetricHistogram::NANOSECONDS;
+                const double unit = time ? 1e-6 : h.scale();
+                const char* suffix = time ? " ms" : "";
+                const double mean = h.count() ? static_cast<double>(h.sum()) / static_cast<double>(h.count()) : 0.0;
+                out << entry->name << ": count " << h.count() << ", mean " << format_number(mean * unit, 4) << suffix
+                    << ", p50 <= " << format_number(static_cast<double>(h.quantile(0.5)) * unit, 4) << suffix
+                    << ", p99 <= " << format_number(static_cast<double>(h.quantile(0.99)) * unit, 4) << suffix
+                    << '\n';
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,159 @@
+#include "../include/movement.h"
+#include "../include/combat_rules.h"
+#include "../include/nearest_kernel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+// Куски по столько NPC раздаются потокам пула
+constexpr std::size_t MOVEMENT_GRAIN = 1024;
+} // namespace
+
+MovementSystem::MovementSystem(const RuntimeConfig& config, Search search)
+    : width(config.map_width), height(config.map_height), search(search), grid(width, height) {
+    for (const NpcType type : {OrkType, WillianType, WerewolfType}) {
+        move_distance[type] = config.move_distance(type);
+    }
+}
+
+void MovementSystem::pack_types(const WorldStore& world, std::size_t count) {
+    scan_types.assign(count, NearestKernel::NO_TYPE);
+    world.for_each_alive(0, count, [&](WorldStore::Id id) {
+        scan_types[id] = static_cast<std::uint8_t>(world.type(id));
+    });
+}
+
+std::size_t MovementSystem::find_target(NpcType type, int x, int y, std::size_t self, const std::vector<int>& pos_x,
+                                        const std::vector<int>& pos_y) const {
+    const unsigned prey = CombatRules::prey_mask_for(type);
+    if (search == Search::Grid) {
+        const std::size_t target = grid.nearest(x, y, prey, self);
+        return target != SpatialGrid::npos ? target : grid.nearest(x, y, CombatRules::ALL_TYPES, self);
+    }
+
+    static_assert(sizeof(int) == sizeof(std::int32_t), "NearestKernel reads int positions as int32");
+    const auto* xs = reinterpret_cast<const std::int32_t*>(pos_x.data());
+    const auto* ys = reinterpret_cast<const std::int32_t*>(pos_y.data());
+    const std::size_t count = scan_types.size();
+    std::size_t target = NearestKernel::nearest(xs, ys, scan_types.data(), count, x, y, prey, self);
+    if (target == NearestKernel::npos) {
+        target = NearestKernel::nearest(xs, ys, scan_types.data(), count, x, y, CombatRules::ALL_TYPES, self);
+    }
+    return target == NearestKernel::npos ? SpatialGrid::npos : target;
+}
+
+std::pair<int, int> MovementSystem::step_towards(int step, int x, int y, int target_x, int target_y, int width,
+                                                 int height) {
+    if (step <= 0) return {x, y};
+
+    const double dx = static_cast<double>(target_x - x);
+    const double dy = static_cast<double>(target_y - y);
+    const double dist = std::sqrt(dx * dx + dy * dy);
+    if (dist <= 0.0) return {x, y};
+
+    int move_x = static_cast<int>(std::lround(static_cast<double>(step) * dx / dist));
+    int move_y = static_cast<int>(std::lround(static_cast<double>(step) * dy / dist));
+
+    if (move_x == 0 && move_y == 0) {
+        if (std::abs(dx) >= std::abs(dy)) move_x = (dx > 0) ? 1 : -1;
+        else move_y = (dy > 0) ? 1 : -1;
+    }
+
+    return {std::clamp(x + move_x, 0, width - 1), std::clamp(y + move_y, 0, height - 1)};
+}
+
+std::size_t MovementSystem::step_in_place(WorldStore& world, unsigned movers) {
+    // Для перебора позиции упаковываются в буфер снимка: step_buffered всё равно
+    // перезаписывает его из хранилища
+    std::vector<int>& pos_x = snap_x;
+    std::vector<int>& pos_y = snap_y;
+    if (search == Search::Grid) {
+        grid.rebuild(world);
+    } else {
+        const std::size_t count = world.size();
+        pos_x.resize(count);
+        pos_y.resize(count);
+        pack_types(world, count);
+        world.for_each_alive([&](WorldStore::Id id) {
+            pos_x[id] = world.x(id);
+            pos_y[id] = world.y(id);
+        });
+    }
+    std::size_t moved = 0;
+
+    world.for_each_alive([&](WorldStore::Id id) {
+        const NpcType type = world.type(id);
+        if ((movers & CombatRules::type_bit(type)) == 0) return;
+        const int my_x = world.x(id);
+        const int my_y = world.y(id);
+
+        const std::size_t target = find_target(type, my_x, my_y, id, pos_x, pos_y);
+        if (target == SpatialGrid::npos) return;
+
+        const auto target_id = static_cast<WorldStore::Id>(target);
+        auto [new_x, new_y] = step_towards(move_distance[type], my_x, my_y, world.x(target_id), world.y(target_id), width,
+                                           height);
+        if (new_x == my_x && new_y == my_y) return;
+
+        world.set_position(id, new_x, new_y);
+        if (search == Search::Grid) {
+            grid.move(id, new_x, new_y);
+        } else {
+            pos_x[id] = new_x;
+            pos_y[id] = new_y;
+        }
+        ++moved;
+    });
+    return moved;
+}
+
+std::size_t MovementSystem::step_buffered(WorldStore& world, WorkStealingPool* pool) {
+    const std::size_t count = world.size();
+    std::vector<int>& cur_x = snap_x;
+    std::vector<int>& cur_y = snap_y;
+    cur_x.resize(count);
+    cur_y.resize(count);
+
+    auto for_all = [&](const std::function<void(std::size_t, std::size_t)>& fn) {
+        if (pool) pool->parallel_for(0, count, MOVEMENT_GRAIN, fn);
+        else fn(0, count);
+    };
+
+    // Снимок берётся каждый тик: позиции могли поменяться снаружи (загрузка, добавление NPC).
+    // Мёртвые и свободные слоты не читаются: в сетку они не попадают, а их позиции никому не нужны
+    for_all([&](std::size_t from, std::size_t to) {
+        world.for_each_alive(from, to, [&](WorldStore::Id id) {
+            cur_x[id] = world.x(id);
+            cur_y[id] = world.y(id);
+        });
+    });
+    if (search == Search::Grid) {
+        grid.rebuild(world, cur_x, cur_y);
+    } else {
+        pack_types(world, count);
+    }
+
+    // Цели ищутся только по снимку, поэтому запись в хранилище по ходу прохода
+    // не влияет на чужие шаги
+    std::atomic<std::size_t> moved{0};
+    for_all([&](std::size_t from, std::size_t to) {
+        std::size_t local = 0;
+        world.for_each_alive(from, to, [&](WorldStore::Id id) {
+            const std::size_t i = id;
+            const NpcType type = world.type(id);
+            const std::size_t target = find_target(type, cur_x[i], cur_y[i], i, cur_x, cur_y);
+            if (target == SpatialGrid::npos) return;
+
+            auto [new_x, new_y] = step_towards(move_distance[type], cur_x[i], cur_y[i], cur_x[target], cur_y[target],
+                                               width, height);
+            if (new_x == cur_x[i] && new_y == cur_y[i]) return;
+            world.set_position(id, new_x, new_y);
+            ++local;
+        });
+        moved.fetch_add(local, std::memory_order_relaxed);
+    });
+    return moved.load();
+}
@@ -0,0 +1,45 @@
+#include "../include/name_table.h"
+#include <cstring>
+#include <stdexcept>
+
+NameTable::Id NameTable::intern(std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(name);
+    if (it != index.end()) return it->second;
+
+    const std::string_view stored = store(name);
+    const auto id = static_cast<Id>(entries.size());
+    entries.push_back(stored);
+    index.emplace(stored, id);
+    return id;
+}
+
+std::string_view NameTable::view(Id id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id >= entries.size()) throw std::out_of_range("Unknown name id");
+    return entries[id];
+}
+
+std::size_t NameTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+std::string_view NameTable::store(std::string_view name) {
+    if (name.empty()) return std::string_view();
+    if (name.size() > BLOCK_BYTES) {
+        // Длинное имя - отдельным блоком
+        blocks.push_back(std::make_unique<char[]>(name.size()));
+        std::memcpy(blocks.back().get(), name.data(), name.size());
+        return std::string_view(blocks.back().get(), name.size());
+    }
+    if (!current_block || BLOCK_BYTES - block_used < name.size()) {
+        blocks.push_back(std::make_unique<char[]>(BLOCK_BYTES));
+        current_block = blocks.back().get();
+        block_used = 0;
+    }
+    char* dst = current_block + block_used;
+    std::memcpy(dst, name.data(), name.size());
+    block_used += name.size();
+    return std::string_view(dst, name.size());
+}
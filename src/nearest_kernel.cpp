@@ -0,0 +1,191 @@
+#include "../include/nearest_kernel.h"
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define NEAREST_HAS_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NEAREST_AVX2_TARGET
+#else
+#define NEAREST_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+using Kernel = std::size_t (*)(const std::int32_t*, const std::int32_t*, const std::uint8_t*, std::size_t, int, int,
+                               unsigned, std::size_t);
+
+bool accepts(std::uint8_t type, unsigned type_mask) {
+    return type < 32 && (type_mask & (1u << type)) != 0;
+}
+
+// Дочищает [from, count) скалярно, продолжая уже найденный минимум
+std::size_t scan_scalar(const std::int32_t* xs, const std::int32_t* ys, const std::uint8_t* types, std::size_t from,
+                        std::size_t count, int x, int y, unsigned type_mask, std::size_t exclude, std::size_t best,
+                        std::int64_t best_dist_sq) {
+    for (std::size_t i = from; i < count; ++i) {
+        if (i == exclude || !accepts(types[i], type_mask)) continue;
+        const std::int64_t dx = static_cast<std::int64_t>(xs[i]) - x;
+        const std::int64_t dy = static_cast<std::int64_t>(ys[i]) - y;
+        const std::int64_t dist_sq = dx * dx + dy * dy;
+        // Индексы идут по возрастанию: при равенстве остаётся прежний, меньший
+        if (best == NearestKernel::npos || dist_sq < best_dist_sq) {
+            best = i;
+            best_dist_sq = dist_sq;
+        }
+    }
+    return best;
+}
+
+std::size_t nearest_scalar(const std::int32_t* xs, const std::int32_t* ys, const std::uint8_t* types,
+                           std::size_t count, int x, int y, unsigned type_mask, std::size_t exclude) {
+    return scan_scalar(xs, ys, types, 0, count, x, y, type_mask, exclude, NearestKernel::npos, 0);
+}
+
+#if defined(NEAREST_HAS_AVX2)
+bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    // OSXSAVE и сохранение регистров YMM операционной системой
+    if ((regs[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// 8 точек за шаг. Квадраты разностей считаются в int64 через _mm256_mul_epi32:
+// чётные 32-битные дорожки - напрямую, нечётные - после сдвига на 32 бита.
+// На каждую из 8 дорожек свой минимум (расстояние, индекс), в конце - свёртка.
+NEAREST_AVX2_TARGET std::size_t nearest_avx2(const std::int32_t* xs, const std::int32_t* ys,
+                                             const std::uint8_t* types, std::size_t count, int x, int y,
+                                             unsigned type_mask, std::size_t exclude) {
+    const __m256i qx = _mm256_set1_epi32(x);
+    const __m256i qy = _mm256_set1_epi32(y);
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(type_mask));
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    // exclude >= count никогда не совпадёт с индексом дорожки
+    const __m256i excluded = _mm256_set1_epi32(exclude < count ? static_cast<int>(exclude) : -1);
+    const __m256i low_half = _mm256_set1_epi64x(0xFFFFFFFFll);
+    const __m256i inf = _mm256_set1_epi64x(INT64_MAX);
+
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i best_even = inf, best_odd = inf;
+    __m256i best_even_index = zero, best_odd_index = zero;
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i dx = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i)), qx);
+        const __m256i dy = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i)), qy);
+        const __m256i dx_odd = _mm256_srli_epi64(dx, 32);
+        const __m256i dy_odd = _mm256_srli_epi64(dy, 32);
+        __m256i dist_even = _mm256_add_epi64(_mm256_mul_epi32(dx, dx), _mm256_mul_epi32(dy, dy));
+        __m256i dist_odd = _mm256_add_epi64(_mm256_mul_epi32(dx_odd, dx_odd), _mm256_mul_epi32(dy_odd, dy_odd));
+
+        // Сдвиг на NO_TYPE (>= 32) даёт 0 - такая точка не проходит маску
+        const __m256i type = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(types + i)));
+        const __m256i bits = _mm256_and_si256(_mm256_sllv_epi32(one, type), mask);
+        const __m256i rejected = _mm256_or_si256(_mm256_cmpeq_epi32(bits, zero), _mm256_cmpeq_epi32(index, excluded));
+        dist_even = _mm256_blendv_epi8(dist_even, inf, _mm256_shuffle_epi32(rejected, _MM_SHUFFLE(2, 2, 0, 0)));
+        dist_odd = _mm256_blendv_epi8(dist_odd, inf, _mm256_shuffle_epi32(rejected, _MM_SHUFFLE(3, 3, 1, 1)));
+
+        // Строго меньше: при равенстве дорожка сохраняет более ранний индекс
+        const __m256i closer_even = _mm256_cmpgt_epi64(best_even, dist_even);
+        const __m256i closer_odd = _mm256_cmpgt_epi64(best_odd, dist_odd);
+        best_even = _mm256_blendv_epi8(best_even, dist_even, closer_even);
+        best_odd = _mm256_blendv_epi8(best_odd, dist_odd, closer_odd);
+        best_even_index = _mm256_blendv_epi8(best_even_index, _mm256_and_si256(index, low_half), closer_even);
+        best_odd_index = _mm256_blendv_epi8(best_odd_index, _mm256_srli_epi64(index, 32), closer_odd);
+
+        index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+    }
+
+    alignas(32) std::int64_t dist[8];
+    alignas(32) std::int64_t idx[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(dist), best_even);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(dist + 4), best_odd);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(idx), best_even_index);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(idx + 4), best_odd_index);
+
+    std::size_t best = NearestKernel::npos;
+    std::int64_t best_dist_sq = INT64_MAX;
+    for (int lane = 0; lane < 8; ++lane) {
+        if (dist[lane] == INT64_MAX) continue;
+        const auto lane_index = static_cast<std::size_t>(idx[lane]);
+        if (best == NearestKernel::npos || dist[lane] < best_dist_sq ||
+            (dist[lane] == best_dist_sq && lane_index < best)) {
+            best = lane_index;
+            best_dist_sq = dist[lane];
+        }
+    }
+    return scan_scalar(xs, ys, types, i, count, x, y, type_mask, exclude, best, best_dist_sq);
+}
+#endif
+
+Kernel kernel_for(NearestKernel::Isa isa) {
+#if defined(NEAREST_HAS_AVX2)
+    if (isa == NearestKernel::Isa::Avx2) return nearest_avx2;
+#endif
+    (void)isa;
+    return nearest_scalar;
+}
+
+NearestKernel::Isa detect() {
+    return NearestKernel::supported(NearestKernel::Isa::Avx2) ? NearestKernel::Isa::Avx2
+                                                              : NearestKernel::Isa::Scalar;
+}
+
+// Выбор при запуске программы
+std::atomic<NearestKernel::Isa> active_isa{detect()};
+std::atomic<Kernel> active_kernel{kernel_for(active_isa.load())};
+} // namespace
+
+namespace NearestKernel {
+std::size_t nearest(const std::int32_t* xs, const std::int32_t* ys, const std::uint8_t* types, std::size_t count,
+                    int x, int y, unsigned type_mask, std::size_t exclude) {
+    return active_kernel.load(std::memory_order_relaxed)(xs, ys, types, count, x, y, type_mask, exclude);
+}
+
+std::size_t nearest(Isa isa, const std::int32_t* xs, const std::int32_t* ys, const std::uint8_t* types,
+                    std::size_t count, int x, int y, unsigned type_mask, std::size_t exclude) {
+    if (!supported(isa)) isa = Isa::Scalar;
+    return kernel_for(isa)(xs, ys, types, count, x, y, type_mask, exclude);
+}
+
+bool supported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return true;
+#if defined(NEAREST_HAS_AVX2)
+        case Isa::Avx2: {
+            static const bool has_avx2 = cpu_has_avx2();
+            return has_avx2;
+        }
+#endif
+        default: return false;
+    }
+}
+
+Isa active() {
+    return active_isa.load();
+}
+
+bool select(Isa isa) {
+    if (!supported(isa)) return false;
+    active_isa.store(isa);
+    active_kernel.store(kernel_for(isa));
+    return true;
+}
+
+const char* name(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2: return "avx2";
+        default: return "scalar";
+    }
+}
+} // namespace NearestKernel
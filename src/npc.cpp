@@ -1,58 +1,74 @@
 #include "../include/npc.h"
+#include "../include/world_store.h"
 #include <cmath>
 
 NPC::NPC(NpcType t, int _x, int _y, const std::string& _name) 
     : type(t), x(_x), y(_y), name(_name) {}
 
-void NPC::attach(std::shared_ptr<Observer> observer) {
-    observers.push_back(observer);
-}
-
-void NPC::notify(const std::string& message, bool is_kill_event) {
-    for (auto& o : observers) {
-        o->update(message);
-    }
-}
-
 void NPC::save(std::ostream& os) {
-    std::lock_guard<std::mutex> lock(state_mutex);
-    os << x << " " << y << " " << name << std::endl;
+    auto [px, py] = position();
+    os << px << " " << py << " " << name << std::endl;
 }
 
 bool NPC::is_close(const std::shared_ptr<NPC>& other, size_t distance) {
     if (this == other.get()) return false;
-    int x1, y1, x2, y2;
-    {
-        std::lock_guard<std::mutex> lock(state_mutex);
-        x1 = x;
-        y1 = y;
-    }
-    {
-        std::lock_guard<std::mutex> lock(other->state_mutex);
-        x2 = other->x;
-        y2 = other->y;
-    }
+    auto [x1, y1] = position();
+    auto [x2, y2] = other->position();
     auto dist_sq = std::pow(x1 - x2, 2) + std::pow(y1 - y2, 2);
     return dist_sq <= std::pow(static_cast<double>(distance), 2);
 }
 
+// world и world_id читаются под state_mutex: reclaim_dead и replace_all отвязывают NPC
+// (unbind) из другого потока
 bool NPC::is_alive() const {
     std::lock_guard<std::mutex> lock(state_mutex);
+    if (world) return world->is_alive(world_id);
     return alive;
 }
 
 void NPC::kill() {
     std::lock_guard<std::mutex> lock(state_mutex);
+    if (world) {
+        world->kill(world_id);
+        return;
+    }
     alive = false;
 }
 
 std::pair<int, int> NPC::position() const {
     std::lock_guard<std::mutex> lock(state_mutex);
+    if (world) return {world->x(world_id), world->y(world_id)};
     return {x, y};
 }
 
 void NPC::set_position(int new_x, int new_y) {
     std::lock_guard<std::mutex> lock(state_mutex);
+    if (world) {
+        world->set_position(world_id, new_x, new_y);
+        return;
+    }
     x = new_x;
     y = new_y;
-}
\ No newline at end of file
+}
+
+void NPC::bind(WorldStore& store, std::uint32_t id) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    world = &store;
+    world_id = id;
+}
+
+bool NPC::bound_id(const WorldStore& store, std::uint32_t& id) const {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (world != &store) return false;
+    id = world_id;
+    return true;
+}
+
+void NPC::unbind() {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if (!world) return;
+    x = world->x(world_id);
+    y = world->y(world_id);
+    alive = world->is_alive(world_id);
+    world = nullptr;
+}
@@ -0,0 +1,47 @@
+#include "../include/npc_pool.h"
+
+namespace {
+// Первый блок монотонного ресурса; следующие растут геометрически
+constexpr std::size_t INITIAL_BLOCK_BYTES = 64 * 1024;
+} // namespace
+
+NpcPool::NpcPool() : blocks(INITIAL_BLOCK_BYTES) {}
+
+void* NpcPool::allocate(std::size_t bytes, std::size_t alignment) {
+    if (!pooled(bytes, alignment)) {
+        void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        std::lock_guard<std::mutex> lock(mutex);
+        ++live;
+        return p;
+    }
+
+    const std::size_t size_class = (bytes - 1) / GRANULE;
+    std::lock_guard<std::mutex> lock(mutex);
+    ++live;
+    if (FreeCell* cell = free_cells[size_class]) {
+        free_cells[size_class] = cell->next;
+        return cell;
+    }
+    return blocks.allocate((size_class + 1) * GRANULE, GRANULE);
+}
+
+void NpcPool::deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    if (!pooled(bytes, alignment)) {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        std::lock_guard<std::mutex> lock(mutex);
+        --live;
+        return;
+    }
+
+    const std::size_t size_class = (bytes - 1) / GRANULE;
+    std::lock_guard<std::mutex> lock(mutex);
+    --live;
+    auto* cell = static_cast<FreeCell*>(p);
+    cell->next = free_cells[size_class];
+    free_cells[size_class] = cell;
+}
+
+std::size_t NpcPool::live_objects() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return live;
+}
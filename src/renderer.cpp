@@ -0,0 +1,200 @@
+#include "../include/renderer.h"
+#include "../include/output.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RENDERER_USE_WRITE 1
+#include <unistd.h>
+#endif
+
+namespace {
+// DECSC / DECRC: сохранить и восстановить позицию курсора
+constexpr const char* SAVE_CURSOR = "\x1b" "7";
+constexpr const char* RESTORE_CURSOR = "\x1b" "8";
+
+char map_symbol_for(NpcType type) {
+    switch (type) {
+        case OrkType: return 'O';
+        case WillianType: return 'R'; // "Разбойник"
+        case WerewolfType: return 'W';
+        default: return '?';
+    }
+}
+
+void plot(const FrameLayout& frame, std::vector<char>& cells, int world_x, int world_y, NpcType type) {
+    const int x = world_x - frame.x0;
+    const int y = world_y - frame.y0;
+    if (x >= 0 && x < frame.width && y >= 0 && y < frame.height) {
+        cells[static_cast<std::size_t>(y / frame.scale) * static_cast<std::size_t>(frame.cols) +
+              static_cast<std::size_t>(x / frame.scale)] = map_symbol_for(type);
+    }
+}
+
+// Кадр в cells (rows * cols), возвращает число живых
+std::size_t rasterize(const WorldStore& world, const FrameLayout& frame, std::vector<char>& cells) {
+    cells.assign(static_cast<std::size_t>(frame.rows) * static_cast<std::size_t>(frame.cols), '.');
+
+    std::size_t alive_count = 0;
+    world.for_each_alive([&](WorldStore::Id id) {
+        ++alive_count;
+        plot(frame, cells, world.x(id), world.y(id), world.type(id));
+    });
+    return alive_count;
+}
+
+std::size_t rasterize(const WorldFrame& world, const FrameLayout& frame, std::vector<char>& cells) {
+    cells.assign(static_cast<std::size_t>(frame.rows) * static_cast<std::size_t>(frame.cols), '.');
+    world.for_each_alive([&](const WorldFrame::Entry& e) { plot(frame, cells, e.x, e.y, e.type); });
+    return world.alive_count;
+}
+
+void append_header(std::string& out, const FrameLayout& frame, int seconds_left, std::size_t alive_count) {
+    out += "Seconds left: ";
+    out += std::to_string(seconds_left);
+    out += " | Alive: ";
+    out += std::to_string(alive_count);
+    if (frame.scale > 1) {
+        out += " | Scale: 1:";
+        out += std::to_string(frame.scale);
+    }
+}
+
+// Курсор в строку row, столбец col терминала (с 1)
+void append_move(std::string& out, int row, int col) {
+    char buf[32];
+    const int n = std::snprintf(buf, sizeof(buf), "\x1b[%d;%dH", row, col);
+    out.append(buf, static_cast<std::size_t>(n));
+}
+
+// Полный кадр: заголовок и строки карты
+std::string compose(const FrameLayout& frame, const std::vector<char>& cells, int seconds_left,
+                    std::size_t alive_count) {
+    std::string out;
+    out.reserve(cells.size() + static_cast<std::size_t>(frame.rows) + 64);
+    append_header(out, frame, seconds_left, alive_count);
+    out += '\n';
+    for (int r = 0; r < frame.rows; ++r) {
+        out.append(cells.data() + static_cast<std::size_t>(r) * static_cast<std::size_t>(frame.cols),
+                   static_cast<std::size_t>(frame.cols));
+        out += '\n';
+    }
+    return out;
+}
+} // namespace
+
+FrameLayout FrameLayout::from(const RuntimeConfig& config) {
+    FrameLayout frame;
+    frame.x0 = std::clamp(config.viewport_x, 0, config.map_width - 1);
+    frame.y0 = std::clamp(config.viewport_y, 0, config.map_height - 1);
+    const int max_width = config.map_width - frame.x0;
+    const int max_height = config.map_height - frame.y0;
+    frame.width = config.viewport_width > 0 ? std::min(config.viewport_width, max_width) : max_width;
+    frame.height = config.viewport_height > 0 ? std::min(config.viewport_height, max_height) : max_height;
+    frame.scale = std::max({1, (frame.width + config.render_max_cols - 1) / config.render_max_cols,
+                            (frame.height + config.render_max_rows - 1) / config.render_max_rows});
+    frame.cols = (frame.width + frame.scale - 1) / frame.scale;
+    frame.rows = (frame.height + frame.scale - 1) / frame.scale;
+    return frame;
+}
+
+std::string render_map(const WorldStore& world, int seconds_left, const RuntimeConfig& config) {
+    const FrameLayout frame = FrameLayout::from(config);
+    std::vector<char> cells;
+    const std::size_t alive_count = rasterize(world, frame, cells);
+    return compose(frame, cells, seconds_left, alive_count);
+}
+
+std::string render_map(const WorldFrame& world, int seconds_left, const RuntimeConfig& config) {
+    const FrameLayout frame = FrameLayout::from(config);
+    std::vector<char> cells;
+    const std::size_t alive_count = rasterize(world, frame, cells);
+    return compose(frame, cells, seconds_left, alive_count);
+}
+
+DiffRenderer::DiffRenderer(const RuntimeConfig& config) : frame(FrameLayout::from(config)) {}
+
+const std::string& DiffRenderer::render(const WorldStore& world, int seconds_left) {
+    return render_current(seconds_left, rasterize(world, frame, current));
+}
+
+const std::string& DiffRenderer::render(const WorldFrame& world, int seconds_left) {
+    return render_current(seconds_left, rasterize(world, frame, current));
+}
+
+const std::string& DiffRenderer::render_current(int seconds_left, std::size_t alive_count) {
+    out.clear();
+    changed = 0;
+
+    if (full_redraw || previous.size() != current.size()) {
+        // Очистка экрана, карта целиком, под картой - область прокрутки для лога
+        out += "\x1b[2J\x1b[H";
+        append_header(out, frame, seconds_left, alive_count);
+        out += '\n';
+        for (int r = 0; r < frame.rows; ++r) {
+            out.append(current.data() + static_cast<std::size_t>(r) * static_cast<std::size_t>(frame.cols),
+                       static_cast<std::size_t>(frame.cols));
+            out += '\n';
+        }
+        // Установка области прокрутки переносит курсор в начало экрана - возвращаем его под карту
+        out += "\x1b[" + std::to_string(frame.rows + 2) + "r";
+        append_move(out, frame.rows + 2, 1);
+        changed = current.size();
+        full_redraw = false;
+    } else {
+        out += SAVE_CURSOR; // курсор сейчас в области лога
+        append_move(out, 1, 1);
+        out += "\x1b[2K";
+        append_header(out, frame, seconds_left, alive_count);
+
+        for (int r = 0; r < frame.rows; ++r) {
+            const std::size_t row_begin = static_cast<std::size_t>(r) * static_cast<std::size_t>(frame.cols);
+            int cursor_col = -1; // столбец, куда сейчас смотрит курсор терминала
+            for (int c = 0; c < frame.cols; ++c) {
+                const std::size_t i = row_begin + static_cast<std::size_t>(c);
+                if (current[i] == previous[i]) continue;
+                if (cursor_col != c) append_move(out, r + 2, c + 1);
+                out += current[i];
+                cursor_col = c + 1;
+                ++changed;
+            }
+        }
+        out += RESTORE_CURSOR;
+    }
+
+    std::swap(previous, current);
+    return out;
+}
+
+std::string DiffRenderer::finish() const {
+    // Сброс области прокрутки тоже переносит курсор - сохраняем его позицию в логе
+    return std::string(SAVE_CURSOR) + "\x1b[r" + RESTORE_CURSOR + "\n";
+}
+
+bool DiffRenderer::stdout_is_terminal() {
+#ifdef RENDERER_USE_WRITE
+    return ::isatty(STDOUT_FILENO) != 0;
+#else
+    return false;
+#endif
+}
+
+void DiffRenderer::write_out(const std::string& data) {
+    std::lock_guard<std::mutex> lock(Output::cout_mutex);
+    std::cout.flush();
+#ifdef RENDERER_USE_WRITE
+    const char* p = data.data();
+    std::size_t left = data.size();
+    while (left > 0) {
+        const ssize_t n = ::write(STDOUT_FILENO, p, left);
+        if (n <= 0) break;
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+#else
+    std::fwrite(data.data(), 1, data.size(), stdout);
+    std::fflush(stdout);
+#endif
+}
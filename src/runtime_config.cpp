@@ -0,0 +1,301 @@
+#include "../include/runtime_config.h"
+#include "../include/world_store.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+namespace {
+template <typename T>
+struct Field {
+    const char* key;
+    T RuntimeConfig::*member;
+};
+
+constexpr Field<int> INT_FIELDS[] = {
+    {"map_width", &RuntimeConfig::map_width},
+    {"map_height", &RuntimeConfig::map_height},
+    {"duration_seconds", &RuntimeConfig::duration_seconds},
+    {"render_period_ms", &RuntimeConfig::render_period_ms},
+    {"movement_tick_ms", &RuntimeConfig::movement_tick_ms},
+    {"render_max_cols", &RuntimeConfig::render_max_cols},
+    {"render_max_rows", &RuntimeConfig::render_max_rows},
+    {"viewport_x", &RuntimeConfig::viewport_x},
+    {"viewport_y", &RuntimeConfig::viewport_y},
+    {"viewport_width", &RuntimeConfig::viewport_width},
+    {"viewport_height", &RuntimeConfig::viewport_height},
+    {"shard_ghost_width", &RuntimeConfig::shard_ghost_width},
+    {"ork_move_distance", &RuntimeConfig::ork_move_distance},
+    {"ork_kill_distance", &RuntimeConfig::ork_kill_distance},
+    {"willian_move_distance", &RuntimeConfig::willian_move_distance},
+    {"willian_kill_distance", &RuntimeConfig::willian_kill_distance},
+    {"werewolf_move_distance", &RuntimeConfig::werewolf_move_distance},
+    {"werewolf_kill_distance", &RuntimeConfig::werewolf_kill_distance},
+    {"ork_move_period_ms", &RuntimeConfig::ork_move_period_ms},
+    {"willian_move_period_ms", &RuntimeConfig::willian_move_period_ms},
+    {"werewolf_move_period_ms", &RuntimeConfig::werewolf_move_period_ms},
+    {"metrics_period_ms", &RuntimeConfig::metrics_period_ms},
+};
+
+constexpr Field<std::size_t> SIZE_FIELDS[] = {
+    {"npc_count", &RuntimeConfig::npc_count},
+    {"fight_workers", &RuntimeConfig::fight_workers},
+    {"fight_queue_capacity", &RuntimeConfig::fight_queue_capacity},
+    {"reclaim_period_ticks", &RuntimeConfig::reclaim_period_ticks},
+    {"shards", &RuntimeConfig::shards},
+    {"batch_arenas", &RuntimeConfig::batch_arenas},
+    {"batch_max_ticks", &RuntimeConfig::batch_max_ticks},
+    {"batch_threads", &RuntimeConfig::batch_threads},
+};
+
+constexpr Field<std::uint64_t> UINT64_FIELDS[] = {
+    {"seed", &RuntimeConfig::seed},
+    {"batch_seed", &RuntimeConfig::batch_seed},
+};
+
+constexpr Field<bool> BOOL_FIELDS[] = {
+    {"render_diff", &RuntimeConfig::render_diff},
+    {"parallel_movement", &RuntimeConfig::parallel_movement},
+    {"nearest_scan", &RuntimeConfig::nearest_scan},
+    {"behavior_coroutines", &RuntimeConfig::behavior_coroutines},
+    {"virtual_time", &RuntimeConfig::virtual_time},
+    {"headless", &RuntimeConfig::headless},
+    {"fight_queue_drop_when_full", &RuntimeConfig::fight_queue_drop_when_full},
+    {"metrics", &RuntimeConfig::metrics},
+};
+
+constexpr Field<std::string> STRING_FIELDS[] = {
+    {"metrics_file", &RuntimeConfig::metrics_file},
+};
+
+std::string_view trim(std::string_view s) {
+    const auto first = s.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) return {};
+    const auto last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last - first + 1);
+}
+
+template <typename T>
+bool parse_number(std::string_view text, T& out) {
+    const char* end = text.data() + text.size();
+    T value{};
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr != end) return false;
+    out = value;
+    return true;
+}
+
+bool parse_bool(std::string_view text, bool& out) {
+    if (text == "1" || text == "true" || text == "on" || text == "yes") {
+        out = true;
+        return true;
+    }
+    if (text == "0" || text == "false" || text == "off" || text == "no") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+RuntimeConfig& active_config() {
+    static RuntimeConfig config;
+    return config;
+}
+} // namespace
+
+int RuntimeConfig::move_distance(NpcType type) const {
+    switch (type) {
+        case OrkType: return ork_move_distance;
+        case WillianType: return willian_move_distance;
+        case WerewolfType: return werewolf_move_distance;
+        default: return 0;
+    }
+}
+
+int RuntimeConfig::kill_distance(NpcType type) const {
+    switch (type) {
+        case OrkType: return ork_kill_distance;
+        case WillianType: return willian_kill_distance;
+        case WerewolfType: return werewolf_kill_distance;
+        default: return 0;
+    }
+}
+
+int RuntimeConfig::move_period_ms(NpcType type) const {
+    int period = 0;
+    switch (type) {
+        case OrkType: period = ork_move_period_ms; break;
+        case WillianType: period = willian_move_period_ms; break;
+        case WerewolfType: period = werewolf_move_period_ms; break;
+        default: break;
+    }
+    return period > 0 ? period : movement_tick_ms;
+}
+
+bool RuntimeConfig::set(std::string_view key, std::string_view value) {
+    std::string name(trim(key));
+    std::replace(name.begin(), name.end(), '-', '_');
+    value = trim(value);
+
+    for (const auto& f : INT_FIELDS) {
+        if (name != f.key) continue;
+        if (!parse_number(value, this->*f.member)) {
+            std::cerr << "Error: " << name << " expects an integer, got '" << value << "'" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    for (const auto& f : SIZE_FIELDS) {
+        if (name != f.key) continue;
+        if (!parse_number(value, this->*f.member)) {
+            std::cerr << "Error: " << name << " expects a non-negative integer, got '" << value << "'"
+                      << std::endl;
+            return false;
+        }
+        return true;
+    }
+    for (const auto& f : UINT64_FIELDS) {
+        if (name != f.key) continue;
+        if (!parse_number(value, this->*f.member)) {
+            std::cerr << "Error: " << name << " expects a non-negative integer, got '" << value << "'"
+                      << std::endl;
+            return false;
+        }
+        return true;
+    }
+    for (const auto& f : BOOL_FIELDS) {
+        if (name != f.key) continue;
+        if (!parse_bool(value, this->*f.member)) {
+            std::cerr << "Error: " << name << " expects true/false, got '" << value << "'" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    for (const auto& f : STRING_FIELDS) {
+        if (name != f.key) continue;
+        if (value.empty()) {
+            std::cerr << "Error: " << name << " must not be empty" << std::endl;
+            return false;
+        }
+        this->*f.member = std::string(value);
+        return true;
+    }
+
+    std::cerr << "Error: unknown config key '" << name << "'" << std::endl;
+    return false;
+}
+
+bool RuntimeConfig::load_file(const std::string& filename) {
+    std::ifstream fs(filename);
+    if (!fs.is_open()) {
+        std::cerr << "Error: Could not open config file " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline(fs, line)) {
+        ++line_no;
+        const std::string_view text = trim(line);
+        if (text.empty() || text.front() == '#') continue;
+
+        const auto eq = text.find('=');
+        if (eq == std::string_view::npos) {
+            std::cerr << "Error: " << filename << ":" << line_no << ": expected key=value" << std::endl;
+            return false;
+        }
+        if (!set(text.substr(0, eq), text.substr(eq + 1))) {
+            std::cerr << "Error: in " << filename << ":" << line_no << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RuntimeConfig::parse_args(int argc, const char* const* argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg.substr(0, 2) != "--") {
+            std::cerr << "Error: unexpected argument '" << arg << "'" << std::endl;
+            return false;
+        }
+        arg.remove_prefix(2);
+
+        std::string_view key = arg;
+        std::string_view value;
+        const auto eq = arg.find('=');
+        if (eq != std::string_view::npos) {
+            key = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            std::cerr << "Error: missing value for --" << key << std::endl;
+            return false;
+        }
+
+        const bool ok = (key == "config") ? load_file(std::string(value)) : set(key, value);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool RuntimeConfig::validate() const {
+    if (map_width <= 0 || map_height <= 0) {
+        std::cerr << "Error: map size must be positive" << std::endl;
+        return false;
+    }
+    if (render_max_cols <= 0 || render_max_rows <= 0) {
+        std::cerr << "Error: render_max_cols/render_max_rows must be positive" << std::endl;
+        return false;
+    }
+    if (viewport_x < 0 || viewport_y < 0 || viewport_width < 0 || viewport_height < 0) {
+        std::cerr << "Error: viewport must not be negative" << std::endl;
+        return false;
+    }
+    if (duration_seconds < 0 || render_period_ms < 0 || movement_tick_ms < 0 || ork_move_period_ms < 0 ||
+        willian_move_period_ms < 0 || werewolf_move_period_ms < 0) {
+        std::cerr << "Error: durations must not be negative" << std::endl;
+        return false;
+    }
+    // По настоящим часам нулевой период превращает циклы Game::run в холостое вращение
+    if (!virtual_time && !headless && (render_period_ms == 0 || movement_tick_ms == 0)) {
+        std::cerr << "Error: render_period_ms and movement_tick_ms must be positive in wall-clock mode" << std::endl;
+        return false;
+    }
+    if (metrics_period_ms <= 0) {
+        std::cerr << "Error: metrics_period_ms must be positive" << std::endl;
+        return false;
+    }
+    if (shard_ghost_width < 0) {
+        std::cerr << "Error: shard_ghost_width must not be negative" << std::endl;
+        return false;
+    }
+    if (shards > 0 && behavior_coroutines) {
+        std::cerr << "Error: shards and behavior_coroutines cannot be combined" << std::endl;
+        return false;
+    }
+    if (fight_workers == 0 || fight_queue_capacity == 0) {
+        std::cerr << "Error: fight_workers and fight_queue_capacity must be positive" << std::endl;
+        return false;
+    }
+    if (npc_count > WorldStore::CAPACITY) {
+        std::cerr << "Error: npc_count is too large (at most " << WorldStore::CAPACITY << ")" << std::endl;
+        return false;
+    }
+    if (ork_move_distance < 0 || ork_kill_distance < 0 || willian_move_distance < 0 || willian_kill_distance < 0 ||
+        werewolf_move_distance < 0 || werewolf_kill_distance < 0) {
+        std::cerr << "Error: move and kill distances must not be negative" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const RuntimeConfig& RuntimeConfig::current() {
+    return active_config();
+}
+
+void RuntimeConfig::set_current(const RuntimeConfig& config) {
+    active_config() = config;
+}
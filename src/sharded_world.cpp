@@ -0,0 +1,331 @@
+#include "../include/sharded_world.h"
+#include "../include/combat_rules.h"
+#include "../include/movement.h"
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace {
+std::size_t shard_count_for(std::size_t shards, int width) {
+    if (shards == 0) shards = std::max(1u, std::thread::hardware_concurrency());
+    // Полоса не уже одного столбца
+    return std::clamp<std::size_t>(shards, 1, static_cast<std::size_t>(std::max(width, 1)));
+}
+
+int auto_ghost_width(const RuntimeConfig& config) {
+    int width = 0;
+    for (const NpcType type : {OrkType, WillianType, WerewolfType}) {
+        width = std::max({width, config.kill_distance(type), config.move_distance(type)});
+    }
+    return width;
+}
+
+// Первый столбец полосы s из count: ceil(s * width / count), тогда столбец x лежит в полосе x * count / width
+int first_column(std::size_t s, std::size_t count, int width) {
+    return static_cast<int>((static_cast<long long>(s) * width + static_cast<long long>(count) - 1) /
+                            static_cast<long long>(count));
+}
+
+long long dist_sq(int ax, int ay, int bx, int by) {
+    const long long dx = static_cast<long long>(ax) - bx;
+    const long long dy = static_cast<long long>(ay) - by;
+    return dx * dx + dy * dy;
+}
+} // namespace
+
+ShardedWorld::ShardedWorld(Arena& arena, const RuntimeConfig& config, std::size_t shard_count, int ghost_width,
+                           std::uint64_t seed)
+    : arena(arena),
+      cfg(config),
+      rng(seed),
+      ghost(ghost_width > 0 ? ghost_width : auto_ghost_width(config)),
+      start(static_cast<std::ptrdiff_t>(shard_count_for(shard_count, config.map_width) + 1)),
+      done(static_cast<std::ptrdiff_t>(shard_count_for(shard_count, config.map_width) + 1)),
+      phase(static_cast<std::ptrdiff_t>(shard_count_for(shard_count, config.map_width))) {
+    // Зона призраков уже дистанции удара теряла бы бои через границу
+    for (const NpcType type : {OrkType, WillianType, WerewolfType}) {
+        ghost = std::max(ghost, cfg.kill_distance(type));
+    }
+
+    const std::size_t count = shard_count_for(shard_count, cfg.map_width);
+    for (std::size_t s = 0; s < count; ++s) {
+        const int x0 = first_column(s, count, cfg.map_width);
+        const int x1 = first_column(s + 1, count, cfg.map_width);
+        const int lo = std::max(0, x0 - ghost);
+        const int hi = std::min(cfg.map_width, x1 + ghost);
+        auto shard = std::make_unique<Shard>(lo, hi, cfg.map_height);
+        shard->x0 = x0;
+        shard->x1 = x1;
+        shard->ghosts_out.resize(count);
+        shard->migrate_out.resize(count);
+        shard->fights_out.resize(count);
+        shards.push_back(std::move(shard));
+    }
+
+    // Начальная раздача по столбцам и первые призраки
+    const WorldStore& world = arena.world();
+    world.for_each_alive([&](WorldStore::Id id) { shards[shard_of(world.x(id))]->owned.push_back(id); });
+    for (std::size_t s = 0; s < count; ++s) publish_ghosts(s);
+
+    for (std::size_t s = 0; s < count; ++s) {
+        threads.emplace_back([this, s]() { worker(s); });
+    }
+}
+
+ShardedWorld::~ShardedWorld() {
+    stopping = true;
+    start.arrive_and_wait();
+    for (auto& t : threads) t.join();
+}
+
+std::size_t ShardedWorld::shard_of(int x) const {
+    const long long column = std::clamp(x, 0, cfg.map_width - 1);
+    return static_cast<std::size_t>(column * static_cast<long long>(shards.size()) / cfg.map_width);
+}
+
+ShardTickStats ShardedWorld::tick() {
+    for (auto& shard : shards) shard->stats = ShardTickStats{};
+    start.arrive_and_wait();
+    done.arrive_and_wait();
+    ++current_tick;
+
+    ShardTickStats total;
+    for (const auto& shard : shards) {
+        total.moved += shard->stats.moved;
+        total.fights += shard->stats.fights;
+        total.kills += shard->stats.kills;
+        total.migrated += shard->stats.migrated;
+        total.ghosts += shard->stats.ghosts;
+        total.fallbacks += shard->stats.fallbacks;
+    }
+    return total;
+}
+
+void ShardedWorld::worker(std::size_t index) {
+    while (true) {
+        start.arrive_and_wait();
+        if (stopping) return;
+
+        build_view(index, true);
+        phase.arrive_and_wait(); // сетки всех шардов готовы для уточняющих поисков
+        move(index);
+        phase.arrive_and_wait();
+        migrate_and_publish(index);
+        phase.arrive_and_wait();
+        build_view(index, false);
+        check_fights(index);
+        phase.arrive_and_wait();
+        resolve_fights(index);
+
+        done.arrive_and_wait();
+    }
+}
+
+void ShardedWorld::publish_ghosts(std::size_t index) {
+    Shard& shard = *shards[index];
+    const WorldStore& world = arena.world();
+    for (auto& out : shard.ghosts_out) out.clear();
+    for (const WorldStore::Id id : shard.owned) {
+        const int x = world.x(id);
+        // Получатели - шарды, чья зона призраков накрывает столбец x
+        const std::size_t first = shard_of(x - ghost);
+        const std::size_t last = shard_of(x + ghost);
+        for (std::size_t to = first; to <= last; ++to) {
+            if (to == index) continue;
+            shard.ghosts_out[to].push_back(Ghost{id, x, world.y(id), static_cast<std::uint8_t>(world.type(id))});
+            ++shard.stats.ghosts;
+        }
+    }
+}
+
+void ShardedWorld::build_view(std::size_t index, bool skip_dead) {
+    Shard& shard = *shards[index];
+    const WorldStore& world = arena.world();
+
+    // Свои и призраки сливаются по id: при равных расстояниях сетка выбирает меньший
+    // индекс, и он совпадает с выбором по id во всём мире
+    struct Item {
+        WorldStore::Id id;
+        int x, y;
+        std::uint8_t type;
+        std::uint32_t owner;
+    };
+    std::vector<Item> items;
+    items.reserve(shard.owned.size());
+    for (const WorldStore::Id id : shard.owned) {
+        items.push_back(Item{id, world.x(id), world.y(id), static_cast<std::uint8_t>(world.type(id)),
+                             static_cast<std::uint32_t>(index)});
+    }
+    for (std::size_t from = 0; from < shards.size(); ++from) {
+        if (from == index) continue;
+        for (const Ghost& g : shards[from]->ghosts_out[index]) {
+            if (skip_dead && !world.is_alive(g.id)) continue;
+            items.push_back(Item{g.id, g.x, g.y, g.type, static_cast<std::uint32_t>(from)});
+        }
+    }
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.id < b.id; });
+
+    const std::size_t n = items.size();
+    shard.ids.resize(n);
+    shard.xs.resize(n);
+    shard.ys.resize(n);
+    shard.types.resize(n);
+    shard.owners.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        shard.ids[i] = items[i].id;
+        shard.xs[i] = items[i].x - shard.lo;
+        shard.ys[i] = items[i].y;
+        shard.types[i] = items[i].type;
+        shard.owners[i] = items[i].owner;
+    }
+    shard.grid.rebuild(shard.xs, shard.ys, shard.types);
+}
+
+ShardedWorld::Target ShardedWorld::nearest(std::size_t index, std::size_t local, unsigned type_mask,
+                                           std::size_t& fallbacks) const {
+    const Shard& shard = *shards[index];
+    const WorldStore::Id self = shard.ids[local];
+    const int x = shard.xs[local] + shard.lo;
+    const int y = shard.ys[local];
+
+    Target best;
+    const std::size_t found = shard.grid.nearest(x - shard.lo, y, type_mask, local);
+    if (found != SpatialGrid::npos) {
+        best = Target{shard.ids[found], shard.xs[found] + shard.lo, shard.ys[found],
+                      dist_sq(x, y, shard.xs[found] + shard.lo, shard.ys[found])};
+    }
+
+    // Всё, чего шард не видит, лежит за краем зоны призраков - не ближе gap
+    long long gap = std::numeric_limits<long long>::max();
+    if (shard.lo > 0) gap = std::min<long long>(gap, x - shard.lo + 1);
+    if (shard.hi < cfg.map_width) gap = std::min<long long>(gap, shard.hi - x);
+    if (best.dist_sq >= 0 && (gap == std::numeric_limits<long long>::max() || best.dist_sq < gap * gap)) {
+        return best;
+    }
+
+    // Уточнение по сеткам остальных шардов; их наборы вместе покрывают весь мир
+    ++fallbacks;
+    for (std::size_t s = 0; s < shards.size(); ++s) {
+        if (s == index) continue;
+        const Shard& other = *shards[s];
+        const auto it = std::lower_bound(other.ids.begin(), other.ids.end(), self);
+        const std::size_t exclude =
+            (it != other.ids.end() && *it == self) ? static_cast<std::size_t>(it - other.ids.begin()) : SpatialGrid::npos;
+        const std::size_t candidate = other.grid.nearest(x - other.lo, y, type_mask, exclude);
+        if (candidate == SpatialGrid::npos) continue;
+
+        const int cx = other.xs[candidate] + other.lo;
+        const int cy = other.ys[candidate];
+        const long long d = dist_sq(x, y, cx, cy);
+        const WorldStore::Id id = other.ids[candidate];
+        if (best.dist_sq < 0 || d < best.dist_sq || (d == best.dist_sq && id < best.id)) {
+            best = Target{id, cx, cy, d};
+        }
+    }
+    return best;
+}
+
+void ShardedWorld::move(std::size_t index) {
+    Shard& shard = *shards[index];
+    WorldStore& world = arena.world();
+    for (auto& out : shard.migrate_out) out.clear();
+
+    for (std::size_t i = 0; i < shard.ids.size(); ++i) {
+        if (shard.owners[i] != index) continue;
+        const auto type = static_cast<NpcType>(shard.types[i]);
+        const int x = shard.xs[i] + shard.lo;
+        const int y = shard.ys[i];
+
+        // Как MovementSystem::find_target: добыча, а если её нет - кто угодно
+        Target target = nearest(index, i, CombatRules::prey_mask_for(type), shard.stats.fallbacks);
+        if (target.dist_sq < 0) target = nearest(index, i, CombatRules::ALL_TYPES, shard.stats.fallbacks);
+        if (target.dist_sq < 0) continue;
+
+        const auto [new_x, new_y] =
+            MovementSystem::step_towards(cfg.move_distance(type), x, y, target.x, target.y, cfg.map_width,
+                                         cfg.map_height);
+        if (new_x == x && new_y == y) continue;
+
+        world.set_position(shard.ids[i], new_x, new_y);
+        ++shard.stats.moved;
+        const std::size_t to = shard_of(new_x);
+        if (to != index) shard.migrate_out[to].push_back(shard.ids[i]);
+    }
+}
+
+void ShardedWorld::migrate_and_publish(std::size_t index) {
+    Shard& shard = *shards[index];
+    std::vector<WorldStore::Id> leaving;
+    for (const auto& out : shard.migrate_out) leaving.insert(leaving.end(), out.begin(), out.end());
+
+    if (!leaving.empty()) {
+        std::sort(leaving.begin(), leaving.end());
+        std::vector<WorldStore::Id> kept;
+        kept.reserve(shard.owned.size());
+        std::set_difference(shard.owned.begin(), shard.owned.end(), leaving.begin(), leaving.end(),
+                            std::back_inserter(kept));
+        shard.owned.swap(kept);
+    }
+    const std::size_t before = shard.owned.size();
+    for (std::size_t from = 0; from < shards.size(); ++from) {
+        if (from == index) continue;
+        const auto& arriving = shards[from]->migrate_out[index];
+        shard.owned.insert(shard.owned.end(), arriving.begin(), arriving.end());
+    }
+    if (shard.owned.size() != before) {
+        std::sort(shard.owned.begin(), shard.owned.end());
+        shard.stats.migrated += shard.owned.size() - before;
+    }
+
+    publish_ghosts(index);
+}
+
+void ShardedWorld::check_fights(std::size_t index) {
+    Shard& shard = *shards[index];
+    const WorldStore& world = arena.world();
+    for (auto& out : shard.fights_out) out.clear();
+
+    for (std::size_t i = 0; i < shard.ids.size(); ++i) {
+        if (shard.owners[i] != index) continue;
+        const auto type = static_cast<NpcType>(shard.types[i]);
+        const int kill_dist = cfg.kill_distance(type);
+        if (kill_dist <= 0) continue;
+
+        shard.found.clear();
+        shard.grid.within(shard.xs[i], shard.ys[i], kill_dist, CombatRules::prey_mask_for(type), i, shard.found);
+        std::sort(shard.found.begin(), shard.found.end());
+
+        const WorldStore::Id attacker = shard.ids[i];
+        for (const std::size_t j : shard.found) {
+            const WorldStore::Id defender = shard.ids[j];
+            shard.fights_out[shard.owners[j]].push_back(FightTask{
+                attacker, defender, world.generation(attacker), world.generation(defender), current_tick});
+        }
+    }
+}
+
+void ShardedWorld::resolve_fights(std::size_t index) {
+    Shard& shard = *shards[index];
+    shard.inbox.clear();
+    for (const auto& from : shards) {
+        const auto& tasks = from->fights_out[index];
+        shard.inbox.insert(shard.inbox.end(), tasks.begin(), tasks.end());
+    }
+    // Порядок collect_fights: по атакующему, затем по защищающемуся
+    std::sort(shard.inbox.begin(), shard.inbox.end(), [](const FightTask& a, const FightTask& b) {
+        return a.attacker != b.attacker ? a.attacker < b.attacker : a.defender < b.defender;
+    });
+
+    for (const FightTask& task : shard.inbox) {
+        ++shard.stats.fights;
+        if (resolve_fight(arena, rng, task, false) == FightResult::Killed) ++shard.stats.kills;
+    }
+
+    // Убитых защищающихся больше нет в наборе шарда
+    if (shard.stats.kills > 0) {
+        const WorldStore& world = arena.world();
+        shard.owned.erase(std::remove_if(shard.owned.begin(), shard.owned.end(),
+                                         [&](WorldStore::Id id) { return !world.is_alive(id); }),
+                          shard.owned.end());
+    }
+}
@@ -0,0 +1,120 @@
+#include "../include/sim_engine.h"
+#include "../include/combat_rules.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <thread>
+
+namespace {
+// Период 0 поставил бы событие на то же время навсегда
+std::uint64_t period_of(int ms) {
+    return static_cast<std::uint64_t>(std::max(ms, 1));
+}
+} // namespace
+
+SimEngine::SimEngine(Arena& arena, const RuntimeConfig& config, std::uint64_t seed)
+    : arena(arena),
+      cfg(config),
+      rng(seed),
+      movement(config, config.nearest_scan ? MovementSystem::Search::Scan : MovementSystem::Search::Grid) {}
+
+void SimEngine::push(std::uint64_t time_ms, SimEventKind kind, unsigned type_mask) {
+    events.push(SimEvent{time_ms, kind, seq++, type_mask});
+}
+
+SimStats SimEngine::run(Pacing pacing) {
+    end_ms = static_cast<std::uint64_t>(std::max(cfg.duration_seconds, 0)) * 1000;
+    push(end_ms, SimEventKind::End);
+
+    // Типы с одинаковым периодом ходят одним проходом - как в потоке движения
+    std::map<std::uint64_t, unsigned> move_groups;
+    for (const NpcType type : {OrkType, WillianType, WerewolfType}) {
+        move_groups[period_of(cfg.move_period_ms(type))] |= CombatRules::type_bit(type);
+    }
+    for (const auto& [period, mask] : move_groups) {
+        push(0, SimEventKind::Move, mask);
+    }
+    push(0, SimEventKind::FightCheck);
+    if (render) push(0, SimEventKind::Render);
+
+    arena.publish_frame(current_tick);
+    const auto wall_start = std::chrono::steady_clock::now();
+    while (!finished && !events.empty()) {
+        const SimEvent event = events.top();
+        events.pop();
+        if (pacing == Pacing::RealTime) {
+            std::this_thread::sleep_until(wall_start + std::chrono::milliseconds(event.time_ms));
+        }
+        now = event.time_ms;
+        handle(event);
+        ++stats.events;
+    }
+
+    // Бои последнего такта уже разрешены - кадр для отчёта о выживших
+    arena.publish_frame(current_tick);
+    stats.virtual_ms = now;
+    stats.wall_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    return stats;
+}
+
+void SimEngine::handle(const SimEvent& event) {
+    WorldStore& world = arena.world();
+    switch (event.kind) {
+        case SimEventKind::End:
+            finished = true;
+            break;
+
+        case SimEventKind::Move: {
+            const std::size_t moved = movement.step_in_place(world, event.type_mask);
+            ++stats.moves;
+            stats.moved += moved;
+            EventBus& bus = arena.events();
+            if (bus.wants(EventType::MoveSummary)) {
+                bus.publish(MoveSummaryEvent{current_tick + 1, moved});
+            }
+            // Все типы группы ходят с одним периодом - берём его у младшего
+            NpcType first = OrkType;
+            for (const NpcType type : {OrkType, WillianType, WerewolfType}) {
+                if (event.type_mask & CombatRules::type_bit(type)) {
+                    first = type;
+                    break;
+                }
+            }
+            push(now + period_of(cfg.move_period_ms(first)), SimEventKind::Move, event.type_mask);
+            break;
+        }
+
+        case SimEventKind::FightCheck:
+            collect_fights(world, cfg, batch, current_tick);
+            push(now, SimEventKind::FightResolve);
+            push(now + period_of(cfg.movement_tick_ms), SimEventKind::FightCheck);
+            break;
+
+        case SimEventKind::FightResolve:
+            for (const FightTask& task : batch) {
+                const FightResult result = resolve_fight(arena, rng, task);
+                ++stats.fights;
+                if (result == FightResult::Killed) ++stats.kills;
+            }
+            batch.clear();
+
+            // Конец такта: как в потоке движения - освобождение слотов и кадр
+            ++current_tick;
+            ++stats.ticks;
+            if (cfg.reclaim_period_ticks > 0 && current_tick % cfg.reclaim_period_ticks == 0) {
+                arena.reclaim_dead();
+            }
+            arena.publish_frame(current_tick);
+            break;
+
+        case SimEventKind::Render: {
+            const auto frame = arena.frame();
+            const int seconds_left = static_cast<int>((end_ms - std::min(now, end_ms)) / 1000);
+            render(*frame, seconds_left);
+            ++stats.renders;
+            push(now + period_of(cfg.render_period_ms), SimEventKind::Render);
+            break;
+        }
+    }
+}
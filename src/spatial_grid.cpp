@@ -0,0 +1,194 @@
+#include "../include/spatial_grid.h"
+#include <algorithm>
+#include <utility>
+
+SpatialGrid::SpatialGrid(int width, int height, int cell_size)
+    : cell_size(std::max(1, cell_size)) {
+    width = std::max(1, width);
+    height = std::max(1, height);
+    while (static_cast<std::size_t>((width + this->cell_size - 1) / this->cell_size) *
+               static_cast<std::size_t>((height + this->cell_size - 1) / this->cell_size) > MAX_CELLS) {
+        this->cell_size *= 2;
+    }
+    cols = std::max(1, (width + this->cell_size - 1) / this->cell_size);
+    rows = std::max(1, (height + this->cell_size - 1) / this->cell_size);
+    for (auto& grid : cells) {
+        grid.resize(static_cast<std::size_t>(cols) * static_cast<std::size_t>(rows));
+    }
+}
+
+int SpatialGrid::cell_col(int x) const {
+    // NPC за пределами карты попадают в крайние клетки - оценка расстояния при этом остаётся верной
+    return std::clamp(x / cell_size, 0, cols - 1);
+}
+
+int SpatialGrid::cell_row(int y) const {
+    return std::clamp(y / cell_size, 0, rows - 1);
+}
+
+std::size_t SpatialGrid::cell_of(int x, int y) const {
+    return static_cast<std::size_t>(cell_row(y)) * static_cast<std::size_t>(cols) +
+           static_cast<std::size_t>(cell_col(x));
+}
+
+void SpatialGrid::insert(std::size_t index, int type, int x, int y) {
+    const std::size_t cell = cell_of(x, y);
+    auto& bucket = cells[type][cell];
+    slots[index] = Slot{type, cell, bucket.size()};
+    bucket.push_back(Entry{index, x, y});
+}
+
+template <typename PositionFn>
+void SpatialGrid::fill(const WorldStore& store, std::size_t count, PositionFn position) {
+    for (auto& grid : cells) {
+        for (auto& bucket : grid) bucket.clear();
+    }
+    world = &store;
+    slots.assign(count, Slot{});
+
+    store.for_each_alive(0, count, [&](WorldStore::Id id) {
+        const int type = static_cast<int>(store.type(id));
+        if (type < 0 || type >= TYPE_COUNT) return;
+        auto [x, y] = position(id);
+        insert(id, type, x, y);
+    });
+}
+
+void SpatialGrid::rebuild(const WorldStore& store) {
+    fill(store, store.size(), [&](WorldStore::Id id) { return std::make_pair(store.x(id), store.y(id)); });
+}
+
+void SpatialGrid::rebuild(const WorldStore& store, const std::vector<int>& xs, const std::vector<int>& ys) {
+    const std::size_t count = std::min({store.size(), xs.size(), ys.size()});
+    fill(store, count, [&](WorldStore::Id id) { return std::make_pair(xs[id], ys[id]); });
+}
+
+void SpatialGrid::rebuild(const std::vector<int>& xs, const std::vector<int>& ys,
+                          const std::vector<std::uint8_t>& types) {
+    for (auto& grid : cells) {
+        for (auto& bucket : grid) bucket.clear();
+    }
+    world = nullptr;
+    const std::size_t count = std::min({xs.size(), ys.size(), types.size()});
+    slots.assign(count, Slot{});
+    for (std::size_t i = 0; i < count; ++i) {
+        if (types[i] >= TYPE_COUNT) continue;
+        insert(i, types[i], xs[i], ys[i]);
+    }
+}
+
+void SpatialGrid::remove(std::size_t index) {
+    if (index >= slots.size() || slots[index].type < 0) return;
+    Slot& slot = slots[index];
+    auto& bucket = cells[slot.type][slot.cell];
+
+    // swap-and-pop: порядок внутри клетки не важен
+    if (slot.pos + 1 != bucket.size()) {
+        bucket[slot.pos] = bucket.back();
+        slots[bucket[slot.pos].index].pos = slot.pos;
+    }
+    bucket.pop_back();
+    slot.type = -1;
+}
+
+void SpatialGrid::move(std::size_t index, int new_x, int new_y) {
+    if (index >= slots.size() || slots[index].type < 0) return;
+    Slot& slot = slots[index];
+    const std::size_t new_cell = cell_of(new_x, new_y);
+
+    if (new_cell == slot.cell) {
+        Entry& e = cells[slot.type][slot.cell][slot.pos];
+        e.x = new_x;
+        e.y = new_y;
+        return;
+    }
+
+    const int type = slot.type;
+    remove(index);
+    insert(index, type, new_x, new_y);
+}
+
+void SpatialGrid::within(int x, int y, int radius, unsigned type_mask, std::size_t exclude,
+                         std::vector<std::size_t>& out) const {
+    if (radius < 0 || type_mask == 0) return;
+    const long long r = radius;
+    const long long r_sq = r * r;
+
+    // Диапазон клеток квадрата [x - r, x + r] x [y - r, y + r]
+    auto cell_range = [&](long long lo, long long hi, int count) {
+        const long long first = lo < 0 ? 0 : lo / cell_size;
+        const long long last = hi / cell_size;
+        return std::make_pair(static_cast<int>(std::min<long long>(first, count - 1)),
+                              static_cast<int>(std::min<long long>(std::max<long long>(last, 0), count - 1)));
+    };
+    const auto [col0, col1] = cell_range(static_cast<long long>(x) - r, static_cast<long long>(x) + r, cols);
+    const auto [row0, row1] = cell_range(static_cast<long long>(y) - r, static_cast<long long>(y) + r, rows);
+
+    for (int row = row0; row <= row1; ++row) {
+        for (int col = col0; col <= col1; ++col) {
+            const std::size_t cell = static_cast<std::size_t>(row) * static_cast<std::size_t>(cols) +
+                                     static_cast<std::size_t>(col);
+            for (int type = 0; type < TYPE_COUNT; ++type) {
+                if (!(type_mask & (1u << type))) continue;
+                for (const auto& e : cells[type][cell]) {
+                    if (e.index == exclude) continue;
+                    const long long dx = static_cast<long long>(x) - static_cast<long long>(e.x);
+                    const long long dy = static_cast<long long>(y) - static_cast<long long>(e.y);
+                    if (dx * dx + dy * dy > r_sq) continue;
+                    if (world && !world->is_alive(static_cast<WorldStore::Id>(e.index))) continue;
+                    out.push_back(e.index);
+                }
+            }
+        }
+    }
+}
+
+std::size_t SpatialGrid::nearest(int x, int y, unsigned type_mask, std::size_t exclude) const {
+    const int cx = cell_col(x);
+    const int cy = cell_row(y);
+    const int max_ring = std::max(std::max(cx, cols - 1 - cx), std::max(cy, rows - 1 - cy));
+
+    std::size_t best = npos;
+    long long best_dist_sq = std::numeric_limits<long long>::max();
+
+    auto scan_cell = [&](int col, int row) {
+        const std::size_t cell = static_cast<std::size_t>(row) * static_cast<std::size_t>(cols) +
+                                 static_cast<std::size_t>(col);
+        for (int type = 0; type < TYPE_COUNT; ++type) {
+            if (!(type_mask & (1u << type))) continue;
+            for (const auto& e : cells[type][cell]) {
+                if (e.index == exclude) continue;
+                const long long dx = static_cast<long long>(x) - static_cast<long long>(e.x);
+                const long long dy = static_cast<long long>(y) - static_cast<long long>(e.y);
+                const long long dist_sq = dx * dx + dy * dy;
+                if (dist_sq > best_dist_sq) continue;
+                if (dist_sq == best_dist_sq && e.index > best) continue;
+                // NPC мог погибнуть в потоке боёв после перестройки сетки
+                if (world && !world->is_alive(static_cast<WorldStore::Id>(e.index))) continue;
+                best_dist_sq = dist_sq;
+                best = e.index;
+            }
+        }
+    };
+
+    for (int r = 0; r <= max_ring; ++r) {
+        const int x0 = cx - r, x1 = cx + r;
+        const int y0 = cy - r, y1 = cy + r;
+
+        for (int col = std::max(x0, 0); col <= std::min(x1, cols - 1); ++col) {
+            if (y0 >= 0) scan_cell(col, y0);
+            if (r > 0 && y1 < rows) scan_cell(col, y1);
+        }
+        for (int row = std::max(y0 + 1, 0); row <= std::min(y1 - 1, rows - 1); ++row) {
+            if (x0 >= 0) scan_cell(x0, row);
+            if (r > 0 && x1 < cols) scan_cell(x1, row);
+        }
+
+        // Всё, что лежит за кольцом r, дальше чем r * cell_size
+        if (best != npos) {
+            const long long bound = static_cast<long long>(r) * cell_size;
+            if (best_dist_sq <= bound * bound) break;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,161 @@
+#include "../include/text_loader.h"
+#include "../include/factory.h"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+namespace {
+// Меньше этого кусок не делится: накладные расходы пула съедят выигрыш
+constexpr std::size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+std::string_view next_token(const char*& pos, const char* end) {
+    while (pos < end && is_space(*pos)) ++pos;
+    const char* start = pos;
+    while (pos < end && !is_space(*pos)) ++pos;
+    return std::string_view(start, static_cast<std::size_t>(pos - start));
+}
+
+bool parse_int(std::string_view token, int& value) {
+    const char* last = token.data() + token.size();
+    auto [ptr, ec] = std::from_chars(token.data(), last, value);
+    return ec == std::errc() && ptr == last && !token.empty();
+}
+
+struct ChunkResult {
+    std::vector<std::shared_ptr<NPC>> npcs;
+    std::vector<LoadError> errors; // номера строк внутри куска (с 0)
+    std::size_t lines{0};
+};
+
+void parse_line(const char* pos, const char* end, std::size_t line, ChunkResult& out,
+                const std::shared_ptr<NpcPool>& npc_pool, const RuntimeConfig& config) {
+    const std::string_view type_token = next_token(pos, end);
+    if (type_token.empty()) return; // пустая строка
+
+    const std::string_view x_token = next_token(pos, end);
+    const std::string_view y_token = next_token(pos, end);
+    const std::string_view name_token = next_token(pos, end);
+    if (name_token.empty()) {
+        out.errors.push_back({line, "expected '<Type> <x> <y> <Name>'"});
+        return;
+    }
+    if (!next_token(pos, end).empty()) {
+        out.errors.push_back({line, "unexpected text after name"});
+        return;
+    }
+
+    const NpcType type = Factory::ParseType(type_token);
+    if (type == Unknown) {
+        out.errors.push_back({line, "unknown NPC type '" + std::string(type_token) + "'"});
+        return;
+    }
+    int x = 0;
+    int y = 0;
+    if (!parse_int(x_token, x) || !parse_int(y_token, y)) {
+        out.errors.push_back({line, "invalid coordinates '" + std::string(x_token) + " " + std::string(y_token) + "'"});
+        return;
+    }
+
+    try {
+        out.npcs.push_back(Factory::CreateNPC(type, std::string(name_token), x, y, npc_pool, config));
+    } catch (const std::runtime_error& e) {
+        out.errors.push_back({line, e.what()});
+    }
+}
+
+void parse_chunk(const char* begin, const char* end, ChunkResult& out, const std::shared_ptr<NpcPool>& npc_pool,
+                 const RuntimeConfig& config) {
+    const char* pos = begin;
+    while (pos < end) {
+        const char* eol = std::find(pos, end, '\n');
+        parse_line(pos, eol, out.lines, out, npc_pool, config);
+        ++out.lines;
+        pos = (eol == end) ? end : eol + 1;
+    }
+}
+
+// Сдвигает позицию на начало следующей строки
+const char* align_to_line(const char* pos, const char* begin, const char* end) {
+    if (pos <= begin) return begin;
+    if (pos[-1] == '\n') return pos;
+    const char* eol = std::find(pos, end, '\n');
+    return eol == end ? end : eol + 1;
+}
+} // namespace
+
+TextScenario parse_text_scenario(const char* data, std::size_t size,
+                                 WorkStealingPool* pool,
+                                 const std::shared_ptr<NpcPool>& npc_pool,
+                                 const RuntimeConfig& config) {
+    TextScenario result;
+    const char* end = data + size;
+
+    // Первая строка - количество NPC
+    const char* header_end = std::find(data, end, '\n');
+    const char* pos = data;
+    const std::string_view count_token = next_token(pos, header_end);
+    std::size_t declared = 0;
+    {
+        const char* last = count_token.data() + count_token.size();
+        auto [ptr, ec] = std::from_chars(count_token.data(), last, declared);
+        if (ec != std::errc() || ptr != last || count_token.empty()) {
+            result.errors.push_back({1, "expected NPC count"});
+            return result;
+        }
+    }
+    result.declared_count = declared;
+
+    const char* body = (header_end == end) ? end : header_end + 1;
+    const std::size_t body_size = static_cast<std::size_t>(end - body);
+
+    std::size_t chunk_count = 1;
+    if (pool) {
+        chunk_count = std::max<std::size_t>(1, std::min(pool->size() * 4, body_size / MIN_CHUNK_BYTES));
+    }
+
+    std::vector<const char*> bounds(chunk_count + 1);
+    for (std::size_t i = 0; i <= chunk_count; ++i) {
+        bounds[i] = align_to_line(body + body_size * i / chunk_count, body, end);
+    }
+
+    std::vector<ChunkResult> chunks(chunk_count);
+    auto parse_range = [&](std::size_t from, std::size_t to) {
+        for (std::size_t i = from; i < to; ++i) {
+            parse_chunk(bounds[i], bounds[i + 1], chunks[i], npc_pool, config);
+        }
+    };
+    if (pool && chunk_count > 1) {
+        pool->parallel_for(0, chunk_count, 1, parse_range);
+    } else {
+        parse_range(0, chunk_count);
+    }
+
+    // Склейка в исходном порядке; номера строк пересчитываются в сквозные
+    std::size_t total = 0;
+    for (const auto& chunk : chunks) total += chunk.npcs.size();
+    result.npcs.reserve(std::min(total, declared));
+
+    std::size_t first_line = 2;
+    for (auto& chunk : chunks) {
+        for (auto& npc : chunk.npcs) {
+            if (result.npcs.size() == declared) break;
+            result.npcs.push_back(std::move(npc));
+        }
+        for (auto& error : chunk.errors) {
+            error.line += first_line;
+            result.errors.push_back(std::move(error));
+        }
+        first_line += chunk.lines;
+    }
+
+    if (result.npcs.size() < declared && total < declared) {
+        result.errors.push_back({1, "declared " + std::to_string(declared) + " NPCs, found " + std::to_string(total)});
+    }
+    return result;
+}
@@ -0,0 +1,109 @@
+#include "../include/thread_pool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(std::size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Очередь с индексом threads принадлежит вызывающему потоку parallel_for
+    for (std::size_t i = 0; i <= threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    wake_cv.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+bool WorkStealingPool::try_pop(std::size_t index, Task& task) {
+    Queue& q = *queues[index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::try_steal(std::size_t thief, Task& task) {
+    const std::size_t n = queues.size();
+    for (std::size_t k = 1; k < n; ++k) {
+        Queue& q = *queues[(thief + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::worker_loop(std::size_t index) {
+    while (true) {
+        Task task;
+        if (try_pop(index, task) || try_steal(index, task)) {
+            queued.fetch_sub(1);
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake_cv.wait(lock, [&]() { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() <= 0) return;
+    }
+}
+
+void WorkStealingPool::parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                                    const std::function<void(std::size_t, std::size_t)>& fn) {
+    if (begin >= end) return;
+    grain = std::max<std::size_t>(1, grain);
+
+    const std::size_t chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1 || workers.empty()) {
+        fn(begin, end);
+        return;
+    }
+
+    std::atomic<std::size_t> remaining{chunks};
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        queued.fetch_add(static_cast<long>(chunks));
+    }
+
+    // Куски раскладываются по очередям по кругу, дальше баланс выравнивает кража
+    for (std::size_t c = 0; c < chunks; ++c) {
+        const std::size_t from = begin + c * grain;
+        const std::size_t to = std::min(end, from + grain);
+        Queue& q = *queues[c % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back([&, from, to]() {
+            fn(from, to);
+            // Уменьшение и notify под done_mutex: вызывающий выходит, только взяв его,
+            // поэтому не разрушит done_mutex и done_cv, пока последний кусок их трогает
+            std::lock_guard<std::mutex> done_lock(done_mutex);
+            if (remaining.fetch_sub(1) == 1) done_cv.notify_all();
+        });
+    }
+    wake_cv.notify_all();
+
+    const std::size_t self = queues.size() - 1;
+    Task task;
+    while (remaining.load() > 0 && (try_pop(self, task) || try_steal(self, task))) {
+        queued.fetch_sub(1);
+        task();
+    }
+
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done_cv.wait(lock, [&]() { return remaining.load() == 0; });
+}
@@ -0,0 +1,38 @@
+#include "../include/world_frame.h"
+
+FrameExchange::FrameExchange() {
+    for (auto& frame : frames) {
+        frame = std::make_shared<WorldFrame>();
+    }
+    current.store(frames[0]);
+}
+
+WorldFrame& FrameExchange::begin_write() {
+    const auto published = current.load();
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        // Кроме массива кадр держит только published - значит, он и опубликован
+        if (frames[i] == published || frames[i].use_count() != 1) continue;
+        writing = i;
+        // Пара к освобождению ссылки читателем: его чтения завершились до нашей записи
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return *frames[i];
+    }
+
+    // Читатели держат все кадры: они остаются им, а в массив встаёт новый
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        if (frames[i] == published) continue;
+        frames[i] = std::make_shared<WorldFrame>();
+        writing = i;
+        ++extra;
+        return *frames[i];
+    }
+    return *frames[writing];
+}
+
+void FrameExchange::publish() {
+    current.store(frames[writing]);
+}
+
+std::shared_ptr<const WorldFrame> FrameExchange::latest() const {
+    return current.load();
+}
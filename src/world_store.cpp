@@ -0,0 +1,80 @@
+#include "../include/world_store.h"
+#include <stdexcept>
+
+WorldStore::WorldStore() : chunks(new std::atomic<Chunk*>[MAX_CHUNKS]) {
+    for (std::size_t i = 0; i < MAX_CHUNKS; ++i) {
+        chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+WorldStore::~WorldStore() {
+    for (std::size_t i = 0; i < MAX_CHUNKS; ++i) {
+        delete chunks[i].load(std::memory_order_relaxed);
+    }
+}
+
+WorldStore::Id WorldStore::add(NpcType type, int x, int y, bool alive, std::uint32_t name_id) {
+    if (!free_list.empty()) {
+        const Id id = free_list.back();
+        free_list.pop_back();
+
+        // Счётчик боёв в очередях не сбрасывается: обработчик ещё может
+        // уменьшить его за прежнего владельца слота
+        Chunk* c = chunk(id);
+        const std::size_t i = offset(id);
+        c->x[i].store(x, std::memory_order_relaxed);
+        c->y[i].store(y, std::memory_order_relaxed);
+        c->type[i].store(static_cast<std::uint8_t>(type), std::memory_order_relaxed);
+        c->fight_stamp[i].store(0, std::memory_order_relaxed);
+        c->name[i].store(name_id, std::memory_order_relaxed);
+        if (alive) c->alive[word_of(id)].fetch_or(bit_of(id), std::memory_order_release);
+        return id;
+    }
+
+    const std::size_t id = count.load(std::memory_order_relaxed);
+    const std::size_t chunk_index = id >> CHUNK_BITS;
+    if (chunk_index >= MAX_CHUNKS) {
+        throw std::runtime_error("World store capacity exceeded");
+    }
+
+    Chunk* c = chunks[chunk_index].load(std::memory_order_relaxed);
+    if (!c) {
+        // Value-initialization обнуляет маску живости и поколения
+        c = new Chunk();
+        chunks[chunk_index].store(c, std::memory_order_release);
+    }
+
+    const auto new_id = static_cast<Id>(id);
+    const std::size_t i = offset(new_id);
+    c->x[i].store(x, std::memory_order_relaxed);
+    c->y[i].store(y, std::memory_order_relaxed);
+    c->type[i].store(static_cast<std::uint8_t>(type), std::memory_order_relaxed);
+    c->fight_stamp[i].store(0, std::memory_order_relaxed);
+    c->fights_in_flight[i].store(0, std::memory_order_relaxed);
+    c->name[i].store(name_id, std::memory_order_relaxed);
+    if (alive) {
+        c->alive[word_of(new_id)].fetch_or(bit_of(new_id), std::memory_order_relaxed);
+    } else {
+        c->alive[word_of(new_id)].fetch_and(~bit_of(new_id), std::memory_order_relaxed);
+    }
+
+    // Публикация записи для читателей size()
+    count.store(id + 1, std::memory_order_release);
+    return new_id;
+}
+
+void WorldStore::retire(Id id) {
+    kill(id);
+    chunk(id)->generation[offset(id)].fetch_add(1, std::memory_order_release);
+    free_list.push_back(id);
+}
+
+void WorldStore::clear() {
+    const std::size_t old_count = count.load(std::memory_order_relaxed);
+    count.store(0, std::memory_order_release);
+    free_list.clear();
+    // Handle, выданные до очистки, не должны совпасть с новыми записями в тех же слотах
+    for (std::size_t id = 0; id < old_count; ++id) {
+        chunk(static_cast<Id>(id))->generation[offset(static_cast<Id>(id))].fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+// Счётчик выделений памяти в текущем потоке. Глобальные operator new/delete
+// заменены в alloc_counter.cpp и подключены только к alloc_tests.
+namespace alloc_counter {
+void start();
+// Останавливает подсчёт и возвращает число выделений с момента start()
+std::size_t stop();
+} // namespace alloc_counter
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "alloc_counter.h"
+#include "../include/arena.h"
+#include "../include/event_bus.h"
+#include "../include/file_observer.h"
+#include "../include/kill_event.h"
+
+TEST(KillEventTest, FightThreadPathDoesNotAllocate) {
+    const std::string filename = "test_kill_events.txt";
+    {
+        Arena arena;
+        auto file_obs = std::make_shared<FileObserver>(filename);
+        arena.spawn({NpcSpec{OrkType, "Ork_0", 0, 0}, NpcSpec{WillianType, "Willian_1", 0, 0}});
+        arena.events().subscribe(file_obs, EventFilter::only(EventType::Kill));
+        const WorldStore& world = arena.world();
+
+        // То же, что FightSystem::resolve после успешного броска
+        auto kill = [&]() {
+            EventBus& bus = arena.events();
+            if (!bus.wants(EventType::Kill)) return;
+            bus.publish(KillEvent{arena.names(), world.name(0), world.name(1), 6, 1, world.type(0), world.type(1),
+                                  world.x(1), world.y(1)});
+        };
+        kill(); // прогрев
+
+        alloc_counter::start();
+        for (int i = 0; i < 1000; ++i) kill();
+        EXPECT_EQ(alloc_counter::stop(), 0u);
+
+        file_obs->flush();
+    }
+    std::ifstream fs(filename);
+    std::string line;
+    std::size_t lines = 0;
+    while (std::getline(fs, line)) {
+        EXPECT_EQ(line, "Ork_0 killed Willian_1 (attack=6, defense=1)");
+        ++lines;
+    }
+    EXPECT_EQ(lines, 1001u);
+    fs.close();
+    std::filesystem::remove(filename);
+}
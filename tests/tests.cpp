@@ -9,9 +9,35 @@
 #include "../include/willian.h"
 #include "../include/werewolf.h"
 #include "../include/combat_visitor.h"
+#include "../include/combat_rules.h"
 #include "../include/file_observer.h"
 #include "../include/observer.h"
 #include "../include/arena.h"
+#include "../include/spatial_grid.h"
+#include "../include/movement.h"
+#include "../include/thread_pool.h"
+#include "../include/fight_system.h"
+#include "../include/mpmc_queue.h"
+#include "../include/async_sink.h"
+#include "../include/snapshot_format.h"
+#include "../include/runtime_config.h"
+#include "../include/batch_runner.h"
+#include "../include/renderer.h"
+#include "../include/name_table.h"
+#include "../include/kill_event.h"
+#include "../include/event_bus.h"
+#include "../include/counter_rng.h"
+#include "../include/game.h"
+#include "../include/nearest_kernel.h"
+#include "../include/behavior_scheduler.h"
+#include "../include/sim_engine.h"
+#include "../include/sharded_world.h"
+#include "../include/metrics.h"
+#include <atomic>
+#include <thread>
+#include <random>
+#include <limits>
+#include <cstring>
 
 // ==========================================
 // 1. Тесты Фабрики (Factory Tests) - 8 тестов
@@ -220,37 +246,37 @@ public:
 };
 
 TEST(ObserverTest, SingleObserverNotify) {
-    auto npc = std::make_shared<Ork>(0,0,"O");
+    EventBus bus;
     auto obs = std::make_shared<TestObserver>();
-    npc->attach(obs);
-    npc->notify("Event 1");
+    bus.subscribe(obs);
+    bus.publish(MoveSummaryEvent{1, 3});
     
     ASSERT_EQ(obs->messages.size(), 1);
-    EXPECT_EQ(obs->messages[0], "Event 1");
+    EXPECT_EQ(obs->messages[0], "tick 1: 3 NPC moved");
 }
 
 TEST(ObserverTest, MultipleObservers) {
-    auto npc = std::make_shared<Ork>(0,0,"O");
+    EventBus bus;
     auto obs1 = std::make_shared<TestObserver>();
     auto obs2 = std::make_shared<TestObserver>();
     
-    npc->attach(obs1);
-    npc->attach(obs2);
-    npc->notify("Event 2");
+    bus.subscribe(obs1);
+    bus.subscribe(obs2);
+    bus.publish(MoveSummaryEvent{2, 0});
 
     EXPECT_EQ(obs1->messages.size(), 1);
     EXPECT_EQ(obs2->messages.size(), 1);
 }
 
 TEST(ObserverTest, MultipleNotifications) {
-    auto npc = std::make_shared<Ork>(0,0,"O");
+    EventBus bus;
     auto obs = std::make_shared<TestObserver>();
-    npc->attach(obs);
-    npc->notify("A");
-    npc->notify("B");
+    bus.subscribe(obs);
+    bus.publish(MoveSummaryEvent{1, 0});
+    bus.publish(MoveSummaryEvent{2, 0});
     
     ASSERT_EQ(obs->messages.size(), 2);
-    EXPECT_EQ(obs->messages[1], "B");
+    EXPECT_EQ(obs->messages[1], "tick 2: 0 NPC moved");
 }
 
 TEST(ObserverTest, FileObserverIntegration) {
@@ -339,10 +365,9 @@ TEST(ArenaTest, FightLogicIntegration) {
     auto attacker = std::make_shared<Ork>(0, 0, "Killer");
     auto victim = std::make_shared<Willian>(0, 0, "Victim");
     
-    // Прикрепляем шпиона
+    // Подписываем шпиона
     auto spy = std::make_shared<TestObserver>();
-    attacker->attach(spy);
-    victim->attach(spy);
+    arena.events().subscribe(spy);
     
     arena.add_npc(attacker);
     arena.add_npc(victim);
@@ -365,14 +390,37 @@ TEST(ArenaTest, FightLogicIntegration) {
     EXPECT_TRUE(kill_msg_found);
 }
 
+TEST(ArenaTest, SaveAfterFightSkipsKilled) {
+    // Убитый ещё не освобождён reclaim_dead, но в текстовый файл попасть не должен
+    Arena arena;
+    arena.add_npc(std::make_shared<Ork>(0, 0, "Killer"));
+    arena.add_npc(std::make_shared<Willian>(0, 0, "Victim"));
+    testing::internal::CaptureStdout();
+    arena.fight(5);
+    testing::internal::GetCapturedStdout();
+
+    const std::string fname = "test_after_fight.txt";
+    arena.save(fname);
+    std::size_t survivors = 0;
+    for (const auto& npc : arena.npcs_snapshot()) {
+        if (npc->is_alive()) ++survivors;
+    }
+    ASSERT_LT(survivors, 2u);
+
+    Arena loaded;
+    auto obs = std::make_shared<TestObserver>();
+    loaded.load(fname, obs, obs);
+    EXPECT_EQ(loaded.npcs_snapshot().size(), survivors);
+    std::filesystem::remove(fname);
+}
+
 TEST(ArenaTest, FightNoRange) {
     Arena arena;
     auto n1 = std::make_shared<Ork>(0, 0, "A");
     auto n2 = std::make_shared<Willian>(99, 99, "B");
     
     auto spy = std::make_shared<TestObserver>();
-    n1->attach(spy);
-    n2->attach(spy);
+    arena.events().subscribe(spy, EventFilter::only(EventType::Kill));
     
     arena.add_npc(n1);
     arena.add_npc(n2);
@@ -396,4 +444,2342 @@ TEST(ArenaTest, SnapshotReturnsCopy) {
     snap1.clear();
     auto snap2 = arena.npcs_snapshot();
     EXPECT_EQ(snap2.size(), 2u);
-}
\ No newline at end of file
+}
+
+// ==========================================
+// 6. Тесты пространственного индекса (SpatialGrid)
+// ==========================================
+
+// Полный перебор - эталон, с которым сравнивается сетка
+std::size_t brute_nearest(const WorldStore& world, std::size_t self, unsigned mask) {
+    std::size_t best = SpatialGrid::npos;
+    long long best_dist_sq = std::numeric_limits<long long>::max();
+    const auto self_id = static_cast<WorldStore::Id>(self);
+    for (WorldStore::Id i = 0; i < world.size(); ++i) {
+        if (i == self_id || !world.is_alive(i)) continue;
+        if (!(mask & SpatialGrid::type_bit(world.type(i)))) continue;
+        const long long dx = world.x(self_id) - world.x(i);
+        const long long dy = world.y(self_id) - world.y(i);
+        if (dx * dx + dy * dy < best_dist_sq) {
+            best_dist_sq = dx * dx + dy * dy;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void add_random_npcs(Arena& arena, std::size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> coord(0, 99);
+    std::uniform_int_distribution<int> type(0, 2);
+    const char* types[] = {"Ork", "Willian", "Werewolf"};
+    for (std::size_t i = 0; i < count; ++i) {
+        auto npc = Factory::CreateNPC(types[type(rng)], "N" + std::to_string(i), coord(rng), coord(rng));
+        if (i % 7 == 0) npc->kill();
+        arena.add_npc(npc);
+    }
+}
+
+TEST(SpatialGridTest, MatchesBruteForce) {
+    Arena arena;
+    add_random_npcs(arena, 300, 42);
+    const WorldStore& world = arena.world();
+    SpatialGrid grid(100, 100);
+    grid.rebuild(world);
+
+    const unsigned masks[] = {
+        SpatialGrid::ALL_TYPES,
+        SpatialGrid::type_bit(OrkType),
+        SpatialGrid::type_bit(WillianType),
+        SpatialGrid::type_bit(WerewolfType) | SpatialGrid::type_bit(OrkType),
+    };
+    for (WorldStore::Id i = 0; i < world.size(); ++i) {
+        for (unsigned mask : masks) {
+            EXPECT_EQ(grid.nearest(world.x(i), world.y(i), mask, i), brute_nearest(world, i, mask));
+        }
+    }
+}
+
+TEST(SpatialGridTest, MatchesBruteForceAfterMovesAndKills) {
+    Arena arena;
+    add_random_npcs(arena, 200, 7);
+    WorldStore& world = arena.world();
+    SpatialGrid grid(100, 100, 5);
+    grid.rebuild(world);
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> coord(0, 99);
+    for (WorldStore::Id i = 0; i < world.size(); i += 3) {
+        const int nx = coord(rng), ny = coord(rng);
+        world.set_position(i, nx, ny);
+        grid.move(i, nx, ny);
+    }
+    // Убитые после перестройки NPC должны пропускаться
+    for (WorldStore::Id i = 1; i < world.size(); i += 11) world.kill(i);
+
+    for (WorldStore::Id i = 0; i < world.size(); ++i) {
+        EXPECT_EQ(grid.nearest(world.x(i), world.y(i), SpatialGrid::ALL_TYPES, i),
+                  brute_nearest(world, i, SpatialGrid::ALL_TYPES));
+        EXPECT_EQ(grid.nearest(world.x(i), world.y(i), SpatialGrid::type_bit(WillianType), i),
+                  brute_nearest(world, i, SpatialGrid::type_bit(WillianType)));
+    }
+}
+
+TEST(SpatialGridTest, EmptyMaskReturnsNothing) {
+    Arena arena;
+    add_random_npcs(arena, 20, 3);
+    SpatialGrid grid(100, 100);
+    grid.rebuild(arena.world());
+    EXPECT_EQ(grid.nearest(50, 50, 0u, SpatialGrid::npos), SpatialGrid::npos);
+}
+
+TEST(SpatialGridTest, TieBreakPrefersLowerIndex) {
+    Arena arena;
+    arena.add_npc(std::make_shared<Ork>(50, 50, "Self"));
+    arena.add_npc(std::make_shared<Willian>(60, 50, "Right"));
+    arena.add_npc(std::make_shared<Willian>(40, 50, "Left"));
+    SpatialGrid grid(100, 100);
+    grid.rebuild(arena.world());
+    EXPECT_EQ(grid.nearest(50, 50, SpatialGrid::ALL_TYPES, 0), 1u);
+}
+
+// ==========================================
+// 7. Тесты плотного хранилища (WorldStore)
+// ==========================================
+
+TEST(WorldStoreTest, NpcIsViewOfStoreRecord) {
+    Arena arena;
+    auto npc = std::make_shared<Ork>(3, 4, "Handle");
+    arena.add_npc(npc);
+
+    WorldStore& world = arena.world();
+    ASSERT_EQ(world.size(), 1u);
+    EXPECT_EQ(world.type(0), OrkType);
+
+    world.set_position(0, 7, 8);
+    auto [x, y] = npc->position();
+    EXPECT_EQ(x, 7);
+    EXPECT_EQ(y, 8);
+
+    npc->kill();
+    EXPECT_FALSE(world.is_alive(0));
+    EXPECT_EQ(arena.npc(0).get(), npc.get());
+}
+
+TEST(WorldStoreTest, StateSurvivesArenaDestruction) {
+    auto npc = std::make_shared<Willian>(1, 1, "Survivor");
+    {
+        Arena arena;
+        arena.add_npc(npc);
+        arena.world().set_position(0, 42, 24);
+    }
+    auto [x, y] = npc->position();
+    EXPECT_EQ(x, 42);
+    EXPECT_EQ(y, 24);
+    EXPECT_TRUE(npc->is_alive());
+}
+
+TEST(WorldStoreTest, IdsStableAcrossChunks) {
+    WorldStore world;
+    const std::size_t count = WorldStore::CHUNK_SIZE * 2 + 5;
+    for (std::size_t i = 0; i < count; ++i) {
+        world.add(WerewolfType, static_cast<int>(i % 100), static_cast<int>(i / 100));
+    }
+    ASSERT_EQ(world.size(), count);
+    const auto last = static_cast<WorldStore::Id>(count - 1);
+    EXPECT_EQ(world.x(last), static_cast<int>((count - 1) % 100));
+    EXPECT_EQ(world.y(last), static_cast<int>((count - 1) / 100));
+    EXPECT_LT(WorldStore::bytes_per_npc(), sizeof(NPC));
+}
+
+// ==========================================
+// 8. Тесты параллельного движения (MovementSystem)
+// ==========================================
+
+TEST(ThreadPoolTest, ParallelForCoversRangeOnce) {
+    WorkStealingPool pool(4);
+    std::vector<std::atomic<int>> hits(10000);
+    pool.parallel_for(0, hits.size(), 64, [&](std::size_t from, std::size_t to) {
+        for (std::size_t i = from; i < to; ++i) hits[i].fetch_add(1);
+    });
+    for (const auto& h : hits) {
+        EXPECT_EQ(h.load(), 1);
+    }
+}
+
+TEST(MovementTest, SerialAndParallelBufferedAreEquivalent) {
+    Arena serial_arena;
+    Arena parallel_arena;
+    add_random_npcs(serial_arena, 3000, 2024);
+    add_random_npcs(parallel_arena, 3000, 2024);
+
+    MovementSystem serial(RuntimeConfig{});
+    MovementSystem parallel(RuntimeConfig{});
+    WorkStealingPool pool(4);
+
+    for (int tick = 0; tick < 10; ++tick) {
+        serial.step_buffered(serial_arena.world());
+        parallel.step_buffered(parallel_arena.world(), &pool);
+    }
+
+    const WorldStore& a = serial_arena.world();
+    const WorldStore& b = parallel_arena.world();
+    ASSERT_EQ(a.size(), b.size());
+    for (WorldStore::Id i = 0; i < a.size(); ++i) {
+        ASSERT_EQ(a.x(i), b.x(i)) << "id " << i;
+        ASSERT_EQ(a.y(i), b.y(i)) << "id " << i;
+    }
+}
+
+TEST(MovementTest, BufferedStepReadsPreviousTick) {
+    // Орк и разбойник идут друг к другу: оба должны считать цель по старым позициям
+    Arena arena;
+    arena.add_npc(std::make_shared<Ork>(0, 0, "O"));
+    arena.add_npc(std::make_shared<Willian>(50, 0, "W"));
+
+    MovementSystem movement(RuntimeConfig{});
+    movement.step_buffered(arena.world());
+
+    EXPECT_EQ(arena.world().x(0), 20);
+    EXPECT_EQ(arena.world().x(1), 40);
+}
+
+TEST(MovementTest, DeadNpcDoesNotMove) {
+    Arena arena;
+    arena.add_npc(std::make_shared<Ork>(0, 0, "O"));
+    arena.add_npc(std::make_shared<Willian>(50, 0, "W"));
+    arena.world().kill(0);
+
+    MovementSystem movement(RuntimeConfig{});
+    movement.step_in_place(arena.world());
+
+    EXPECT_EQ(arena.world().x(0), 0);
+}
+
+// ==========================================
+// 9. Тесты обработчиков боёв (FightSystem)
+// ==========================================
+
+TEST(FightSystemTest, CollectFightsMatchesFullScan) {
+    Arena arena;
+    add_random_npcs(arena, 800, 77);
+    const WorldStore& world = arena.world();
+    const RuntimeConfig config;
+
+    std::vector<FightTask> batch;
+    collect_fights(world, config, batch, 5);
+
+    // Эталон - полный перебор пар в порядке id
+    std::vector<std::pair<WorldStore::Id, WorldStore::Id>> expected;
+    world.for_each_alive([&](WorldStore::Id a) {
+        const int dist = config.kill_distance(world.type(a));
+        world.for_each_alive([&](WorldStore::Id d) {
+            if (a == d || !CombatRules::can_kill(world.type(a), world.type(d))) return;
+            const long long dx = world.x(a) - world.x(d);
+            const long long dy = world.y(a) - world.y(d);
+            if (dx * dx + dy * dy <= static_cast<long long>(dist) * dist) expected.emplace_back(a, d);
+        });
+    });
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(batch.size(), expected.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        EXPECT_EQ(batch[i].attacker, expected[i].first);
+        EXPECT_EQ(batch[i].defender, expected[i].second);
+        EXPECT_EQ(batch[i].tick, 5u);
+    }
+}
+
+TEST(FightSystemTest, DuplicatePendingTaskRejected) {
+    Arena arena;
+    arena.add_npc(std::make_shared<Ork>(0, 0, "O"));
+    arena.add_npc(std::make_shared<Willian>(0, 0, "W"));
+
+    FightSystem fights(arena, 2);
+    EXPECT_TRUE(fights.enqueue(0, 1));
+    EXPECT_FALSE(fights.enqueue(0, 1));
+    EXPECT_EQ(fights.enqueue({FightTask{0, 1}, FightTask{1, 0}}), 1u);
+
+    fights.start();
+    fights.wait_idle();
+
+    // После обработки тот же бой снова можно поставить
+    EXPECT_TRUE(fights.enqueue(0, 1));
+    fights.stop();
+}
+
+TEST(FightSystemTest, TasksShardedByDefender) {
+    Arena arena;
+    for (int i = 0; i < 12; ++i) {
+        arena.add_npc(std::make_shared<Werewolf>(0, 0, "W" + std::to_string(i)));
+    }
+
+    FightSystem fights(arena, 3);
+    std::vector<FightTask> batch;
+    for (WorldStore::Id a = 0; a < 12; ++a) {
+        for (WorldStore::Id d = 0; d < 12; ++d) {
+            if (a != d) batch.push_back(FightTask{a, d});
+        }
+    }
+    EXPECT_EQ(fights.enqueue(batch), batch.size());
+    fights.start();
+    fights.wait_idle();
+    fights.stop();
+
+    // Оборотни друг друга не убивают; каждый шард получил бои своих защищающихся
+    const auto stats = fights.stats();
+    ASSERT_EQ(stats.size(), 3u);
+    for (const auto& s : stats) {
+        EXPECT_EQ(s.processed, 4u * 11u);
+        EXPECT_EQ(s.kills, 0u);
+    }
+}
+
+TEST(FightSystemTest, DefenderKilledOnlyOnce) {
+    Arena arena;
+    auto victim = std::make_shared<Willian>(0, 0, "Victim");
+    auto spy = std::make_shared<TestObserver>();
+    arena.events().subscribe(spy, EventFilter::only(EventType::Kill));
+    arena.add_npc(victim);
+    for (int i = 0; i < 200; ++i) {
+        arena.add_npc(std::make_shared<Ork>(0, 0, "O" + std::to_string(i)));
+    }
+
+    FightSystem fights(arena, 4);
+    fights.start();
+    for (WorldStore::Id a = 1; a <= 200; ++a) {
+        fights.enqueue(a, 0);
+    }
+    fights.wait_idle();
+    fights.stop();
+
+    EXPECT_FALSE(victim->is_alive());
+    EXPECT_EQ(spy->messages.size(), 1u);
+}
+
+TEST(FightSystemTest, DropPolicyCountsOverflow) {
+    Arena arena;
+    for (int i = 0; i < 10; ++i) {
+        arena.add_npc(std::make_shared<Werewolf>(0, 0, "W" + std::to_string(i)));
+    }
+
+    // Потоки не запущены, очередь на 2 места: остальное отбрасывается
+    FightSystem fights(arena, 1, 2, FullQueuePolicy::Drop);
+    std::vector<FightTask> batch;
+    for (WorldStore::Id a = 1; a < 10; ++a) batch.push_back(FightTask{a, 0});
+    EXPECT_EQ(fights.enqueue(batch), 2u);
+
+    const auto stats = fights.queue_stats();
+    EXPECT_EQ(stats.enqueued, 2u);
+    EXPECT_EQ(stats.dropped, 7u);
+    EXPECT_EQ(stats.overflows, 7u);
+
+    // Отброшенные атакующие не считаются ждущими и принимаются снова
+    EXPECT_EQ(arena.world().fights_in_flight(9).load(), 0u);
+    EXPECT_EQ(arena.world().fights_in_flight(1).load(), 1u);
+}
+
+TEST(MpmcQueueTest, ConcurrentProducersConsumers) {
+    MpmcQueue<int> queue(64);
+    const int per_producer = 20000;
+    std::atomic<long long> sum{0};
+    std::atomic<int> popped{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; ++p) {
+        threads.emplace_back([&]() {
+            for (int i = 1; i <= per_producer; ++i) {
+                while (!queue.try_push(i)) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&]() {
+            int value;
+            while (popped.load() < 2 * per_producer) {
+                if (queue.try_pop(value)) {
+                    sum.fetch_add(value);
+                    popped.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    const long long expected = 2LL * per_producer * (per_producer + 1) / 2;
+    EXPECT_EQ(sum.load(), expected);
+    int value;
+    EXPECT_FALSE(queue.try_pop(value));
+}
+
+// ==========================================
+// 10. Тесты асинхронного вывода (AsyncSink)
+// ==========================================
+
+TEST(AsyncSinkTest, FlushWritesEverythingInOrder) {
+    std::string out;
+    std::size_t writes = 0;
+    {
+        AsyncSinkOptions options;
+        options.flush_interval = std::chrono::milliseconds(10000);
+        options.line_prefix = "> ";
+        AsyncSink sink([&](const std::string& chunk) {
+            out += chunk;
+            ++writes;
+        }, options);
+
+        for (int i = 0; i < 100; ++i) sink.submit(std::to_string(i));
+        sink.flush();
+
+        std::string expected;
+        for (int i = 0; i < 100; ++i) expected += "> " + std::to_string(i) + "\n";
+        EXPECT_EQ(out, expected);
+    }
+    // Строки собираются в пачки, а не пишутся по одной
+    EXPECT_LT(writes, 100u);
+}
+
+TEST(AsyncSinkTest, DropPolicyWhenWriterIsSlow) {
+    std::mutex gate;
+    std::unique_lock<std::mutex> hold(gate);
+    std::size_t dropped = 0;
+    {
+        AsyncSinkOptions options;
+        options.queue_capacity = 2;
+        options.flush_bytes = 1;
+        options.drop_when_full = true;
+        AsyncSink sink([&](const std::string&) { std::lock_guard<std::mutex> lock(gate); }, options);
+
+        for (int i = 0; i < 10; ++i) sink.submit("line");
+        dropped = sink.dropped();
+        hold.unlock();
+    }
+    // Писатель успевает забрать не больше одной пачки, пока заблокирован
+    EXPECT_GE(dropped, 6u);
+}
+
+TEST(ObserverTest, FileObserverKeepsAllLines) {
+    std::string filename = "test_async_log.txt";
+    {
+        FileObserver file_obs(filename);
+        for (int i = 0; i < 500; ++i) file_obs.update("kill " + std::to_string(i));
+    }
+    std::ifstream fs(filename);
+    std::string line;
+    int count = 0;
+    while (std::getline(fs, line)) ++count;
+    EXPECT_EQ(count, 500);
+    fs.close();
+    std::filesystem::remove(filename);
+}
+
+// ==========================================
+// 11. Тесты бинарного снимка (Arena::save_binary / load_binary)
+// ==========================================
+
+TEST(ArenaTest, SaveAndLoadEmptyBinary) {
+    Arena arena;
+    std::string fname = "test_empty_arena.bin";
+    arena.save_binary(fname);
+
+    Arena arena2;
+    auto obs = std::make_shared<TestObserver>();
+    arena2.load_binary(fname, obs, obs);
+
+    EXPECT_TRUE(std::filesystem::exists(fname));
+    EXPECT_EQ(std::filesystem::file_size(fname), sizeof(Snapshot::Header));
+    EXPECT_TRUE(arena2.npcs_snapshot().empty());
+    std::filesystem::remove(fname);
+}
+
+TEST(ArenaTest, FullCycleSaveLoadBinary) {
+    Arena arena;
+    arena.add_npc(Factory::CreateNPC("Ork", "O1", 10, 10));
+    arena.add_npc(Factory::CreateNPC("Willian", "W1", 20, 20));
+    arena.add_npc(Factory::CreateNPC("Werewolf", "Wolf with long name", 99, 0));
+    arena.npcs_snapshot()[1]->kill();
+
+    std::string fname = "test_full_arena.bin";
+    arena.save_binary(fname);
+
+    Arena arena2;
+    auto obs = std::make_shared<TestObserver>();
+    arena2.load_binary(fname, obs, obs);
+
+    auto loaded = arena2.npcs_snapshot();
+    ASSERT_EQ(loaded.size(), 3u);
+    EXPECT_EQ(loaded[0]->name, "O1");
+    EXPECT_EQ(loaded[0]->type, OrkType);
+    EXPECT_EQ(loaded[1]->type, WillianType);
+    EXPECT_FALSE(loaded[1]->is_alive());
+    EXPECT_EQ(loaded[2]->name, "Wolf with long name");
+    auto [x, y] = loaded[2]->position();
+    EXPECT_EQ(x, 99);
+    EXPECT_EQ(y, 0);
+
+    // Наблюдатель подписан на убийства так же, как при текстовой загрузке (один раз)
+    EXPECT_EQ(arena2.events().subscriptions(), 1u);
+    arena2.events().publish(KillEvent{arena2.names(), 0, 2});
+    EXPECT_EQ(obs->messages, std::vector<std::string>{"O1 killed Wolf with long name"});
+
+    std::filesystem::remove(fname);
+}
+
+TEST(ArenaTest, BinaryMatchesTextRoundTrip) {
+    Arena arena;
+    add_random_npcs(arena, 200, 11);
+    arena.save("test_rt.txt");
+    arena.save_binary("test_rt.bin");
+
+    Arena from_text;
+    Arena from_binary;
+    auto obs = std::make_shared<TestObserver>();
+    from_text.load("test_rt.txt", obs, obs);
+    from_binary.load_binary("test_rt.bin", obs, obs);
+
+    // Текст хранит только живых, бинарный снимок - всех с флагом живости
+    auto a = from_text.npcs_snapshot();
+    auto b = from_binary.npcs_snapshot();
+    b.erase(std::remove_if(b.begin(), b.end(), [](const auto& npc) { return !npc->is_alive(); }), b.end());
+    ASSERT_EQ(a.size(), b.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i]->name, b[i]->name);
+        EXPECT_EQ(a[i]->type, b[i]->type);
+        EXPECT_EQ(a[i]->position(), b[i]->position());
+    }
+    std::filesystem::remove("test_rt.txt");
+    std::filesystem::remove("test_rt.bin");
+}
+
+TEST(ArenaTest, LoadBinaryRejectsBadMagic) {
+    std::string fname = "test_bad.bin";
+    {
+        std::ofstream fs(fname, std::ios::binary);
+        fs << "Ork 10 20 NotBinary\n and some padding to exceed the header";
+    }
+    Arena arena;
+    arena.add_npc(Factory::CreateNPC("Ork", "Keep", 1, 1));
+    auto obs = std::make_shared<TestObserver>();
+
+    testing::internal::CaptureStderr();
+    arena.load_binary(fname, obs, obs);
+    std::string err = testing::internal::GetCapturedStderr();
+
+    EXPECT_NE(err.find("Not an arena snapshot"), std::string::npos);
+    EXPECT_EQ(arena.npcs_snapshot().size(), 1u);
+    std::filesystem::remove(fname);
+}
+
+namespace {
+// Снимок из одной записи с заданными полями заголовка и записи
+void write_binary_snapshot(const std::string& fname, std::uint64_t names_size, const Snapshot::Record& r,
+                           const std::string& names) {
+    Snapshot::Header header{};
+    std::memcpy(header.magic, Snapshot::MAGIC, sizeof(header.magic));
+    header.version = Snapshot::VERSION;
+    header.endian_tag = Snapshot::ENDIAN_TAG;
+    header.record_size = sizeof(Snapshot::Record);
+    header.count = 1;
+    header.names_size = names_size;
+    std::ofstream fs(fname, std::ios::binary | std::ios::trunc);
+    fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fs.write(reinterpret_cast<const char*>(&r), sizeof(r));
+    fs << names;
+}
+} // namespace
+
+TEST(ArenaTest, LoadBinaryRejectsCorruptRecords) {
+    const std::string fname = "test_corrupt.bin";
+    Arena arena;
+    arena.add_npc(Factory::CreateNPC("Ork", "Keep", 1, 1));
+    auto obs = std::make_shared<TestObserver>();
+
+    const auto load_error = [&]() {
+        testing::internal::CaptureStderr();
+        arena.load_binary(fname, obs, obs);
+        return testing::internal::GetCapturedStderr();
+    };
+
+    Snapshot::Record r{};
+    r.x = 1;
+    r.y = 2;
+    r.name_offset = 0;
+    r.name_length = 3;
+    r.type = static_cast<std::uint8_t>(OrkType);
+    r.alive = 1;
+
+    // names_size рядом с 2^64: сумма с размером записей переполнилась бы
+    write_binary_snapshot(fname, std::numeric_limits<std::uint64_t>::max() - 8, r, "Bob");
+    EXPECT_NE(load_error().find("Snapshot is truncated"), std::string::npos);
+
+    Snapshot::Record bad_type = r;
+    bad_type.type = 42;
+    write_binary_snapshot(fname, 3, bad_type, "Bob");
+    EXPECT_NE(load_error().find("unknown NPC type"), std::string::npos);
+
+    Snapshot::Record outside = r;
+    outside.x = -5;
+    write_binary_snapshot(fname, 3, outside, "Bob");
+    EXPECT_NE(load_error().find("outside the map"), std::string::npos);
+
+    EXPECT_EQ(arena.npcs_snapshot().size(), 1u);
+
+    write_binary_snapshot(fname, 3, r, "Bob");
+    EXPECT_TRUE(load_error().empty());
+    ASSERT_EQ(arena.npcs_snapshot().size(), 1u);
+    EXPECT_EQ(arena.npcs_snapshot()[0]->name, "Bob");
+    std::filesystem::remove(fname);
+}
+
+// ==========================================
+// 12. Тесты быстрой текстовой загрузки (Arena::load_fast)
+// ==========================================
+
+TEST(ArenaTest, LoadFastMatchesStreamLoad) {
+    Arena arena;
+    add_random_npcs(arena, 300, 5);
+    arena.save("test_fast.txt");
+
+    Arena slow;
+    Arena fast;
+    auto obs = std::make_shared<TestObserver>();
+    slow.load("test_fast.txt", obs, obs);
+    auto errors = fast.load_fast("test_fast.txt", obs, obs);
+    EXPECT_TRUE(errors.empty());
+
+    auto a = slow.npcs_snapshot();
+    auto b = fast.npcs_snapshot();
+    ASSERT_EQ(a.size(), b.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i]->name, b[i]->name);
+        EXPECT_EQ(a[i]->type, b[i]->type);
+        EXPECT_EQ(a[i]->position(), b[i]->position());
+    }
+    std::filesystem::remove("test_fast.txt");
+}
+
+TEST(ArenaTest, LoadFastReportsMalformedLines) {
+    std::string fname = "test_fast_bad.txt";
+    {
+        std::ofstream fs(fname);
+        fs << "5\n"
+           << "Ork 10 20 Good\n"
+           << "Dragon 1 1 Smaug\n"
+           << "Willian x 5 Rob\n"
+           << "\n"
+           << "Werewolf 500 5 Far\n"
+           << "Werewolf 5 5\n"
+           << "ork 1 2 Last\r\n";
+    }
+    Arena arena;
+    auto obs = std::make_shared<TestObserver>();
+    testing::internal::CaptureStderr();
+    auto errors = arena.load_fast(fname, obs, obs);
+    std::string err = testing::internal::GetCapturedStderr();
+
+    ASSERT_EQ(errors.size(), 5u);
+    EXPECT_EQ(errors[0].line, 3u);
+    EXPECT_EQ(errors[1].line, 4u);
+    EXPECT_EQ(errors[2].line, 6u);
+    EXPECT_EQ(errors[3].line, 7u);
+    // Заявлено 5, а корректных строк только 2
+    EXPECT_EQ(errors[4].line, 1u);
+    EXPECT_NE(err.find(":3: unknown NPC type 'Dragon'"), std::string::npos);
+
+    auto loaded = arena.npcs_snapshot();
+    ASSERT_EQ(loaded.size(), 2u);
+    EXPECT_EQ(loaded[1]->name, "Last");
+    std::filesystem::remove(fname);
+}
+
+TEST(ArenaTest, LoadFastParallelChunksKeepOrderAndLines) {
+    std::string fname = "test_fast_big.txt";
+    const std::size_t rows = 60000;
+    {
+        std::ofstream fs(fname);
+        fs << rows << "\n";
+        for (std::size_t i = 0; i < rows; ++i) {
+            if (i == rows - 10) {
+                fs << "Ork 1 bad Broken_" << i << "\n";
+            } else {
+                fs << "Werewolf " << (i % 100) << " " << (i / 100 % 100) << " Wolf_" << i << "\n";
+            }
+        }
+    }
+
+    Arena arena;
+    WorkStealingPool pool(4);
+    testing::internal::CaptureStderr();
+    auto errors = arena.load_fast(fname, nullptr, nullptr, &pool);
+    testing::internal::GetCapturedStderr();
+
+    ASSERT_EQ(errors.size(), 2u);
+    EXPECT_EQ(errors[0].line, rows - 10 + 2);
+
+    auto loaded = arena.npcs_snapshot();
+    ASSERT_EQ(loaded.size(), rows - 1);
+    EXPECT_EQ(loaded[0]->name, "Wolf_0");
+    EXPECT_EQ(loaded[rows - 11]->name, "Wolf_" + std::to_string(rows - 11));
+    EXPECT_EQ(loaded[rows - 10]->name, "Wolf_" + std::to_string(rows - 9));
+    std::filesystem::remove(fname);
+}
+
+// ==========================================
+// 13. Тесты таблицы боя (CombatRules)
+// ==========================================
+
+TEST(CombatRulesTest, TableMatchesVisitorForAllPairs) {
+    const NpcType types[] = {OrkType, WillianType, WerewolfType};
+    for (NpcType a : types) {
+        for (NpcType d : types) {
+            auto attacker = Factory::CreateNPC(a, "A", 0, 0);
+            auto defender = Factory::CreateNPC(d, "D", 0, 0);
+            EXPECT_EQ(CombatRules::can_kill(a, d), fight(attacker, defender))
+                << "attacker " << a << ", defender " << d;
+        }
+    }
+}
+
+TEST(CombatRulesTest, UnknownTypeKillsNobody) {
+    EXPECT_EQ(CombatRules::prey_mask_for(Unknown), 0u);
+    EXPECT_FALSE(CombatRules::can_kill(OrkType, Unknown));
+}
+
+// ==========================================
+// 14. Тесты конфигурации запуска (RuntimeConfig)
+// ==========================================
+
+TEST(RuntimeConfigTest, DefaultsMatchCompileTimeConfig) {
+    RuntimeConfig config;
+    EXPECT_EQ(config.map_width, GameConfig::MAP_WIDTH);
+    EXPECT_EQ(config.npc_count, GameConfig::INITIAL_NPC_COUNT);
+    EXPECT_EQ(config.kill_distance(WerewolfType), GameConfig::WEREWOLF_KILL_DISTANCE);
+    EXPECT_EQ(config.move_distance(OrkType), GameConfig::ORK_MOVE_DISTANCE);
+}
+
+TEST(RuntimeConfigTest, ParseArgsAndFile) {
+    std::string fname = "test_world.cfg";
+    {
+        std::ofstream fs(fname);
+        fs << "# comment\n\nmap_width = 500\nnpc_count=1000\nparallel_movement=true\n";
+    }
+    const std::string config_arg = "--config=" + fname;
+    const char* argv[] = {"dungeon_editor", config_arg.c_str(), "--map-width", "100000", "--ork-kill-distance=3"};
+
+    RuntimeConfig config;
+    ASSERT_TRUE(config.parse_args(5, argv));
+    EXPECT_TRUE(config.validate());
+    EXPECT_EQ(config.map_width, 100000); // флаг после --config переопределяет файл
+    EXPECT_EQ(config.npc_count, 1000u);
+    EXPECT_TRUE(config.parallel_movement);
+    EXPECT_EQ(config.kill_distance(OrkType), 3);
+    std::filesystem::remove(fname);
+}
+
+TEST(RuntimeConfigTest, RejectsBadInput) {
+    RuntimeConfig config;
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(config.set("no_such_key", "1"));
+    EXPECT_FALSE(config.set("map_width", "12abc"));
+    EXPECT_FALSE(config.set("parallel_movement", "maybe"));
+    const char* argv[] = {"dungeon_editor", "--map-width"};
+    EXPECT_FALSE(config.parse_args(2, argv));
+    config.map_height = 0;
+    EXPECT_FALSE(config.validate());
+
+    // Больше, чем вмещает WorldStore, и отрицательные дистанции
+    RuntimeConfig big;
+    big.npc_count = WorldStore::CAPACITY;
+    EXPECT_TRUE(big.validate());
+    big.npc_count = WorldStore::CAPACITY + 1;
+    EXPECT_FALSE(big.validate());
+    RuntimeConfig negative;
+    negative.werewolf_kill_distance = -1;
+    EXPECT_FALSE(negative.validate());
+    negative.werewolf_kill_distance = 0;
+    negative.ork_move_distance = -3;
+    EXPECT_FALSE(negative.validate());
+
+    // Нулевой период допустим только на виртуальных часах
+    RuntimeConfig busy;
+    busy.movement_tick_ms = 0;
+    EXPECT_FALSE(busy.validate());
+    busy.virtual_time = true;
+    EXPECT_TRUE(busy.validate());
+    busy.virtual_time = false;
+    busy.movement_tick_ms = GameConfig::MOVEMENT_TICK_MS;
+    busy.render_period_ms = 0;
+    EXPECT_FALSE(busy.validate());
+    busy.headless = true;
+    EXPECT_TRUE(busy.validate());
+    testing::internal::GetCapturedStderr();
+    EXPECT_EQ(config.map_width, GameConfig::MAP_WIDTH);
+}
+
+TEST(RuntimeConfigTest, FactoryUsesCurrentMapBounds) {
+    const RuntimeConfig saved = RuntimeConfig::current();
+    RuntimeConfig big;
+    big.map_width = 100000;
+    big.map_height = 100000;
+    RuntimeConfig::set_current(big);
+
+    EXPECT_NO_THROW(Factory::CreateNPC("Ork", "Far", 99999, 50000));
+    EXPECT_THROW(Factory::CreateNPC("Ork", "TooFar", 100000, 0), std::runtime_error);
+
+    RuntimeConfig::set_current(saved);
+    EXPECT_THROW(Factory::CreateNPC("Ork", "Far", 99999, 50000), std::runtime_error);
+}
+
+TEST(RuntimeConfigTest, HugeMapGridStaysBounded) {
+    Arena arena;
+    arena.add_npc(std::make_shared<Ork>(0, 0, "A"));
+    arena.add_npc(std::make_shared<Willian>(99999, 99999, "B"));
+
+    SpatialGrid grid(100000, 100000);
+    grid.rebuild(arena.world());
+    EXPECT_EQ(grid.nearest(0, 0, SpatialGrid::type_bit(WillianType), 0), 1u);
+}
+
+// ==========================================
+// 15. Тесты пакетного режима (BatchRunner)
+// ==========================================
+
+TEST(BatchRunnerTest, ArenaIsDeterministicForSeed) {
+    BatchRunner runner;
+    const ArenaOutcome a = runner.run_arena(123);
+    const ArenaOutcome b = runner.run_arena(123);
+    EXPECT_EQ(a.ticks, b.ticks);
+    EXPECT_EQ(a.settled, b.settled);
+    for (int t = 0; t < CombatRules::TYPE_COUNT; ++t) {
+        EXPECT_EQ(a.survivors[t], b.survivors[t]);
+        EXPECT_EQ(a.kills[t], b.kills[t]);
+    }
+    EXPECT_LE(a.ticks, runner.max_ticks());
+}
+
+TEST(BatchRunnerTest, SummaryDoesNotDependOnThreadCount) {
+    BatchRunner runner;
+    const BatchSummary serial = runner.run(24, 5, 1);
+    const BatchSummary parallel = runner.run(24, 5, 4);
+
+    std::size_t total_kills = 0;
+    for (int t = 0; t < CombatRules::TYPE_COUNT; ++t) {
+        EXPECT_EQ(serial.survivors[t], parallel.survivors[t]);
+        EXPECT_EQ(serial.kills[t], parallel.kills[t]);
+        EXPECT_EQ(serial.survived_in[t], parallel.survived_in[t]);
+        total_kills += serial.kills[t];
+    }
+    EXPECT_EQ(serial.settled, parallel.settled);
+    EXPECT_EQ(serial.settle_ticks_total, parallel.settle_ticks_total);
+
+    // Каждое убийство забирает одного NPC
+    std::size_t total_survivors = 0;
+    for (int t = 0; t < CombatRules::TYPE_COUNT; ++t) total_survivors += serial.survivors[t];
+    EXPECT_EQ(total_survivors + total_kills, 24 * RuntimeConfig::current().npc_count);
+
+    std::ostringstream report;
+    print_summary(report, serial);
+    EXPECT_NE(report.str().find("Werewolf"), std::string::npos);
+}
+
+TEST(BatchRunnerTest, FightsUseSharedResolveFight) {
+    // Один тик вручную: расстановка и броски из тех же потоков CounterRng, бои через resolve_fight
+    RuntimeConfig config = RuntimeConfig::current();
+    config.npc_count = 300;
+    config.batch_max_ticks = 1;
+    const std::uint64_t seed = 77;
+    const CounterRng rng(seed);
+
+    Arena arena(config);
+    std::vector<NpcSpec> specs;
+    for (std::size_t i = 0; i < config.npc_count; ++i) {
+        const int x = rng.uniform(0, config.map_width - 1, CounterRng::Spawn, i, 0);
+        const int y = rng.uniform(0, config.map_height - 1, CounterRng::Spawn, i, 1);
+        const auto type = static_cast<NpcType>(rng.uniform(1, 3, CounterRng::Spawn, i, 2));
+        specs.push_back(NpcSpec{type, "N" + std::to_string(i), x, y});
+    }
+    arena.spawn(specs);
+    MovementSystem movement(config);
+    movement.step_in_place(arena.world());
+    std::vector<FightTask> fights;
+    collect_fights(arena.world(), config, fights, 1);
+    std::size_t kills[CombatRules::TYPE_COUNT]{};
+    for (const auto& task : fights) {
+        if (resolve_fight(arena, rng, task) == FightResult::Killed) {
+            ++kills[static_cast<int>(arena.world().type(task.attacker))];
+        }
+    }
+
+    const ArenaOutcome o = BatchRunner(config).run_arena(seed);
+    ASSERT_EQ(o.ticks, 1u);
+    std::size_t total = 0;
+    for (int t = 0; t < CombatRules::TYPE_COUNT; ++t) {
+        EXPECT_EQ(o.kills[t], kills[t]);
+        total += kills[t];
+    }
+    EXPECT_GT(total, 0u);
+}
+
+TEST(BatchRunnerTest, ArenaWithoutPreySettlesImmediately) {
+    RuntimeConfig config = RuntimeConfig::current();
+    config.npc_count = 0;
+    BatchRunner runner(config);
+    const ArenaOutcome o = runner.run_arena(1);
+    EXPECT_TRUE(o.settled);
+    EXPECT_EQ(o.ticks, 0u);
+}
+
+TEST(BatchRunnerTest, UsesOwnConfigInsteadOfCurrent) {
+    // Карта шире активной конфигурации: расстановка и ходы должны идти по config
+    RuntimeConfig config;
+    config.map_width = 1000;
+    config.map_height = 20;
+    config.npc_count = 200;
+    ASSERT_NE(config.map_width, RuntimeConfig::current().map_width);
+    BatchRunner runner(config);
+    ArenaOutcome o;
+    ASSERT_NO_THROW(o = runner.run_arena(3));
+    EXPECT_GT(o.ticks, 0u);
+
+    // Дистанция хода - из config движения, а не из активной конфигурации
+    config.ork_move_distance = 3;
+    Arena arena(config);
+    arena.spawn({NpcSpec{OrkType, "O", 0, 0}, NpcSpec{WillianType, "W", 900, 0}});
+    MovementSystem movement(config);
+    movement.step_in_place(arena.world());
+    EXPECT_EQ(arena.world().x(0), 3);
+}
+
+// ==========================================
+// 16. Тесты отрисовки (render_map, DiffRenderer)
+// ==========================================
+
+TEST(RendererTest, FullFrameHasHeaderAndMap) {
+    Arena arena;
+    arena.add_npc(std::make_shared<Ork>(3, 0, "A"));
+    RuntimeConfig config;
+
+    const std::string frame = render_map(arena.world(), 5, config);
+    std::istringstream in(frame);
+    std::string header, row;
+    std::getline(in, header);
+    EXPECT_EQ(header, "Seconds left: 5 | Alive: 1");
+    std::getline(in, row);
+    EXPECT_EQ(row.size(), static_cast<std::size_t>(config.map_width));
+    EXPECT_EQ(row[3], 'O');
+    int rows = 1;
+    while (std::getline(in, row)) ++rows;
+    EXPECT_EQ(rows, config.map_height);
+}
+
+TEST(RendererTest, ViewportAndDownsampling) {
+    RuntimeConfig config;
+    config.map_width = 1000;
+    config.map_height = 1000;
+    config.viewport_x = 500;
+    config.viewport_y = 500;
+    config.viewport_width = 200;
+    config.viewport_height = 100;
+    config.render_max_cols = 100;
+    config.render_max_rows = 100;
+
+    const FrameLayout frame = FrameLayout::from(config);
+    EXPECT_EQ(frame.scale, 2);
+    EXPECT_EQ(frame.cols, 100);
+    EXPECT_EQ(frame.rows, 50);
+
+    Arena arena;
+    arena.add_npc(std::make_shared<Werewolf>(10, 10, "Outside"));
+    arena.add_npc(std::make_shared<Werewolf>(503, 501, "Inside"));
+    const std::string text = render_map(arena.world(), 0, config);
+    EXPECT_NE(text.find("Scale: 1:2"), std::string::npos);
+    EXPECT_EQ(std::count(text.begin(), text.end(), 'W'), 1);
+}
+
+TEST(RendererTest, DiffEmitsOnlyChangedCells) {
+    Arena arena;
+    auto ork = std::make_shared<Ork>(10, 20, "A");
+    arena.add_npc(ork);
+    arena.add_npc(std::make_shared<Willian>(50, 50, "B"));
+
+    RuntimeConfig config;
+    DiffRenderer renderer(config);
+    const std::string first = renderer.render(arena.world(), 3);
+    EXPECT_NE(first.find("\x1b[2J"), std::string::npos);
+    EXPECT_EQ(renderer.changed_cells(), static_cast<std::size_t>(config.map_width * config.map_height));
+
+    const std::string idle = renderer.render(arena.world(), 2);
+    EXPECT_EQ(renderer.changed_cells(), 0u);
+    EXPECT_EQ(idle.find('O'), std::string::npos);
+    EXPECT_LT(idle.size(), 64u);
+
+    ork->set_position(11, 20);
+    const std::string moved = renderer.render(arena.world(), 1);
+    EXPECT_EQ(renderer.changed_cells(), 2u);
+    // Старая клетка (строка 20 -> 22-я строка терминала, столбец 11) и соседняя - одним заходом курсора
+    EXPECT_NE(moved.find("\x1b[22;11H.O"), std::string::npos);
+
+    renderer.invalidate();
+    renderer.render(arena.world(), 0);
+    EXPECT_EQ(renderer.changed_cells(), static_cast<std::size_t>(config.map_width * config.map_height));
+}
+
+// ==========================================
+// 17. Тесты раунда боя по сетке (Arena::fight)
+// ==========================================
+
+// Эталон: полный перебор через is_close и CombatVisitor среди живых, в порядке списка
+std::vector<std::string> brute_fight_messages(Arena& arena, int distance) {
+    std::vector<std::string> messages;
+    auto npcs = arena.npcs_snapshot();
+    for (const auto& attacker : npcs) {
+        if (!attacker->is_alive()) continue;
+        for (const auto& defender : npcs) {
+            if (attacker == defender || !defender->is_alive()) continue;
+            if (!attacker->is_close(defender, distance)) continue;
+            if (fight(attacker, defender)) messages.push_back(attacker->name + " killed " + defender->name);
+        }
+    }
+    return messages;
+}
+
+std::size_t alive_members(Arena& arena) {
+    std::size_t alive = 0;
+    for (const auto& npc : arena.npcs_snapshot()) alive += npc->is_alive() ? 1 : 0;
+    return alive;
+}
+
+TEST(ArenaFightTest, MatchesBruteForce) {
+    for (int distance : {0, 5, 10, 30}) {
+        Arena arena;
+        add_random_npcs(arena, 400, 7 + distance);
+        auto spy = std::make_shared<TestObserver>();
+        arena.events().subscribe(spy);
+
+        const std::size_t before = arena.npcs_snapshot().size();
+        const std::size_t alive_before = alive_members(arena);
+        const auto expected = brute_fight_messages(arena, distance);
+        testing::internal::CaptureStdout();
+        arena.fight(distance);
+        testing::internal::GetCapturedStdout();
+
+        EXPECT_EQ(spy->messages, expected) << "distance " << distance;
+        // Из списка удаляются только убитые в этом раунде (каждый один раз)
+        const std::size_t victims = alive_before - alive_members(arena);
+        EXPECT_EQ(arena.npcs_snapshot().size(), before - victims);
+    }
+}
+
+TEST(ArenaFightTest, ParallelMatchesSerial) {
+    Arena serial, parallel;
+    add_random_npcs(serial, 3000, 99);
+    add_random_npcs(parallel, 3000, 99);
+    auto spy_serial = std::make_shared<TestObserver>();
+    auto spy_parallel = std::make_shared<TestObserver>();
+    serial.events().subscribe(spy_serial);
+    parallel.events().subscribe(spy_parallel);
+
+    WorkStealingPool pool(4);
+    testing::internal::CaptureStdout();
+    serial.fight(8);
+    parallel.fight(8, &pool);
+    testing::internal::GetCapturedStdout();
+
+    EXPECT_FALSE(spy_serial->messages.empty());
+    EXPECT_EQ(spy_serial->messages, spy_parallel->messages);
+    EXPECT_EQ(serial.npcs_snapshot().size(), parallel.npcs_snapshot().size());
+}
+
+TEST(ArenaFightTest, MutualKillsBothDieOnce) {
+    Arena arena;
+    auto willian = std::make_shared<Willian>(5, 5, "R");
+    auto werewolf = std::make_shared<Werewolf>(6, 5, "W");
+    auto ork = std::make_shared<Ork>(5, 6, "O");
+    arena.add_npc(willian);
+    arena.add_npc(werewolf);
+    arena.add_npc(ork);
+
+    testing::internal::CaptureStdout();
+    arena.fight(3);
+    const std::string out = testing::internal::GetCapturedStdout();
+
+    // Разбойника убивают и оборотень, и орк - в списке мёртвых он один раз
+    EXPECT_FALSE(willian->is_alive());
+    EXPECT_FALSE(werewolf->is_alive());
+    EXPECT_TRUE(ork->is_alive());
+    ASSERT_EQ(arena.npcs_snapshot().size(), 1u);
+    EXPECT_EQ(arena.npcs_snapshot()[0].get(), ork.get());
+    EXPECT_NE(out.find("survived: 1"), std::string::npos);
+}
+
+// ==========================================
+// 18. Тесты освобождения слотов (поколения, список свободных)
+// ==========================================
+
+TEST(WorldStoreTest, RetiredSlotIsReusedWithNewGeneration) {
+    WorldStore store;
+    const auto a = store.add(OrkType, 1, 1);
+    const auto b = store.add(WillianType, 2, 2);
+    const auto old_handle = store.handle(a);
+
+    store.retire(a);
+    EXPECT_FALSE(store.is_alive(a));
+    EXPECT_FALSE(store.valid(old_handle));
+    EXPECT_EQ(store.free_slots(), 1u);
+
+    const auto c = store.add(WerewolfType, 3, 3);
+    EXPECT_EQ(c, a);
+    EXPECT_EQ(store.size(), 2u);
+    EXPECT_EQ(store.free_slots(), 0u);
+    EXPECT_TRUE(store.is_alive(c));
+    EXPECT_EQ(store.type(c), WerewolfType);
+    EXPECT_TRUE(store.valid(store.handle(c)));
+    EXPECT_FALSE(store.valid(old_handle));
+    EXPECT_TRUE(store.valid(store.handle(b)));
+
+    // После clear старые Handle тоже недействительны
+    const auto before_clear = store.handle(b);
+    store.clear();
+    store.add(OrkType, 0, 0);
+    store.add(OrkType, 0, 0);
+    EXPECT_FALSE(store.valid(before_clear));
+}
+
+TEST(WorldStoreTest, ForEachAliveSkipsDeadAcrossWordsAndChunks) {
+    WorldStore store;
+    const std::size_t count = WorldStore::CHUNK_SIZE + 200;
+    std::vector<WorldStore::Id> expected;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto id = store.add(OrkType, 0, 0);
+        if (i % 7 == 0 || i == WorldStore::CHUNK_SIZE - 1 || i == WorldStore::CHUNK_SIZE) {
+            expected.push_back(id);
+        } else {
+            store.kill(id);
+        }
+    }
+
+    std::vector<WorldStore::Id> seen;
+    store.for_each_alive([&](WorldStore::Id id) { seen.push_back(id); });
+    EXPECT_EQ(seen, expected);
+
+    // Поддиапазон с границами внутри 64-битных слов
+    seen.clear();
+    store.for_each_alive(5, 130, [&](WorldStore::Id id) { seen.push_back(id); });
+    std::vector<WorldStore::Id> sub;
+    for (const auto id : expected) {
+        if (id >= 5 && id < 130) sub.push_back(id);
+    }
+    EXPECT_EQ(seen, sub);
+}
+
+TEST(ArenaReclaimTest, DeadNpcsReleaseSlots) {
+    Arena arena;
+    std::vector<std::shared_ptr<NPC>> npcs;
+    for (int i = 0; i < 10; ++i) {
+        npcs.push_back(std::make_shared<Ork>(i, i, "O" + std::to_string(i)));
+        arena.add_npc(npcs.back());
+    }
+    for (int i = 0; i < 10; i += 2) npcs[i]->kill();
+
+    EXPECT_EQ(arena.reclaim_dead(), 5u);
+    EXPECT_EQ(arena.reclaim_dead(), 0u);
+    EXPECT_EQ(arena.world().free_slots(), 5u);
+    EXPECT_EQ(arena.npcs_snapshot().size(), 5u);
+    EXPECT_FALSE(arena.npc(0));
+    EXPECT_EQ(arena.npc(1).get(), npcs[1].get());
+
+    // Отвязанный NPC сохраняет последнее состояние
+    EXPECT_FALSE(npcs[0]->is_alive());
+    EXPECT_EQ(npcs[0]->position(), std::make_pair(0, 0));
+
+    // Новый NPC занимает освободившийся слот
+    auto fresh = std::make_shared<Werewolf>(50, 50, "fresh");
+    arena.add_npc(fresh);
+    EXPECT_LT(fresh->world_id, 10u);
+    EXPECT_EQ(arena.npc(fresh->world_id).get(), fresh.get());
+    EXPECT_EQ(arena.world().size(), 10u);
+    EXPECT_EQ(arena.npcs_snapshot().size(), 6u);
+}
+
+TEST(ArenaReclaimTest, NpcReadsDuringReclaim) {
+    // Читатель держит объекты NPC, пока reclaim_dead их отвязывает (под TSan - без гонок)
+    Arena arena;
+    add_random_npcs(arena, 2000, 5);
+    const auto npcs = arena.npcs_snapshot();
+    for (std::size_t i = 0; i < npcs.size(); i += 2) npcs[i]->kill();
+
+    std::atomic<bool> started{false};
+    std::atomic<bool> done{false};
+    std::thread reader([&]() {
+        long long sum = 0;
+        while (!done.load()) {
+            for (const auto& npc : npcs) {
+                sum += npc->position().first + (npc->is_alive() ? 1 : 0);
+                started.store(true);
+            }
+        }
+        EXPECT_GE(sum, 0);
+    });
+    while (!started.load()) std::this_thread::yield();
+    EXPECT_GT(arena.reclaim_dead(), 0u);
+    done.store(true);
+    reader.join();
+
+    for (std::size_t i = 0; i < npcs.size(); i += 2) EXPECT_FALSE(npcs[i]->is_alive());
+}
+
+TEST(ArenaReclaimTest, FightSystemDropsTasksForReusedSlot) {
+    Arena arena;
+    auto ork = std::make_shared<Ork>(0, 0, "O");
+    arena.add_npc(ork);
+    std::vector<std::shared_ptr<NPC>> victims;
+    std::vector<FightTask> batch;
+    for (int i = 0; i < 60; ++i) {
+        victims.push_back(std::make_shared<Willian>(0, 0, "W" + std::to_string(i)));
+        arena.add_npc(victims.back());
+        batch.push_back(FightTask{0, static_cast<WorldStore::Id>(i + 1)});
+    }
+
+    FightSystem fights(arena, 2);
+    ASSERT_EQ(fights.enqueue(batch), batch.size());
+
+    // Пока задачи в очереди, слот орка освобождается и достаётся другому орку
+    ork->kill();
+    EXPECT_EQ(arena.reclaim_dead(), 1u);
+    auto other = std::make_shared<Ork>(0, 0, "O2");
+    arena.add_npc(other);
+    ASSERT_EQ(other->world_id, 0u);
+
+    fights.start();
+    fights.wait_idle();
+    fights.stop();
+
+    std::size_t kills = 0;
+    for (const auto& s : fights.stats()) kills += s.kills;
+    EXPECT_EQ(kills, 0u);
+    for (const auto& v : victims) EXPECT_TRUE(v->is_alive());
+}
+
+// ==========================================
+// 19. Тесты пула NPC и пакетного создания
+// ==========================================
+
+TEST(NpcPoolTest, FreedCellIsReused) {
+    auto pool = std::make_shared<NpcPool>();
+    auto first = Factory::CreateNPC(OrkType, "A", 1, 1, pool);
+    EXPECT_EQ(pool->live_objects(), 1u);
+    const NPC* address = first.get();
+    first.reset();
+    EXPECT_EQ(pool->live_objects(), 0u);
+
+    auto second = Factory::CreateNPC(WerewolfType, "B", 2, 2, pool);
+    EXPECT_EQ(second.get(), address);
+    EXPECT_EQ(second->type, WerewolfType);
+    EXPECT_EQ(second->name, "B");
+}
+
+TEST(NpcPoolTest, NpcOutlivesArena) {
+    std::shared_ptr<NPC> survivor;
+    std::weak_ptr<NpcPool> pool;
+    {
+        Arena arena;
+        pool = arena.pool();
+        auto spawned = arena.spawn({NpcSpec{OrkType, "O", 3, 4}, NpcSpec{WillianType, "W", 5, 6}});
+        survivor = spawned[1];
+    }
+    // Пул держат аллокаторы живых NPC
+    ASSERT_FALSE(pool.expired());
+    EXPECT_EQ(pool.lock()->live_objects(), 1u);
+    EXPECT_EQ(survivor->name, "W");
+    EXPECT_EQ(survivor->position(), std::make_pair(5, 6));
+
+    survivor.reset();
+    EXPECT_TRUE(pool.expired());
+}
+
+TEST(NpcPoolTest, BulkCreateValidatesBeforeCreating) {
+    auto pool = std::make_shared<NpcPool>();
+    const std::vector<NpcSpec> specs = {NpcSpec{OrkType, "ok", 0, 0}, NpcSpec{OrkType, "bad", -1, 0}};
+    EXPECT_THROW(Factory::CreateNPCs(specs, pool), std::runtime_error);
+    EXPECT_THROW(Factory::CreateNPCs({NpcSpec{Unknown, "x", 0, 0}}, pool), std::runtime_error);
+    EXPECT_EQ(pool->live_objects(), 0u);
+
+    auto npcs = Factory::CreateNPCs({NpcSpec{OrkType, "O", 1, 2}, NpcSpec{WerewolfType, "W", 3, 4}}, pool);
+    ASSERT_EQ(npcs.size(), 2u);
+    EXPECT_EQ(pool->live_objects(), 2u);
+    EXPECT_NE(dynamic_cast<Ork*>(npcs[0].get()), nullptr);
+    EXPECT_NE(dynamic_cast<Werewolf*>(npcs[1].get()), nullptr);
+}
+
+TEST(NpcPoolTest, SpawnAndLoadAllocateFromArenaPool) {
+    Arena arena;
+    auto spy = std::make_shared<TestObserver>();
+    auto spawned = arena.spawn({NpcSpec{OrkType, "O", 0, 0}, NpcSpec{WillianType, "W", 0, 0}});
+    EXPECT_EQ(arena.npcs_snapshot().size(), 2u);
+    EXPECT_EQ(arena.pool()->live_objects(), 2u);
+    spawned.clear();
+
+    const std::string filename = "test_pool_load.txt";
+    arena.save(filename);
+    arena.load_fast(filename, nullptr, nullptr);
+    std::remove(filename.c_str());
+    // Старые NPC освобождены, загруженные - из того же пула
+    EXPECT_EQ(arena.npcs_snapshot().size(), 2u);
+    EXPECT_EQ(arena.pool()->live_objects(), 2u);
+}
+
+// ==========================================
+// 20. Тесты имён и событий убийства (NameTable, KillEvent)
+// ==========================================
+
+TEST(NameTableTest, InternDeduplicatesAndViewsStayValid) {
+    NameTable table;
+    const auto a = table.intern("Ork_1");
+    const auto b = table.intern("Willian_2");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(table.intern(std::string("Ork_") + "1"), a);
+    const std::string_view first = table.view(a);
+
+    // Много имён и одно длиннее блока - ранее выданные view не сдвигаются
+    for (int i = 0; i < 20000; ++i) table.intern("npc_" + std::to_string(i));
+    const std::string long_name(100000, 'x');
+    const auto long_id = table.intern(long_name);
+
+    EXPECT_EQ(first.data(), table.view(a).data());
+    EXPECT_EQ(first, "Ork_1");
+    EXPECT_EQ(table.view(b), "Willian_2");
+    EXPECT_EQ(table.view(long_id), long_name);
+    EXPECT_EQ(table.size(), 20003u);
+    EXPECT_THROW(table.view(999999), std::out_of_range);
+}
+
+TEST(KillEventTest, FormatsWithAndWithoutRolls) {
+    auto table = std::make_shared<NameTable>();
+    const auto o = table->intern("O");
+    const auto r = table->intern("R");
+    EXPECT_EQ((KillEvent{table, o, r}).to_string(), "O killed R");
+    EXPECT_EQ((KillEvent{table, o, r, 6, 2}).to_string(), "O killed R (attack=6, defense=2)");
+
+    // Наблюдатель без on_kill получает готовую строку
+    EventBus bus;
+    auto spy = std::make_shared<TestObserver>();
+    bus.subscribe(spy);
+    bus.publish(KillEvent{table, o, r, 5, 1});
+    EXPECT_EQ(spy->messages, std::vector<std::string>{"O killed R (attack=5, defense=1)"});
+}
+
+TEST(KillEventTest, SinkFormatsEventsInOrderWithText) {
+    std::string out;
+    {
+        AsyncSink sink([&](const std::string& chunk) { out += chunk; });
+        auto table = std::make_shared<NameTable>();
+        const auto a = table->intern("A");
+        const auto b = table->intern("B");
+        sink.submit("start");
+        sink.submit(KillEvent{table, a, b, 3, 1});
+        sink.submit(KillEvent{table, b, a});
+        sink.flush();
+    }
+    EXPECT_EQ(out, "start\nA killed B (attack=3, defense=1)\nB killed A\n");
+}
+
+TEST(KillEventTest, EventOutlivesArenaReload) {
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "Old", 0, 0}});
+    const KillEvent event{arena.names(), arena.world().name(0), arena.world().name(0)};
+
+    const std::string filename = "test_names_reload.txt";
+    arena.save(filename);
+    arena.load_fast(filename, nullptr, nullptr);
+    std::remove(filename.c_str());
+
+    EXPECT_NE(arena.names(), event.names);
+    EXPECT_EQ(event.to_string(), "Old killed Old");
+}
+
+// ==========================================
+// 21. Тесты шины событий (EventBus)
+// ==========================================
+
+TEST(EventBusTest, WantsReflectsSubscriptions) {
+    EventBus bus;
+    EXPECT_FALSE(bus.wants(EventType::Kill));
+    auto spy = std::make_shared<TestObserver>();
+    const auto kills = bus.subscribe(spy, EventFilter::only(EventType::Kill));
+    EXPECT_TRUE(bus.wants(EventType::Kill));
+    EXPECT_FALSE(bus.wants(EventType::Spawn));
+
+    // Повторная подписка не дублирует доставку
+    EXPECT_EQ(bus.subscribe(spy, EventFilter::only(EventType::Kill)), kills);
+    EXPECT_EQ(bus.subscriptions(), 1u);
+
+    bus.unsubscribe(kills);
+    EXPECT_FALSE(bus.wants(EventType::Kill));
+    EXPECT_EQ(bus.subscriptions(), 0u);
+}
+
+TEST(EventBusTest, FiltersByFactionAndRegion) {
+    EventBus bus;
+    auto table = std::make_shared<NameTable>();
+    const auto o = table->intern("O");
+    const auto r = table->intern("R");
+    const auto w = table->intern("W");
+
+    auto werewolves = std::make_shared<TestObserver>();
+    auto corner = std::make_shared<TestObserver>();
+    bus.subscribe(werewolves, EventFilter::only(EventType::Kill).for_factions(CombatRules::type_bit(WerewolfType)));
+    bus.subscribe(corner, EventFilter().in_region(MapRegion{0, 0, 10, 10}));
+
+    bus.publish(KillEvent{table, o, r, 0, 0, OrkType, WillianType, 5, 5});
+    bus.publish(KillEvent{table, r, w, 0, 0, WillianType, WerewolfType, 50, 50});
+    bus.publish(SpawnEvent{table, w, WerewolfType, 3, 3});
+    bus.publish(MoveSummaryEvent{7, 1});
+
+    EXPECT_EQ(werewolves->messages, std::vector<std::string>{"R killed W"});
+    EXPECT_EQ(corner->messages,
+              (std::vector<std::string>{"O killed R", "W spawned at (3, 3)", "tick 7: 1 NPC moved"}));
+}
+
+TEST(EventBusTest, ArenaPublishesSpawnsAndKills) {
+    Arena arena;
+    auto spy = std::make_shared<TestObserver>();
+    arena.events().subscribe(spy);
+
+    arena.spawn({NpcSpec{OrkType, "O", 1, 1}, NpcSpec{WillianType, "R", 2, 1}});
+    testing::internal::CaptureStdout();
+    arena.fight(5);
+    testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(spy->messages,
+              (std::vector<std::string>{"O spawned at (1, 1)", "R spawned at (2, 1)", "O killed R"}));
+}
+
+TEST(EventBusTest, LoadersSubscribeLoggersToKillsOnly) {
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "O", 1, 1}});
+    const std::string filename = "test_bus_load.txt";
+    arena.save(filename);
+
+    Arena loaded;
+    auto obs = std::make_shared<TestObserver>();
+    loaded.load(filename, obs, obs);
+    loaded.load_fast(filename, obs, obs);
+    std::remove(filename.c_str());
+
+    EXPECT_EQ(loaded.events().subscriptions(), 1u);
+    EXPECT_TRUE(loaded.events().wants(EventType::Kill));
+    EXPECT_FALSE(loaded.events().wants(EventType::Spawn));
+    EXPECT_TRUE(obs->messages.empty());
+}
+
+TEST(EventBusTest, MovementReportsMovedCount) {
+    RuntimeConfig config;
+    Arena serial, buffered;
+    for (Arena* arena : {&serial, &buffered}) {
+        arena->spawn({NpcSpec{OrkType, "O", 0, 0}, NpcSpec{WillianType, "R", 50, 50},
+                      NpcSpec{WerewolfType, "W", 99, 99}});
+        arena->npcs_snapshot()[2]->kill();
+    }
+    MovementSystem a(config);
+    MovementSystem b(config);
+    EXPECT_EQ(a.step_in_place(serial.world()), 2u);
+    EXPECT_EQ(b.step_buffered(buffered.world()), 2u);
+}
+
+// ==========================================
+// 22. Тесты воспроизводимости (CounterRng, --seed)
+// ==========================================
+
+TEST(CounterRngTest, PureFunctionOfKey) {
+    const CounterRng a(42), b(42), c(43);
+    EXPECT_EQ(a.at(CounterRng::Fight, 1, 2, 3), b.at(CounterRng::Fight, 1, 2, 3));
+    EXPECT_NE(a.at(CounterRng::Fight, 1, 2, 3), c.at(CounterRng::Fight, 1, 2, 3));
+    EXPECT_NE(a.at(CounterRng::Fight, 1, 2, 3), a.at(CounterRng::Fight, 1, 3, 2));
+    EXPECT_NE(a.at(CounterRng::Fight, 1), a.at(CounterRng::Spawn, 1));
+}
+
+TEST(CounterRngTest, D6IsRoughlyUniform) {
+    const CounterRng rng(7);
+    std::size_t counts[7]{};
+    constexpr std::size_t rolls = 60000;
+    for (std::size_t i = 0; i < rolls; ++i) {
+        const int r = rng.d6(i / 100, i % 100, i % 37, 0);
+        ASSERT_GE(r, 1);
+        ASSERT_LE(r, 6);
+        ++counts[r];
+    }
+    for (int face = 1; face <= 6; ++face) {
+        EXPECT_NEAR(static_cast<double>(counts[face]), rolls / 6.0, rolls / 6.0 * 0.05);
+    }
+}
+
+namespace {
+// Орки против вильянов парами: у каждого вильяна ровно один противник, орков никто не убивает,
+// поэтому исход зависит только от бросков
+std::vector<bool> run_pair_fights(std::size_t workers, std::uint64_t seed) {
+    constexpr WorldStore::Id pairs = 300;
+    Arena arena;
+    std::vector<NpcSpec> specs;
+    for (WorldStore::Id i = 0; i < pairs; ++i) {
+        specs.push_back(NpcSpec{OrkType, "O" + std::to_string(i), 0, 0});
+        specs.push_back(NpcSpec{WillianType, "R" + std::to_string(i), 0, 0});
+    }
+    arena.spawn(specs);
+
+    FightSystem fights(arena, workers, 1u << 10, FullQueuePolicy::Block, seed);
+    std::vector<FightTask> batch;
+    for (WorldStore::Id i = 0; i < pairs; ++i) {
+        batch.push_back(FightTask{2 * i, 2 * i + 1, 0, 0, 5});
+    }
+    fights.enqueue(batch);
+    fights.start();
+    fights.wait_idle();
+    fights.stop();
+
+    std::vector<bool> alive;
+    for (WorldStore::Id i = 0; i < pairs; ++i) alive.push_back(arena.world().is_alive(2 * i + 1));
+    return alive;
+}
+} // namespace
+
+TEST(CounterRngTest, FightOutcomeIndependentOfWorkerCount) {
+    const auto serial = run_pair_fights(1, 42);
+    EXPECT_EQ(run_pair_fights(4, 42), serial);
+    EXPECT_EQ(run_pair_fights(3, 42), serial);
+    EXPECT_NE(run_pair_fights(4, 43), serial);
+
+    // Атака строго больше защиты: 15 из 36 исходов
+    const auto survivors = static_cast<std::size_t>(std::count(serial.begin(), serial.end(), true));
+    EXPECT_GT(survivors, 120u);
+    EXPECT_LT(survivors, 230u);
+}
+
+TEST(CounterRngTest, SeededSpawnIsReproducible) {
+    RuntimeConfig config;
+    config.seed = 42;
+    auto obs = std::make_shared<TestObserver>();
+
+    Arena first, second;
+    Game(first, obs, obs, config).init_random_npcs(500);
+    Game(second, obs, obs, config).init_random_npcs(500);
+    ASSERT_EQ(first.world().size(), 500u);
+    ASSERT_EQ(second.world().size(), 500u);
+    for (WorldStore::Id id = 0; id < 500; ++id) {
+        EXPECT_EQ(first.world().x(id), second.world().x(id));
+        EXPECT_EQ(first.world().y(id), second.world().y(id));
+        EXPECT_EQ(first.world().type(id), second.world().type(id));
+    }
+
+    // Без зерна выбирается случайное ненулевое
+    config.seed = 0;
+    Arena third;
+    EXPECT_NE(Game(third, obs, obs, config).seed(), 0u);
+}
+
+TEST(CounterRngTest, SeedOption) {
+    RuntimeConfig config;
+    const char* argv[] = {"prog", "--seed", "12345"};
+    ASSERT_TRUE(config.parse_args(3, argv));
+    EXPECT_EQ(config.seed, 12345u);
+    // Зерно 64-битное и там, где size_t 32-битный
+    ASSERT_TRUE(config.set("seed", "18446744073709551615"));
+    EXPECT_EQ(config.seed, std::numeric_limits<std::uint64_t>::max());
+    ASSERT_TRUE(config.set("batch_seed", "18446744073709551615"));
+    EXPECT_EQ(config.batch_seed, std::numeric_limits<std::uint64_t>::max());
+}
+
+// ==========================================
+// 23. Тесты кадров мира (WorldFrame, FrameExchange)
+// ==========================================
+
+TEST(WorldFrameTest, ExchangeReusesFramesWithoutReaders) {
+    FrameExchange exchange;
+    EXPECT_TRUE(exchange.latest()->entries.empty());
+    for (std::uint64_t tick = 1; tick <= 10; ++tick) {
+        WorldFrame& frame = exchange.begin_write();
+        frame.tick = tick;
+        exchange.publish();
+        EXPECT_EQ(exchange.latest()->tick, tick);
+    }
+    EXPECT_EQ(exchange.extra_frames(), 0u);
+}
+
+TEST(WorldFrameTest, HeldFrameIsNotOverwritten) {
+    FrameExchange exchange;
+    exchange.begin_write().tick = 1;
+    exchange.publish();
+    const auto held = exchange.latest();
+
+    exchange.begin_write().tick = 2;
+    exchange.publish();
+    const auto held2 = exchange.latest();
+    // С такта 4 held и held2 держат два кадра, третий опубликован - писатель заводит новый
+    for (std::uint64_t tick = 3; tick <= 6; ++tick) {
+        exchange.begin_write().tick = tick;
+        exchange.publish();
+    }
+    EXPECT_EQ(held->tick, 1u);
+    EXPECT_EQ(held2->tick, 2u);
+    EXPECT_EQ(exchange.latest()->tick, 6u);
+    EXPECT_GT(exchange.extra_frames(), 0u);
+}
+
+TEST(WorldFrameTest, ArenaFrameMatchesWorld) {
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "O", 1, 2}, NpcSpec{WillianType, "R", 3, 4}, NpcSpec{WerewolfType, "W", 5, 6}});
+    arena.world().kill(1);
+    arena.publish_frame(7);
+
+    const auto frame = arena.frame();
+    EXPECT_EQ(frame->tick, 7u);
+    ASSERT_EQ(frame->entries.size(), 3u);
+    EXPECT_EQ(frame->alive_count, 2u);
+    EXPECT_FALSE(frame->entries[1].alive);
+    EXPECT_EQ(frame->entries[2].x, 5);
+    EXPECT_EQ(frame->names->view(frame->entries[2].name), "W");
+
+    RuntimeConfig config;
+    config.map_width = 10;
+    config.map_height = 10;
+    EXPECT_EQ(render_map(*frame, 3, config), render_map(arena.world(), 3, config));
+
+    // Освобождённый слот в кадр не попадает
+    arena.reclaim_dead();
+    arena.publish_frame(8);
+    EXPECT_EQ(arena.frame()->entries.size(), 2u);
+}
+
+TEST(WorldFrameTest, SaveFromFrameIgnoresLaterChanges) {
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "O", 1, 2}, NpcSpec{WillianType, "R", 3, 4}});
+    arena.publish_frame(1);
+    const auto frame = arena.frame();
+    arena.world().set_position(0, 50, 50);
+
+    const std::string text = "test_frame_save.txt";
+    const std::string binary = "test_frame_save.bin";
+    Arena::save(text, *frame);
+    Arena::save_binary(binary, *frame);
+
+    auto obs = std::make_shared<TestObserver>();
+    Arena from_text, from_binary;
+    from_text.load(text, obs, obs);
+    from_binary.load_binary(binary, obs, obs);
+    std::remove(text.c_str());
+    std::remove(binary.c_str());
+
+    for (Arena* loaded : {&from_text, &from_binary}) {
+        auto npcs = loaded->npcs_snapshot();
+        ASSERT_EQ(npcs.size(), 2u);
+        EXPECT_EQ(npcs[0]->position(), std::make_pair(1, 2));
+        EXPECT_EQ(npcs[1]->name, "R");
+        EXPECT_EQ(npcs[1]->type, WillianType);
+    }
+}
+
+TEST(WorldFrameTest, ReadersNeverSeeTornTicks) {
+    Arena arena;
+    std::vector<NpcSpec> specs;
+    for (int i = 0; i < 2000; ++i) specs.push_back(NpcSpec{OrkType, "O" + std::to_string(i), 0, 0});
+    arena.spawn(specs);
+
+    // Писатель за такт ставит всех в (tick, tick); в любом кадре координаты совпадают с его тактом
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        for (int tick = 1; tick <= 300; ++tick) {
+            for (WorldStore::Id id = 0; id < 2000; ++id) arena.world().set_position(id, tick, tick);
+            arena.publish_frame(static_cast<std::uint64_t>(tick));
+        }
+        done.store(true);
+    });
+
+    std::size_t torn = 0;
+    std::size_t frames = 0;
+    while (!done.load()) {
+        const auto frame = arena.frame();
+        ++frames;
+        for (const auto& e : frame->entries) {
+            if (frame->tick > 0 && (e.x != static_cast<int>(frame->tick) || e.y != e.x)) ++torn;
+        }
+    }
+    writer.join();
+    EXPECT_EQ(torn, 0u);
+    EXPECT_GT(frames, 0u);
+    EXPECT_EQ(arena.frame()->tick, 300u);
+}
+
+// ==========================================
+// 24. Тесты ядра поиска ближайшего (NearestKernel)
+// ==========================================
+
+namespace {
+std::vector<NearestKernel::Isa> available_isas() {
+    std::vector<NearestKernel::Isa> isas{NearestKernel::Isa::Scalar};
+    if (NearestKernel::supported(NearestKernel::Isa::Avx2)) isas.push_back(NearestKernel::Isa::Avx2);
+    return isas;
+}
+} // namespace
+
+TEST(NearestKernelTest, MaskExcludeAndTies) {
+    // Индексы 1 и 9 на одинаковом расстоянии; 9 попадает в векторную часть, 1 - тоже
+    const std::vector<std::int32_t> xs{50, 3, 0, 0, 0, 0, 0, 0, 0, -3, 2};
+    const std::vector<std::int32_t> ys{50, 0, 0, 9, 9, 9, 9, 9, 9, 0, 0};
+    std::vector<std::uint8_t> types(xs.size(), WillianType);
+    types[2] = NearestKernel::NO_TYPE; // мёртвый в самой точке запроса
+    types[10] = OrkType;
+
+    for (const auto isa : available_isas()) {
+        SCOPED_TRACE(NearestKernel::name(isa));
+        const auto n = xs.size();
+        const unsigned willians = CombatRules::type_bit(WillianType);
+        EXPECT_EQ(NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), n, 0, 0, willians), 1u);
+        EXPECT_EQ(NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), n, 0, 0, willians, 1), 9u);
+        EXPECT_EQ(NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), n, 0, 0, CombatRules::ALL_TYPES), 10u);
+        EXPECT_EQ(NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), n, 0, 0,
+                                         CombatRules::type_bit(WerewolfType)),
+                  NearestKernel::npos);
+        EXPECT_EQ(NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), 0, 0, 0, willians),
+                  NearestKernel::npos);
+    }
+}
+
+TEST(NearestKernelTest, MatchesScalarAndGridOnRandomScenes) {
+    std::mt19937 rng(11);
+    for (const int size : {7, 64, 1000}) {
+        Arena arena;
+        std::uniform_int_distribution<int> coord(0, 99);
+        std::uniform_int_distribution<int> type(1, 3);
+        std::vector<NpcSpec> specs;
+        for (int i = 0; i < size; ++i) {
+            specs.push_back(NpcSpec{static_cast<NpcType>(type(rng)), "N" + std::to_string(i), coord(rng), coord(rng)});
+        }
+        arena.spawn(specs);
+        WorldStore& world = arena.world();
+        for (WorldStore::Id id = 0; id < world.size(); id += 5) world.kill(id);
+
+        SpatialGrid grid(100, 100);
+        grid.rebuild(world);
+        std::vector<std::int32_t> xs(world.size()), ys(world.size());
+        std::vector<std::uint8_t> types(world.size(), NearestKernel::NO_TYPE);
+        world.for_each_alive([&](WorldStore::Id id) {
+            xs[id] = world.x(id);
+            ys[id] = world.y(id);
+            types[id] = static_cast<std::uint8_t>(world.type(id));
+        });
+
+        for (int q = 0; q < 200; ++q) {
+            const int x = coord(rng), y = coord(rng);
+            const unsigned mask = static_cast<unsigned>(q % 16);
+            const std::size_t exclude = static_cast<std::size_t>(q) % world.size();
+            const std::size_t expected = grid.nearest(x, y, mask, exclude);
+            for (const auto isa : available_isas()) {
+                const std::size_t got =
+                    NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), xs.size(), x, y, mask, exclude);
+                EXPECT_EQ(got == NearestKernel::npos ? SpatialGrid::npos : got, expected)
+                    << NearestKernel::name(isa) << " size " << size << " query " << q;
+            }
+        }
+    }
+}
+
+TEST(NearestKernelTest, LargeCoordinatesDoNotOverflow) {
+    const int far = 1 << 30;
+    const std::vector<std::int32_t> xs{far, -far + 1, 0, 0, 0, 0, 0, 0, 5};
+    const std::vector<std::int32_t> ys{far, -far + 1, far, far, far, far, far, far, -far};
+    const std::vector<std::uint8_t> types(xs.size(), OrkType);
+    for (const auto isa : available_isas()) {
+        EXPECT_EQ(NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), xs.size(), far - 1, far - 1,
+                                         CombatRules::ALL_TYPES),
+                  0u)
+            << NearestKernel::name(isa);
+        EXPECT_EQ(NearestKernel::nearest(isa, xs.data(), ys.data(), types.data(), xs.size(), 0, -far,
+                                         CombatRules::ALL_TYPES),
+                  8u)
+            << NearestKernel::name(isa);
+    }
+}
+
+TEST(NearestKernelTest, SelectFallsBackToScalar) {
+    const auto initial = NearestKernel::active();
+    EXPECT_TRUE(NearestKernel::select(NearestKernel::Isa::Scalar));
+    EXPECT_EQ(NearestKernel::active(), NearestKernel::Isa::Scalar);
+    EXPECT_EQ(NearestKernel::select(NearestKernel::Isa::Avx2), NearestKernel::supported(NearestKernel::Isa::Avx2));
+    NearestKernel::select(initial);
+}
+
+TEST(NearestKernelTest, ScanMovementMatchesGrid) {
+    RuntimeConfig config;
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> coord(0, 99);
+    std::uniform_int_distribution<int> type(1, 3);
+    std::vector<NpcSpec> specs;
+    for (int i = 0; i < 300; ++i) {
+        specs.push_back(NpcSpec{static_cast<NpcType>(type(rng)), "N" + std::to_string(i), coord(rng), coord(rng)});
+    }
+
+    for (const bool buffered : {false, true}) {
+        Arena grid_arena, scan_arena;
+        grid_arena.spawn(specs);
+        scan_arena.spawn(specs);
+        MovementSystem by_grid(config);
+        MovementSystem by_scan(config, MovementSystem::Search::Scan);
+        for (int tick = 0; tick < 5; ++tick) {
+            if (buffered) {
+                EXPECT_EQ(by_scan.step_buffered(scan_arena.world()), by_grid.step_buffered(grid_arena.world()));
+            } else {
+                EXPECT_EQ(by_scan.step_in_place(scan_arena.world()), by_grid.step_in_place(grid_arena.world()));
+            }
+        }
+        for (WorldStore::Id id = 0; id < 300; ++id) {
+            ASSERT_EQ(scan_arena.world().x(id), grid_arena.world().x(id)) << "buffered " << buffered;
+            ASSERT_EQ(scan_arena.world().y(id), grid_arena.world().y(id)) << "buffered " << buffered;
+        }
+    }
+}
+
+// ==========================================
+// 25. Тесты планировщика поведений (BehaviorScheduler)
+// ==========================================
+
+namespace {
+Behavior sleeper(BehaviorScheduler&, WorldStore::Handle, std::uint64_t ticks, int* steps) {
+    while (true) {
+        ++*steps;
+        co_await sleep_ticks(ticks);
+    }
+}
+
+Behavior ambusher(BehaviorScheduler&, WorldStore::Handle, WorldStore::Handle target, std::vector<int>* log) {
+    while (true) {
+        const bool in_range = co_await wait_in_range(target, 2);
+        log->push_back(in_range ? 1 : 0);
+        if (!in_range) co_return;
+    }
+}
+
+Behavior duelist(BehaviorScheduler&, WorldStore::Handle, WorldStore::Handle target, std::vector<FightResult>* log) {
+    while (true) {
+        const FightResult result = co_await fight(target);
+        log->push_back(result);
+        if (result != FightResult::Survived) co_return;
+    }
+}
+} // namespace
+
+TEST(BehaviorSchedulerTest, SleepingBehaviorsAreNotResumed) {
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "O", 0, 0}, NpcSpec{OrkType, "P", 5, 5}});
+    RuntimeConfig config;
+    BehaviorScheduler scheduler(arena, config);
+
+    int fast = 0, slow = 0;
+    scheduler.spawn(0, [&](BehaviorScheduler& s, WorldStore::Handle h) { return sleeper(s, h, 1, &fast); });
+    scheduler.spawn(1, [&](BehaviorScheduler& s, WorldStore::Handle h) { return sleeper(s, h, 10, &slow); });
+
+    std::size_t resumed = 0;
+    for (int t = 0; t < 30; ++t) resumed += scheduler.tick().resumed;
+    EXPECT_EQ(fast, 30);
+    EXPECT_EQ(slow, 3); // такты 1, 11, 21
+    EXPECT_EQ(resumed, 33u);
+    EXPECT_EQ(scheduler.active(), 2u);
+    EXPECT_EQ(scheduler.sleeping(), 2u);
+}
+
+TEST(BehaviorSchedulerTest, WaitInRangeWakesOnApproachAndOnDeath) {
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "O", 0, 0}, NpcSpec{WillianType, "R", 50, 50}});
+    RuntimeConfig config;
+    BehaviorScheduler scheduler(arena, config);
+    std::vector<int> log;
+    const auto target = arena.world().handle(1);
+    scheduler.spawn(0, [&](BehaviorScheduler& s, WorldStore::Handle h) { return ambusher(s, h, target, &log); });
+
+    scheduler.tick(); // первый шаг: встаёт в ожидание
+    for (int t = 0; t < 5; ++t) EXPECT_EQ(scheduler.tick().resumed, 0u);
+    EXPECT_EQ(scheduler.waiting(), 1u);
+
+    arena.world().set_position(1, 1, 1);
+    EXPECT_EQ(scheduler.tick().resumed, 1u);
+    EXPECT_EQ(log, std::vector<int>{1});
+
+    arena.world().set_position(1, 60, 60);
+    scheduler.tick();
+    arena.world().kill(1);
+    const auto stats = scheduler.tick();
+    EXPECT_EQ(stats.resumed, 1u);
+    EXPECT_EQ(stats.finished, 1u);
+    EXPECT_EQ(log, (std::vector<int>{1, 0}));
+    EXPECT_EQ(scheduler.active(), 0u);
+}
+
+TEST(BehaviorSchedulerTest, FightResultIsDeliveredAndSeeded) {
+    auto run = [](std::uint64_t seed) {
+        Arena arena;
+        arena.spawn({NpcSpec{OrkType, "O", 0, 0}, NpcSpec{WillianType, "R", 1, 0}});
+        auto spy = std::make_shared<TestObserver>();
+        arena.events().subscribe(spy, EventFilter::only(EventType::Kill));
+        RuntimeConfig config;
+        BehaviorScheduler scheduler(arena, config, seed);
+        std::vector<FightResult> log;
+        const auto target = arena.world().handle(1);
+        scheduler.spawn(0, [&](BehaviorScheduler& s, WorldStore::Handle h) { return duelist(s, h, target, &log); });
+        for (int t = 0; t < 200 && scheduler.active() > 0; ++t) scheduler.tick();
+
+        EXPECT_FALSE(log.empty());
+        EXPECT_EQ(log.back(), FightResult::Killed);
+        EXPECT_FALSE(arena.world().is_alive(1));
+        EXPECT_EQ(spy->messages.size(), 1u);
+        EXPECT_EQ(spy->messages.front().rfind("O killed R (attack=", 0), 0u);
+        return log.size();
+    };
+    EXPECT_EQ(run(3), run(3));
+}
+
+TEST(BehaviorSchedulerTest, DeadNpcBehaviorIsDestroyedWithoutResuming) {
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "O", 0, 0}});
+    RuntimeConfig config;
+    BehaviorScheduler scheduler(arena, config);
+    int steps = 0;
+    scheduler.spawn(0, [&](BehaviorScheduler& s, WorldStore::Handle h) { return sleeper(s, h, 3, &steps); });
+    scheduler.tick();
+    arena.world().kill(0);
+    arena.reclaim_dead();
+    for (int t = 0; t < 5; ++t) scheduler.tick();
+    EXPECT_EQ(steps, 1);
+    EXPECT_EQ(scheduler.active(), 0u);
+}
+
+TEST(BehaviorSchedulerTest, HuntIsIndependentOfPool) {
+    RuntimeConfig config;
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<int> coord(0, 99);
+    std::uniform_int_distribution<int> type(1, 3);
+    std::vector<NpcSpec> specs;
+    for (int i = 0; i < 400; ++i) {
+        specs.push_back(NpcSpec{static_cast<NpcType>(type(rng)), "N" + std::to_string(i), coord(rng), coord(rng)});
+    }
+
+    Arena serial, parallel;
+    serial.spawn(specs);
+    parallel.spawn(specs);
+    BehaviorScheduler a(serial, config, 17), b(parallel, config, 17);
+    a.spawn_all(hunt);
+    b.spawn_all(hunt);
+    WorkStealingPool pool(4);
+    std::size_t kills = 0;
+    for (int t = 0; t < 60; ++t) {
+        const auto sa = a.tick();
+        const auto sb = b.tick(&pool);
+        EXPECT_EQ(sa.resumed, sb.resumed);
+        EXPECT_EQ(sa.kills, sb.kills);
+        kills += sa.kills;
+    }
+    EXPECT_GT(kills, 0u);
+    for (WorldStore::Id id = 0; id < 400; ++id) {
+        ASSERT_EQ(serial.world().is_alive(id), parallel.world().is_alive(id));
+        ASSERT_EQ(serial.world().x(id), parallel.world().x(id));
+        ASSERT_EQ(serial.world().y(id), parallel.world().y(id));
+    }
+}
+
+TEST(BehaviorSchedulerTest, LoneNpcBacksOff) {
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "O", 10, 10}});
+    RuntimeConfig config;
+    BehaviorScheduler scheduler(arena, config);
+    scheduler.spawn_all(hunt);
+    std::size_t resumed = 0;
+    for (int t = 0; t < 100; ++t) resumed += scheduler.tick().resumed;
+    // 1, 2, 4, 8, 16, 16, ... вместо 100 пробуждений
+    EXPECT_LT(resumed, 12u);
+}
+
+// ==========================================
+// 26. Тесты движка на виртуальных часах (SimEngine)
+// ==========================================
+
+namespace {
+std::vector<NpcSpec> random_specs(std::size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> coord(0, 99);
+    std::uniform_int_distribution<int> type(1, 3);
+    std::vector<NpcSpec> specs;
+    for (std::size_t i = 0; i < count; ++i) {
+        specs.push_back(NpcSpec{static_cast<NpcType>(type(rng)), "N" + std::to_string(i), coord(rng), coord(rng)});
+    }
+    return specs;
+}
+} // namespace
+
+TEST(SimEngineTest, HeadlessRunCoversWholeGameQuickly) {
+    Arena arena;
+    arena.spawn(random_specs(200, 3));
+    RuntimeConfig config; // 30 секунд, такт 200 мс
+    SimEngine engine(arena, config, 5);
+    const SimStats stats = engine.run(SimEngine::Pacing::Headless);
+
+    EXPECT_EQ(stats.virtual_ms, 30000u);
+    EXPECT_EQ(stats.ticks, 150u); // 0, 200, ..., 29800
+    EXPECT_EQ(stats.moves, 150u);
+    EXPECT_EQ(stats.renders, 0u);
+    EXPECT_GT(stats.kills, 0u);
+    EXPECT_LT(stats.wall_seconds, 10.0);
+    EXPECT_EQ(arena.frame()->tick, 150u);
+    EXPECT_EQ(engine.now_ms(), 30000u);
+}
+
+TEST(SimEngineTest, SameSeedGivesSameGame) {
+    RuntimeConfig config;
+    config.duration_seconds = 10;
+    const auto specs = random_specs(300, 4);
+    Arena a, b;
+    a.spawn(specs);
+    b.spawn(specs);
+    SimEngine ea(a, config, 11), eb(b, config, 11);
+    const SimStats sa = ea.run();
+    const SimStats sb = eb.run();
+
+    EXPECT_EQ(sa.events, sb.events);
+    EXPECT_EQ(sa.fights, sb.fights);
+    EXPECT_EQ(sa.kills, sb.kills);
+    for (WorldStore::Id id = 0; id < 300; ++id) {
+        ASSERT_EQ(a.world().is_alive(id), b.world().is_alive(id));
+        ASSERT_EQ(a.world().x(id), b.world().x(id));
+        ASSERT_EQ(a.world().y(id), b.world().y(id));
+    }
+}
+
+TEST(SimEngineTest, PerTypeMovePeriods) {
+    RuntimeConfig config;
+    config.duration_seconds = 2;
+    config.ork_move_period_ms = 100;
+    config.willian_move_period_ms = 1000;
+    config.werewolf_move_period_ms = 1000;
+    EXPECT_EQ(config.move_period_ms(OrkType), 100);
+    EXPECT_EQ(config.move_period_ms(WillianType), 1000);
+
+    Arena arena;
+    arena.spawn({NpcSpec{OrkType, "O", 0, 0}, NpcSpec{WillianType, "R", 99, 99}, NpcSpec{WerewolfType, "W", 0, 99}});
+    SimEngine engine(arena, config);
+    const SimStats stats = engine.run();
+    // Орк: 0, 100, ..., 1900; разбойник и оборотень одним проходом: 0, 1000
+    EXPECT_EQ(stats.moves, 22u);
+    EXPECT_EQ(stats.ticks, 10u);
+
+    // Без своих периодов все ходят раз в movement_tick_ms одним проходом
+    RuntimeConfig defaults;
+    EXPECT_EQ(defaults.move_period_ms(WerewolfType), defaults.movement_tick_ms);
+    RuntimeConfig parsed;
+    ASSERT_TRUE(parsed.set("werewolf-move-period-ms", "50"));
+    EXPECT_EQ(parsed.move_period_ms(WerewolfType), 50);
+    EXPECT_FALSE(parsed.set("ork_move_period_ms", "fast"));
+}
+
+TEST(SimEngineTest, RenderEventsCountDown) {
+    RuntimeConfig config;
+    config.duration_seconds = 3;
+    Arena arena;
+    arena.spawn(random_specs(50, 6));
+    SimEngine engine(arena, config, 2);
+    std::vector<int> seconds;
+    std::vector<std::uint64_t> ticks;
+    engine.on_render([&](const WorldFrame& frame, int seconds_left) {
+        seconds.push_back(seconds_left);
+        ticks.push_back(frame.tick);
+    });
+    const SimStats stats = engine.run();
+
+    EXPECT_EQ(stats.renders, 3u);
+    EXPECT_EQ(seconds, (std::vector<int>{3, 2, 1}));
+    // Кадр на время t уже включает такт, закрытый в t (бои раньше отрисовки)
+    EXPECT_EQ(ticks, (std::vector<std::uint64_t>{1, 6, 11}));
+}
+
+TEST(SimEngineTest, RealTimePacingFollowsWallClock) {
+    RuntimeConfig config;
+    config.duration_seconds = 1;
+    Arena arena;
+    arena.spawn(random_specs(20, 7));
+    SimEngine engine(arena, config, 3);
+    const SimStats stats = engine.run(SimEngine::Pacing::RealTime);
+    EXPECT_EQ(stats.virtual_ms, 1000u);
+    EXPECT_GE(stats.wall_seconds, 0.95);
+}
+
+// ==========================================
+// 27. Тесты мира, разрезанного на шарды (ShardedWorld)
+// ==========================================
+
+namespace {
+std::vector<NpcSpec> wide_specs(std::size_t count, unsigned seed, int width, int height) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> xs(0, width - 1);
+    std::uniform_int_distribution<int> ys(0, height - 1);
+    std::uniform_int_distribution<int> type(1, 3);
+    std::vector<NpcSpec> specs;
+    for (std::size_t i = 0; i < count; ++i) {
+        specs.push_back(NpcSpec{static_cast<NpcType>(type(rng)), "N" + std::to_string(i), xs(rng), ys(rng)});
+    }
+    return specs;
+}
+
+std::size_t alive_count(const WorldStore& world) {
+    std::size_t alive = 0;
+    world.for_each_alive([&](WorldStore::Id) { ++alive; });
+    return alive;
+}
+
+RuntimeConfig wide_config() {
+    RuntimeConfig config;
+    config.map_width = 400;
+    config.map_height = 100;
+    return config;
+}
+
+} // namespace
+
+TEST(ShardedWorldTest, MovementMatchesBufferedPass) {
+    RuntimeConfig config = wide_config();
+    config.ork_kill_distance = config.willian_kill_distance = config.werewolf_kill_distance = 0;
+    const auto specs = wide_specs(300, 21, config.map_width, config.map_height);
+
+    for (const int ghost : {0, 1}) { // 1 - почти без призраков, цели ищутся по всем шардам
+        Arena reference(config), sharded(config);
+        reference.spawn(specs);
+        sharded.spawn(specs);
+        MovementSystem movement(config);
+        ShardedWorld world(sharded, config, 4, ghost);
+        ASSERT_EQ(world.shard_count(), 4u);
+
+        std::size_t migrated = 0, fallbacks = 0;
+        for (int t = 0; t < 20; ++t) {
+            const std::size_t moved = movement.step_buffered(reference.world());
+            const ShardTickStats stats = world.tick();
+            EXPECT_EQ(stats.moved, moved);
+            EXPECT_EQ(stats.fights, 0u);
+            migrated += stats.migrated;
+            fallbacks += stats.fallbacks;
+        }
+        EXPECT_GT(migrated, 0u);
+        if (ghost == 1) {
+            EXPECT_GT(fallbacks, 0u);
+        }
+        for (WorldStore::Id id = 0; id < 300; ++id) {
+            ASSERT_EQ(reference.world().x(id), sharded.world().x(id)) << "ghost " << ghost << ", id " << id;
+            ASSERT_EQ(reference.world().y(id), sharded.world().y(id)) << "ghost " << ghost << ", id " << id;
+        }
+    }
+}
+
+TEST(ShardedWorldTest, FightsAcrossBordersMatchFullScan) {
+    const RuntimeConfig config = wide_config();
+    const auto specs = wide_specs(600, 22, config.map_width, config.map_height);
+    Arena reference(config), sharded(config);
+    reference.spawn(specs);
+    sharded.spawn(specs);
+
+    MovementSystem movement(config);
+    movement.step_buffered(reference.world());
+    std::vector<FightTask> batch;
+    collect_fights(reference.world(), config, batch);
+    ASSERT_FALSE(batch.empty());
+
+    ShardedWorld world(sharded, config, 8);
+    EXPECT_EQ(world.tick().fights, batch.size());
+}
+
+TEST(ShardedWorldTest, OutcomeDoesNotDependOnShardCount) {
+    const RuntimeConfig config = wide_config();
+    const auto specs = wide_specs(800, 23, config.map_width, config.map_height);
+
+    auto run = [&](std::size_t shards, std::size_t& kills) {
+        auto arena = std::make_unique<Arena>(config);
+        arena->spawn(specs);
+        ShardedWorld world(*arena, config, shards, 0, 99);
+        kills = 0;
+        for (int t = 0; t < 25; ++t) kills += world.tick().kills;
+
+        std::size_t owned = 0;
+        for (std::size_t s = 0; s < world.shard_count(); ++s) owned += world.owned(s);
+        EXPECT_EQ(owned, alive_count(arena->world()));
+        return arena;
+    };
+
+    std::size_t kills1 = 0, kills3 = 0, kills7 = 0;
+    const auto one = run(1, kills1);
+    const auto three = run(3, kills3);
+    const auto seven = run(7, kills7);
+    EXPECT_GT(kills1, 0u);
+    EXPECT_EQ(kills1, kills3);
+    EXPECT_EQ(kills1, kills7);
+    for (WorldStore::Id id = 0; id < 800; ++id) {
+        ASSERT_EQ(one->world().is_alive(id), three->world().is_alive(id));
+        ASSERT_EQ(one->world().is_alive(id), seven->world().is_alive(id));
+        ASSERT_EQ(one->world().x(id), seven->world().x(id));
+        ASSERT_EQ(one->world().y(id), seven->world().y(id));
+    }
+}
+
+TEST(ShardedWorldTest, ShardBoundsAndConfig) {
+    const RuntimeConfig config = wide_config();
+    Arena arena;
+    ShardedWorld world(arena, config, 3, 0);
+    EXPECT_EQ(world.shard_of(0), 0u);
+    EXPECT_EQ(world.shard_of(399), 2u);
+    EXPECT_EQ(world.shard_of(-5), 0u);
+    EXPECT_EQ(world.ghost_width(), 40); // ход оборотня
+    EXPECT_EQ(world.tick().moved, 0u);
+
+    ShardedWorld narrow(arena, config, 2, 3);
+    EXPECT_EQ(narrow.ghost_width(), 10); // не уже дистанции удара
+
+    RuntimeConfig parsed;
+    ASSERT_TRUE(parsed.set("shards", "4"));
+    ASSERT_TRUE(parsed.set("shard-ghost-width", "12"));
+    EXPECT_EQ(parsed.shards, 4u);
+    EXPECT_EQ(parsed.shard_ghost_width, 12);
+    parsed.behavior_coroutines = true;
+    EXPECT_FALSE(parsed.validate());
+}
+
+// ==========================================
+// 28. Тесты метрик (MetricsRegistry)
+// ==========================================
+
+TEST(MetricsTest, HistogramBucketsAndQuantiles) {
+    MetricHistogram h;
+    h.observe(0);
+    h.observe(1);
+    h.observe(5);   // [4, 8)
+    h.observe(7);
+    h.observe(1000); // [512, 1024)
+    EXPECT_EQ(h.count(), 5u);
+    EXPECT_EQ(h.sum(), 1013u);
+    EXPECT_EQ(h.bucket(0), 1u);
+    EXPECT_EQ(h.bucket(1), 1u);
+    EXPECT_EQ(h.bucket(3), 2u);
+    EXPECT_EQ(h.bucket(10), 1u);
+    EXPECT_EQ(MetricHistogram::upper_bound(3), 7u);
+    EXPECT_EQ(h.quantile(0.0), 0u);
+    EXPECT_EQ(h.quantile(0.5), 7u);
+    EXPECT_EQ(h.quantile(1.0), 1023u);
+
+    // Огромные значения попадают в последнюю корзину
+    h.observe(std::numeric_limits<std::uint64_t>::max() / 2);
+    EXPECT_EQ(h.bucket(MetricHistogram::BUCKETS - 1), 1u);
+    EXPECT_EQ(MetricHistogram().quantile(0.99), 0u);
+}
+
+TEST(MetricsTest, PrometheusTextFormat) {
+    MetricsRegistry registry;
+    registry.counter("requests_total", "Requests").add(3);
+    registry.gauge("depth{sink=\"file\"}", "Depth").set(7);
+    registry.gauge("depth{sink=\"console\"}", "Depth").set(2);
+    MetricHistogram& h = registry.histogram("latency_seconds", "Latency", MetricHistogram::NANOSECONDS);
+    h.observe(3);
+    h.observe(1000);
+
+    // Повторная регистрация отдаёт ту же метрику, другой тип - ошибка
+    EXPECT_EQ(&registry.counter("requests_total", "Requests"), &registry.counter("requests_total", "x"));
+    EXPECT_THROW(registry.gauge("requests_total", "Requests"), std::runtime_error);
+
+    std::ostringstream out;
+    registry.write_prometheus(out);
+    const std::string text = out.str();
+    EXPECT_NE(text.find("# TYPE requests_total counter\nrequests_total 3\n"), std::string::npos);
+    EXPECT_NE(text.find("depth{sink=\"file\"} 7\n"), std::string::npos);
+    EXPECT_NE(text.find("depth{sink=\"console\"} 2\n"), std::string::npos);
+    // HELP и TYPE - один раз на семейство
+    EXPECT_EQ(text.find("# TYPE depth gauge"), text.rfind("# TYPE depth gauge"));
+    EXPECT_NE(text.find("latency_seconds_bucket{le=\"3e-09\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{le=\"1.023e-06\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_count 2\n"), std::string::npos);
+    EXPECT_EQ(text.find("le=\"2.047e-06\""), std::string::npos); // пустой хвост не печатается
+}
+
+TEST(MetricsTest, DumpReplacesFile) {
+    const std::string filename = "test_metrics.prom";
+    MetricsRegistry registry;
+    MetricCounter& c = registry.counter("ticks_total", "Ticks");
+    c.add();
+    ASSERT_TRUE(registry.dump(filename));
+    c.add(4);
+    ASSERT_TRUE(registry.dump(filename));
+
+    std::ifstream fs(filename);
+    const std::string text((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+    fs.close();
+    EXPECT_NE(text.find("ticks_total 5\n"), std::string::npos);
+    EXPECT_FALSE(std::filesystem::exists(filename + ".tmp"));
+    std::filesystem::remove(filename);
+
+    EXPECT_FALSE(registry.dump("no_such_dir/metrics.prom"));
+}
+
+TEST(MetricsTest, ArenaAndFightSystemInstruments) {
+    MetricsRegistry registry;
+    Arena arena;
+    arena.set_metrics(&registry);
+    arena.add_npc(std::make_shared<Willian>(0, 0, "Victim"));
+    for (int i = 0; i < 200; ++i) {
+        arena.add_npc(std::make_shared<Ork>(0, 0, "O" + std::to_string(i)));
+    }
+
+    FightSystem fights(arena, 2);
+    fights.set_metrics(&registry);
+    fights.start();
+    for (WorldStore::Id a = 1; a <= 200; ++a) {
+        fights.enqueue(a, 0);
+    }
+    fights.wait_idle();
+    fights.stop();
+    arena.reclaim_dead();
+    arena.publish_frame(1);
+
+    std::size_t processed = 0;
+    for (const auto& s : fights.stats()) processed += s.processed;
+    EXPECT_EQ(registry.counter("arena_npcs_added_total", "").value(), 201u);
+    EXPECT_EQ(registry.counter("arena_kills_total", "").value(), 1u);
+    EXPECT_EQ(registry.counter("arena_slots_reclaimed_total", "").value(), 1u);
+    EXPECT_EQ(registry.gauge("arena_alive_npcs", "").value(), 200);
+    EXPECT_EQ(registry.histogram("arena_reclaim_seconds", "").count(), 1u);
+    EXPECT_EQ(registry.histogram("fight_lag_seconds", "").count(), processed);
+    EXPECT_EQ(registry.histogram("fight_queue_depth", "").count(), 200u);
+
+    // Без реестра арена ничего не считает
+    arena.set_metrics(nullptr);
+    arena.publish_frame(2);
+    EXPECT_EQ(registry.histogram("arena_frame_publish_seconds", "").count(), 1u);
+}
+
+TEST(MetricsTest, SinkMetricsAndConfig) {
+    MetricsRegistry registry;
+    const std::string filename = "test_metrics_sink.txt";
+    {
+        FileObserver file_obs(filename);
+        file_obs.set_metrics(&registry);
+        for (int i = 0; i < 10; ++i) file_obs.update("kill " + std::to_string(i));
+        file_obs.flush();
+        file_obs.set_metrics(nullptr);
+    }
+    std::filesystem::remove(filename);
+    EXPECT_EQ(registry.counter("log_sink_lines_total{sink=\"file\"}", "").value(), 10u);
+    EXPECT_EQ(registry.counter("log_sink_dropped_total{sink=\"file\"}", "").value(), 0u);
+    EXPECT_GE(registry.histogram("log_sink_write_seconds{sink=\"file\"}", "").count(), 1u);
+
+    RuntimeConfig config;
+    EXPECT_FALSE(config.metrics);
+    ASSERT_TRUE(config.set("metrics", "true"));
+    ASSERT_TRUE(config.set("metrics-period-ms", "250"));
+    ASSERT_TRUE(config.set("metrics_file", " out/run.prom "));
+    EXPECT_TRUE(config.metrics);
+    EXPECT_EQ(config.metrics_period_ms, 250);
+    EXPECT_EQ(config.metrics_file, "out/run.prom");
+    EXPECT_FALSE(config.set("metrics_file", ""));
+    config.metrics_period_ms = 0;
+    EXPECT_FALSE(config.validate());
+}